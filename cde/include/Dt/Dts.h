@@ -113,6 +113,21 @@ extern char *DtDtsDataToDataType(
 extern char *DtDtsFileToDataType(
 		const char		*filepath);
 
+/*
+ * Types count files at once, using several threads.  stat_buffs may be
+ * NULL or hold a stat buffer for each file.  The data type names are
+ * stored in buffer and datatypes[i] is set to point to them; the
+ * number of files typed before buffer ran out is returned, the
+ * datatypes entries of the remaining files are set to NULL.
+ */
+extern int DtDtsDataToDataTypeBatch(
+		const int		count,
+		const char		**filepaths,
+		const struct stat	*stat_buffs,
+		char			**datatypes,
+		char			*buffer,
+		const int		buffer_size);
+
 extern char *DtDtsFileToAttributeValue(
 		const char		*filepath,
 		const char		*attr);
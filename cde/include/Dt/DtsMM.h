@@ -34,6 +34,7 @@
 #define DT_DTS_MM_H
 
 #include <stdio.h>
+#include <sys/stat.h>
 #include <Dt/DtShmDb.h>
 #include <X11/Intrinsic.h>
 #include "Dt/DbReader.h"
@@ -72,8 +73,12 @@ typedef	struct
 	DtDtsMMIndexOffset	files_count;		/* number of loaded files */
 	DtDtsMMIndexOffset	files_offset;		/* index to list of loaded files */
 	DtDtsMMIndexOffset	mtimes_offset;	/* index to modified times of files */
+	unsigned int		search_magic;	/* DtDtsMM_SEARCH_MAGIC */
+	unsigned int		search_hash;	/* _DtDtsMMSearchHash() of builder */
 } DtDtsMMHeader;
 
+#define	DtDtsMM_SEARCH_MAGIC	0x44545331	/* "DTS1" */
+
 /* one set of attribute/pair */
 typedef	struct
 {
@@ -122,6 +127,19 @@ int			_DtDtsMMCreateDb(DtDirPaths *dirs, const char *CacheFile, int override);
 int			_DtDtsMMCreateFile(DtDirPaths *dirs, const char *CacheFile);
 char *			_DtDtsMMCacheName(int);
 int			_DtDtsMMapDB(const char *CacheFile);
+unsigned int		_DtDtsMMDbVersion(void);
+unsigned int		_DtDtsMMSearchHash(void);
+
+/* DtsCache.c: data type results cache */
+int			_DtDtsCacheOpen(void);
+void			_DtDtsCacheClose(void);
+char *			_DtDtsCacheLookup(const char *path,
+				const char *link_name, const char *opt_name,
+				const struct stat *stat_buff, int link_stat);
+void			_DtDtsCacheStore(const char *path,
+				const char *link_name, const char *opt_name,
+				const struct stat *stat_buff, int link_stat,
+				const char *datatype);
 
 const char *		_DtDtsMMBosonToString(DtShmBoson boson);
 DtShmBoson		_DtDtsMMStringToBoson(const char *string);
@@ -296,6 +296,7 @@ typedef struct _DtHelpGlobSearchStuff
         char *            rawWordStr;		/* word as taken from srchWord */
         char *            normWordStr;		/* normalized word str */
         char *            localeWordStr;	/* after iconv() of NormWordStr */
+        struct _DtHelpSrchMatcherRec * matcher;	/* localeWordStr, compiled */
         wchar_t           wordFieldFirstChar;
         short             wordFieldLen;
         short             statusLineUsage;
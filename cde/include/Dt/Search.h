@@ -201,6 +201,17 @@ typedef struct {
 }	DtSrHitword;
 
 
+/****************************************/
+/*					*/
+/*		 DtSrSession		*/
+/*					*/
+/****************************************/
+/* Opaque per caller state of the api: stems and search type
+ * of the last search, last cleartext and hitwords returned.
+ */
+typedef struct _DtSrSession DtSrSession;
+
+
 /************************************************/
 /*						*/
 /*		   Functions			*/
@@ -281,5 +292,20 @@ extern int	DtSearchHighlight (
 			char		*stems,
 			int		stemcount);
 
+/* Api calls, including the message and result list calls,
+ * are serialized on one engine lock, so any thread may call
+ * them; searches still run one at a time.  The message list
+ * is shared by all threads.  Threads that must not see each
+ * other's stems, cleartext and hitwords each set a session
+ * of their own.
+ */
+extern DtSrSession
+		*DtSearchOpenSession (void);
+extern void	DtSearchCloseSession (DtSrSession *session);
+extern DtSrSession
+		*DtSearchSetSession (DtSrSession *session);
+
+extern void	DtSearchCacheStats (long *hits, long *misses, int *pages);
+
 /********************** Search.h ***********************/
 #endif  /* _Search_h */
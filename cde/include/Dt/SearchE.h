@@ -562,6 +562,7 @@ extern int	shm_id;
 
 extern int	OE_bmhtab_strlen [DtSrMAX_STEMCOUNT];
 extern size_t	OE_bmhtables [DtSrMAX_STEMCOUNT] [MAX_BMHTAB];
+extern long	OE_cache_kbytes;	/* vista page cache budget */
 extern int	OE_dbn;
 extern int	OE_enable_markdel;
 extern int	OE_enable_usernotes;
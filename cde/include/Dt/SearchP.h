@@ -458,6 +458,7 @@ struct or_hwordrec {
 #define EXT_CANDI	".can"	/* candidate dictionary words format */
 #define EXT_CONFIG	".ocf"	/* standard opera configuration file */
 #define EXT_DTBS	".d99"	/* inverted index file for dbase addrs */
+#define EXT_WORDPOS	".d96"	/* word positions of d99 addrs */
 #define EXT_FZKEY	".fzk"	/* output of all opera text anal pgms */
 #define EXT_HANDEL	".han"  /* standard handel profile file format */
 #define EXT_HUFFCODE	".huf"  /* huffman encode tree (from HUFFCODE) */
@@ -578,6 +579,7 @@ extern void swab_objrec (struct or_objrec *rec,  SWABDIR direction);
 #define ORD_NOMARKDEL	(1L<<8)   /* permanently disables mark-for-deletion */
 #define ORD_NONOTES	(1L<<9)   /* permanently disables user notes */
 #define ORD_WIDECHAR	(1L<<10)  /* text is multibyte or wide chars */
+#define ORD_SORTEDD99	(1L<<11)  /* d99 addrs of every word ascend by rec# */
 
 #define ORO_DELETE	(1L<<0)	  /* obj is marked for deletion */
 #define ORO_OLDNOTES	(1L<<1)	  /* obj has old style usernotes in misc rec */
@@ -689,6 +691,24 @@ typedef struct {
     }	PARG;
 
 
+/************************************************/
+/*						*/
+/*		     WORDPOS			*/
+/*						*/
+/************************************************/
+/* Read only memory map of a word positions (d96) file,
+ * the optional offsets of every word and stem in every
+ * record of the d99 built by dtsrindex.  See wordpos.c.
+ */
+#define WORDPOS_MAGIC	0x44393601	/* "D96" version 1 */
+typedef struct {
+    char	*map;		/* whole file, NULL if not open */
+    size_t	maplen;
+    DtSrUINT32	wordcount;
+    DtSrUINT32	*dir;		/* sorted word directory */
+    }	WORDPOS;
+
+
 /********************************************************/
 /*							*/
 /*			  DBLK				*/
@@ -780,6 +800,8 @@ extern int	latin_charmap[];	/* langmap.c */
 
 
 /*------------------------ FUNCTION PROTOTYPES ------------------------*/
+extern void	aa_api_lock (void);	/* dtsrapi.c */
+extern void	aa_api_unlock (void);	/* dtsrapi.c */
 extern void	add_free_space(FREE_SPACE_STR *del_rec, FILE_HEADER *flh);
 extern void	append_ext (char *buffer, int buflen,
 		    char *fname, char *fext);
@@ -806,6 +828,7 @@ extern char	*bmstrstr (
 			UCHAR	*pattern,
 			size_t	patlen);
 extern int	clean_wrap (char *string, int linelen);
+extern void	close_wordpos (WORDPOS *wp);
 extern LLIST	*cutnode_llist (LLIST *node, LLIST **llistp);
 extern void	(*dberr_exit)(int exitcode);   /* defaults to exit() */
 extern void	delete_whitespace (char *linebuf);
@@ -814,6 +837,11 @@ extern int	endstroke (int c);
 extern  void    put_new_word(struct or_hwordrec *recbuf, int vistano);
 extern FREE_SPACE_STR
 		*find_free_space (DtSrINT32 req_size, FILE_HEADER *flh);
+extern DtSrUINT32
+		*find_wordpos (WORDPOS *wp, char *word);
+extern DtSrINT32
+		find_wordpos_rec (DtSrUINT32 *block, DtSrINT32 recno,
+			DtSrUINT32 **posns);
 extern void	free_llist (LLIST **llhead);
 extern int	fread_d99_header (FILE_HEADER *flh, FILE *fp);
 extern int	fwrite_d99_header (FILE_HEADER *flh, FILE *fp);
@@ -848,6 +876,7 @@ extern int	objdate_in_range (DtSrObjdate recdate,
 			DtSrObjdate date1, DtSrObjdate date2);
 extern int	offline_kbhit (void);
 extern int	open_dblk (DBLK **dblist, int numpages, int debugging);
+extern int	open_wordpos (WORDPOS *wp, char *fname);
 extern LLIST	*pop_llist (LLIST **llistp);
 extern void	print_dbrec (char *dbname, struct or_dbrec *dbrec);
 extern int	quit_escape(void);
@@ -869,6 +898,8 @@ extern void	toggle_insert (void);
 extern void	unload_custom_language (DBLK *dblk);
 extern void	unload_language (DBLK *dblk);
 extern void	vista_abort (char *location);
+extern DtSrINT32
+		wordpos_size (DtSrUINT32 *block);
 extern char	*vista_msg (char *location);
 
 /************************ SearchP.h ********************************/
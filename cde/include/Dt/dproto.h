@@ -26,6 +26,7 @@
  *
  *   FUNCTIONS: Pi
  *		d_alloc
+ *		d_cachestats
  *		d_calloc
  *		d_cmstat
  *		d_cmtype
@@ -111,6 +112,7 @@
  *		d_rerdcurr
  *		d_retries
  *		d_set_dberr
+ *		d_setcache
  *		d_setdb
  *		d_setfiles
  *		d_setfree
@@ -161,6 +163,8 @@
 
 int d_setfiles(int);				/* dio.c */
 int d_setpages(int, int);			/* dio.c */
+int d_setcache(long);				/* dio.c */
+int d_cachestats(long *, long *, int *);	/* dio.c */
 int d_trbound(void);				/* trlog.c */
 int d_trlog(int, int, const char *, int); 
 								/* trlog.c */
@@ -128,6 +128,34 @@ typedef	struct	_dtCvSearchData {
 	_DtCvDspLine	*lst;	/* pointer to the text line list    */
 } _DtCvSearchData;
 
+/*
+ * a measured run of text, see _DtCvGetStringWidth()
+ */
+typedef	struct	_dtCvWidthCache {
+	const void	*string;	/* the run, inside its segment   */
+	_DtCvPointer	 font_ptr;
+	int		 byte_len;
+	_DtCvValue	 wc;
+	_DtCvUnit	 width;
+} _DtCvWidthCache;
+
+/*
+ * where a line of a string segment breaks for a given room,
+ * see _DtCvProcessStringSegment()
+ */
+typedef	struct	_dtCvBreakCache {
+	_DtCvSegmentI	*seg;		/* the segment being broken      */
+	unsigned int	 start;		/* where the line starts in it   */
+	_DtCvUnit	 work_width;	/* the room left on the line     */
+	int		 lst_hyper;	/* link in effect at the start   */
+	unsigned int	 end_start;	/* where the next line starts    */
+	int		 str_len;	/* bytes that fit, with space    */
+	_DtCvUnit	 txt_width;	/* their width                   */
+	_DtCvUnit	 space_size;	/* the trailing space, if any    */
+	int		 ret_start;	/* the break that did not fit    */
+	int		 ret_count;
+} _DtCvBreakCache;
+
 typedef	struct _dtCanvasStruct {
 	int		error;
 	long		txt_cnt;	/* maximum used in txt_list	*/
@@ -173,6 +201,10 @@ typedef	struct _dtCanvasStruct {
 	_DtCvSearchData		*searchs;
 	_DtCvUnit		*pg_breaks;
 	_DtCvVirtualInfo	 virt_functions;
+	_DtCvWidthCache		*width_cache;	/* widths of the text runs
+						   of element_lst measured */
+	_DtCvBreakCache		*break_cache;	/* line breaks found in
+						   element_lst              */
 
 } _DtCanvasStruct;
 
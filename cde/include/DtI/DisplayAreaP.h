@@ -123,6 +123,20 @@ typedef	struct	_DtHelpDAfontInfo {
 	long		def_idx;	/* The default index                 */
 } DtHelpDAFontInfo;
 
+/*
+ * Formatted topic kept by a display area, see _DtHelpFormatTopic()
+ */
+typedef	struct	_dtHelpTopicCache {
+	char		*vol_name;	/* the volume the topic is from      */
+	char		*id_str;	/* the location id asked for         */
+	char		*locale;	/* LC_CTYPE when formatted           */
+	time_t		 vol_time;	/* modification time of the volume   */
+	Boolean		 look_at_id;	/* as passed to _DtHelpFormatTopic   */
+	Boolean		 in_use;	/* handed out; owned by the caller   */
+	_DtCvTopicPtr	 topic;
+	struct _dtHelpTopicCache *next;	/* most recently used first          */
+} DtHelpTopicCacheStruct;
+
 /* 
  * SelectionScroll structure 
  */
@@ -237,6 +251,7 @@ typedef	struct _dtHelpDispAreaStruct {
 	DtHelpSpecialChars *spc_chars;	/* Structure containing the spc chars */
 	_DtCvHandle	  canvas;
 	_DtCvTopicPtr	  lst_topic;
+	DtHelpTopicCacheStruct *topic_cache;	/* formatted topics */
 	wchar_t		 *cant_begin_chars;	/* characters that cannot    */
 						/* begin a line of text      */
 	wchar_t		 *cant_end_chars;	/* characters that cannot    */
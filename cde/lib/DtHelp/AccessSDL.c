@@ -108,6 +108,81 @@ static	const	CESDLVolume	DefaultSdlVolume =
 /******************************************************************************
  *                          Private Functions
  ******************************************************************************/
+/******************************************************************************
+ * Function:	unsigned int HashId (
+ *
+ * Parameters:	id		Specifies the location id.
+ *
+ * Return Value: The hash of the id, ignoring case the way
+ *		 _DtHelpCeStrCaseCmpLatin1 does.
+ *
+ ******************************************************************************/
+static unsigned int
+HashId (
+    const char		*id)
+{
+    unsigned int  hash = 0;
+    int           c;
+
+    while ('\0' != *id)
+      {
+	c    = (unsigned char) *id++;
+	hash = hash * 31 + _DtCvToLower(c);
+      }
+
+    return hash;
+}
+
+/******************************************************************************
+ * Function:	void BuildIdHash (
+ *
+ * Parameters:	sdlVol		Specifies the sdl volume.
+ *		idSegs		Specifies the list of ids of the volume.
+ *
+ * Purpose:	Build the open addressed table that takes a location id
+ *		straight to its loids entry.  The first of several entries
+ *		with the same id wins, as it did for the linear search.
+ *
+ ******************************************************************************/
+static void
+BuildIdHash (
+    CESDLVolume		*sdlVol,
+    _DtCvSegment	*idSegs)
+{
+    int		  count = 0;
+    int		  size  = 16;
+    unsigned int  slot;
+    char	 *idString;
+    _DtCvSegment *pSeg;
+
+    for (pSeg = idSegs; NULL != pSeg; pSeg = pSeg->next_seg)
+	count++;
+
+    while (size < count * 2)
+	size *= 2;
+
+    sdlVol->id_hash = (_DtCvSegment **) calloc(size, sizeof(_DtCvSegment *));
+    if (NULL == sdlVol->id_hash)
+	return;
+    sdlVol->id_hash_size = size;
+
+    for (pSeg = idSegs; NULL != pSeg; pSeg = pSeg->next_seg)
+      {
+	idString = _DtCvContainerIdOfSeg(pSeg);
+	if (NULL == idString)
+	    continue;
+
+	slot = HashId(idString) & (size - 1);
+	while (NULL != sdlVol->id_hash[slot] &&
+		_DtHelpCeStrCaseCmpLatin1(idString,
+			_DtCvContainerIdOfSeg(sdlVol->id_hash[slot])) != 0)
+	    slot = (slot + 1) & (size - 1);
+
+	if (NULL == sdlVol->id_hash[slot])
+	    sdlVol->id_hash[slot] = pSeg;
+      }
+}
+
 /******************************************************************************
  * Function:	void FreeIds (
  *
@@ -852,6 +927,8 @@ _DtHelpCeCleanSdlVolume (
 	 */
 	FreeIds(sdlVol->loids);
 	_DtHelpFreeSegments(sdlVol->loids, _DtCvFALSE, NULL, NULL);
+	if (NULL != sdlVol->id_hash)
+	    free(sdlVol->id_hash);
 
 	/*
 	 * free the document information.
@@ -1186,6 +1263,33 @@ _DtHelpCeMapSdlIdToSegment(
     if (_DtHelpCeGetSdlVolIds(volume, fd, &idSegs) != 0)
 	return NULL;
 
+    /*
+     * ids are looked up for every topic and link shown; go through
+     * the hash of the loids instead of walking them.
+     */
+    if (underScore == False)
+      {
+	CESDLVolume  *sdlVol = _DtHelpCeGetSdlVolumePtr(volume);
+	unsigned int  slot;
+
+	if (NULL == sdlVol->id_hash)
+	    BuildIdHash(sdlVol, idSegs);
+
+	if (NULL != sdlVol->id_hash)
+	  {
+	    slot = HashId(target_id) & (sdlVol->id_hash_size - 1);
+	    while (NULL != sdlVol->id_hash[slot])
+	      {
+		if (_DtHelpCeStrCaseCmpLatin1(target_id,
+			_DtCvContainerIdOfSeg(sdlVol->id_hash[slot])) == 0)
+		    return sdlVol->id_hash[slot];
+
+		slot = (slot + 1) & (sdlVol->id_hash_size - 1);
+	      }
+	    return NULL;
+	  }
+      }
+
     while (idSegs != NULL)
       {
 	if (underScore == True)
@@ -128,6 +128,9 @@ typedef	struct _sdlVolume {
 				   when the title was read              */
     short      minor_no;	/* The minor number of the sdl version */
     short      title_processed;	/* If the title has already been searched for */
+    _DtCvSegment **id_hash;	/* The loids hashed on their id, built  */
+				/* by the first id lookup		*/
+    int        id_hash_size;	/* The number of slots in id_hash       */
 
 } CESDLVolume;
 
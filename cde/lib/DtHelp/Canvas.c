@@ -146,6 +146,8 @@ static	_DtCanvasStruct	DefaultCanvas =
 	NULL,		/* searchs */
 	NULL,		/* pg_breaks */
 	{ NULL },	/* _DtCvVirtualInfo	 virt_functions; */
+	NULL,		/* _DtCvWidthCache	*width_cache;    */
+	NULL,		/* _DtCvBreakCache	*break_cache;    */
   };
 
 /*****************************************************************************
@@ -2114,6 +2116,13 @@ _DtCanvasClean (_DtCvHandle canvas_handle)
     canvas->element_lst = NULL;
     canvas->link_data   = NULL;
 
+    /*
+     * the measured widths and the line breaks point into the
+     * old strings.
+     */
+    _DtCvClearWidthCache(canvas);
+    _DtCvClearBreakCache(canvas);
+
 } /* End _DtCanvasClean */
 
 /*****************************************************************************
@@ -2146,6 +2155,10 @@ _DtCanvasDestroy (_DtCvHandle canvas_handle)
       free ((void*) canvas->searchs);
     if (NULL != canvas->pg_breaks)
       free ((void*) canvas->pg_breaks);
+    if (NULL != canvas->width_cache)
+      free ((void*) canvas->width_cache);
+    if (NULL != canvas->break_cache)
+      free ((void*) canvas->break_cache);
       
     free ((void *) canvas);
     return;
@@ -54,10 +54,12 @@
 /*
  * private includes
  */
+#include "Access.h"
 #include "DisplayAreaP.h"
 #include "CallbacksI.h"
 #include "DestroyI.h"
 #include "FontI.h"
+#include "FormatI.h"
 #include "GraphicsI.h"
 #include "HyperTextI.h"
 #include "StringFuncsI.h"
@@ -151,6 +153,12 @@ _DtHelpDisplayAreaDestroyCB (
      */
     _DtHelpDisplayAreaClean(client_data);
 
+    /*
+     * free the topics kept for redisplay while the graphics
+     * they use can still be freed.
+     */
+    _DtHelpFormatFlushTopics(client_data);
+
     if (NULL != pDAS->canvas)
 	_DtCanvasDestroy (pDAS->canvas);
 
@@ -50,6 +50,7 @@
 #include <fcntl.h>
 #include <locale.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <X11/Xlib.h>
 #include <X11/Xresource.h>
@@ -69,6 +70,7 @@ extern int errno;
  * private includes
  */
 #include "bufioI.h"
+#include "CleanUpI.h"
 #include "CvtToArrayP.h"
 #include "DisplayAreaP.h"
 #include "FontAttrI.h"
@@ -106,6 +108,12 @@ extern int errno;
  *****************************************************************************/
 #define	BUFF_SIZE	1024
 
+/*
+ * the number of formatted topics a display area keeps, besides the
+ * ones it has handed out, so going back and forth doesn't reformat.
+ */
+#define	TOPIC_CACHE_MAX	8
+
 static	char	*ScanString = "\n\t";
 static const _FrmtUiInfo defUiInfo = { NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, 1, False };
 
@@ -114,6 +122,67 @@ static const _FrmtUiInfo defUiInfo = { NULL, NULL, NULL, NULL, NULL, NULL, 0, 0,
  * Private Functions
  *
  *****************************************************************************/
+/******************************************************************************
+ * Function:	DtHelpTopicCacheStruct **FindCachedTopic ()
+ *
+ * Parameters:	pDAS		Specifies the display area.
+ *		vol_name	Specifies the volume name.
+ *		vol_time	Specifies the modification time of the volume.
+ *		id_string	Specifies the location id.
+ *		look_at_id	Specifies the look_at_id value.
+ *		locale		Specifies the current LC_CTYPE.
+ *
+ * Returns:	The link pointing at the matching entry, or at the NULL
+ *		ending the list if there is none.
+ *
+ * Purpose:	Look up a formatted topic in the display area's cache.
+ *
+ ******************************************************************************/
+static DtHelpTopicCacheStruct **
+FindCachedTopic (
+    DtHelpDispAreaStruct	*pDAS,
+    const char			*vol_name,
+    time_t			 vol_time,
+    const char			*id_string,
+    Boolean			 look_at_id,
+    const char			*locale)
+{
+    DtHelpTopicCacheStruct **pEntry = &(pDAS->topic_cache);
+
+    while (NULL != *pEntry &&
+	   ((*pEntry)->vol_time   != vol_time   ||
+	    (*pEntry)->look_at_id != look_at_id ||
+	    strcmp((*pEntry)->id_str,   id_string) != 0 ||
+	    strcmp((*pEntry)->vol_name, vol_name)  != 0 ||
+	    strcmp((*pEntry)->locale,   locale)    != 0))
+	pEntry = &((*pEntry)->next);
+
+    return pEntry;
+}
+
+/******************************************************************************
+ * Function:	void FreeCachedTopic ()
+ *
+ * Parameters:	pDAS		Specifies the display area.
+ *		entry		Specifies the entry, already unlinked.
+ *
+ * Purpose:	Free a cache entry and, unless it is in use, its topic.
+ *
+ ******************************************************************************/
+static void
+FreeCachedTopic (
+    DtHelpDispAreaStruct	*pDAS,
+    DtHelpTopicCacheStruct	*entry)
+{
+    if (False == entry->in_use)
+	_DtHelpDestroyTopicData(entry->topic, _DtHelpDADestroyRegion,
+						(_DtCvPointer) pDAS);
+    free(entry->vol_name);
+    free(entry->id_str);
+    free(entry->locale);
+    free(entry);
+}
+
 /******************************************************************************
  * Function:	int FormatChunksToXmString ()
  *
@@ -1039,10 +1108,48 @@ _DtHelpFormatTopic(
     _FrmtUiInfo           myUiInfo = defUiInfo;
     DtHelpDispAreaStruct *pDAS = (DtHelpDispAreaStruct *) client_data;
     _DtCvTopicInfo	*topic = NULL;
+    char		*volName;
+    char		*locale;
+    char		*idKey = id_string;
+    time_t		 volTime;
+    DtHelpTopicCacheStruct  *entry;
+    DtHelpTopicCacheStruct **pEntry = NULL;
 
     if (_DtHelpCeLockVolume(volume, &lockInfo) != 0)
 	return -1;
 
+    /*
+     * locking the volume rereads it if it changed, so check_time is
+     * current.  A topic formatted before and not on display anymore
+     * is handed out again rather than reparsed.
+     */
+    volName = _DtHelpCeGetVolumeName(volume);
+    volTime = ((_DtHelpVolume) volume)->check_time;
+    locale  = setlocale(LC_CTYPE, NULL);
+    if (NULL != id_string && NULL != volName && NULL != locale)
+      {
+	pEntry = FindCachedTopic(pDAS, volName, volTime, id_string,
+							look_at_id, locale);
+	entry  = *pEntry;
+	if (NULL != entry && False == entry->in_use)
+	  {
+	    *pEntry           = entry->next;
+	    entry->next       = pDAS->topic_cache;
+	    pDAS->topic_cache = entry;
+	    entry->in_use     = True;
+
+	    *ret_handle = (XtPointer) entry->topic;
+	    _DtHelpCeUnlockVolume(lockInfo);
+	    return 0;
+	  }
+
+	/*
+	 * on display, the new one isn't cached.
+	 */
+	if (NULL != entry)
+	    pEntry = NULL;
+      }
+
     if (_DtHelpCeFindId(volume,id_string,lockInfo.fd,&filename,&offset)==True)
       {
 	if (look_at_id == False)
@@ -1077,6 +1184,26 @@ _DtHelpFormatTopic(
 	*ret_handle = (XtPointer) topic;
 	if (result != 0)
 	    result = -3;
+	else if (NULL != pEntry && NULL != topic)
+	  {
+	    entry = (DtHelpTopicCacheStruct *) malloc(sizeof(*entry));
+	    if (NULL != entry)
+	      {
+		entry->vol_name   = strdup(volName);
+		entry->id_str     = strdup(idKey);
+		entry->locale     = strdup(locale);
+		entry->vol_time   = volTime;
+		entry->look_at_id = look_at_id;
+		entry->in_use     = True;
+		entry->topic      = (_DtCvTopicPtr) topic;
+		entry->next       = pDAS->topic_cache;
+		if (NULL == entry->vol_name || NULL == entry->id_str
+						|| NULL == entry->locale)
+		    FreeCachedTopic(pDAS, entry);
+		else
+		    pDAS->topic_cache = entry;
+	      }
+	  }
 
 	if (filename != NULL)
 	    free(filename);
@@ -1234,3 +1361,85 @@ _DtHelpFormatToc (
     return result;
 
 } /* End _DtHelpFormatToc */
+
+/******************************************************************************
+ * Function:	void _DtHelpFormatReleaseTopic (
+ *				XtPointer client_data,
+ *				XtPointer topic_handle)
+ *
+ * Parameters:
+ *		client_data	Specifies the display area.
+ *		topic_handle	Specifies a topic that is no longer displayed.
+ *
+ * Purpose:	Give back a topic.  One from _DtHelpFormatTopic is kept
+ *		for reuse, the least recently used ones beyond
+ *		TOPIC_CACHE_MAX are destroyed.  Any other is destroyed.
+ *
+ ******************************************************************************/
+void
+_DtHelpFormatReleaseTopic (
+	XtPointer	  client_data,
+	XtPointer	  topic_handle)
+{
+    int			  count = 0;
+    DtHelpDispAreaStruct *pDAS = (DtHelpDispAreaStruct *) client_data;
+    DtHelpTopicCacheStruct  *entry;
+    DtHelpTopicCacheStruct **pEntry;
+
+    if (NULL == topic_handle)
+	return;
+
+    for (entry = pDAS->topic_cache;
+		NULL != entry && (XtPointer) entry->topic != topic_handle;
+							entry = entry->next)
+	/* EMPTY */;
+
+    if (NULL == entry)
+      {
+	_DtHelpDestroyTopicData((_DtCvTopicInfo *) topic_handle,
+				_DtHelpDADestroyRegion, (_DtCvPointer) pDAS);
+	return;
+      }
+
+    entry->in_use = False;
+
+    pEntry = &(pDAS->topic_cache);
+    while (NULL != *pEntry)
+      {
+	entry = *pEntry;
+	if (False == entry->in_use && ++count > TOPIC_CACHE_MAX)
+	  {
+	    *pEntry = entry->next;
+	    FreeCachedTopic(pDAS, entry);
+	  }
+	else
+	    pEntry = &(entry->next);
+      }
+
+}  /* End _DtHelpFormatReleaseTopic */
+
+/******************************************************************************
+ * Function:	void _DtHelpFormatFlushTopics (XtPointer client_data)
+ *
+ * Parameters:
+ *		client_data	Specifies the display area.
+ *
+ * Purpose:	Destroy the topics kept by _DtHelpFormatReleaseTopic.
+ *		Topics still handed out stay with their owners.
+ *
+ ******************************************************************************/
+void
+_DtHelpFormatFlushTopics (
+	XtPointer	  client_data)
+{
+    DtHelpDispAreaStruct *pDAS = (DtHelpDispAreaStruct *) client_data;
+    DtHelpTopicCacheStruct  *entry;
+
+    while (NULL != pDAS->topic_cache)
+      {
+	entry             = pDAS->topic_cache;
+	pDAS->topic_cache = entry->next;
+	FreeCachedTopic(pDAS, entry);
+      }
+
+}  /* End _DtHelpFormatFlushTopics */
@@ -81,6 +81,11 @@ extern	int		 _DtHelpFormatToc (
 				char                 *id_string,
 				char                **ret_id,
 				XtPointer            *ret_handle);
+extern	void		 _DtHelpFormatFlushTopics (
+				XtPointer	  client_data);
+extern	void		 _DtHelpFormatReleaseTopic (
+				XtPointer	  client_data,
+				XtPointer	  topic_handle);
 extern	int		 _DtHelpFormatTopic (
 				XtPointer	  client_data,
 				_DtHelpVolumeHdl     volume,
@@ -48,6 +48,8 @@
 #endif
 #include <limits.h>
 #include <stdlib.h>  /* for MB_CUR_MAX */
+#include <wchar.h>   /* wcschr(), wmemcmp() */
+#include <wctype.h>  /* towupper() */
 #include <unistd.h>  /* R_OK */
 #include <locale.h>  /* getlocale(), LOCALE_STATUS */
 #ifndef NO_REGEX
@@ -107,6 +109,7 @@
 #include "FormatI.h"
 #include "HelpXlate.h"
 #include "VolSelectI.h"
+#include "TextIndexI.h"
 #include "Lock.h"
 
 /******** TYPES ***********/
@@ -590,6 +593,7 @@ static int HitLoadTopics (
 {
     _DtHelpVolumeHdl volHandle;
     char * *   origTopicIdList = NULL;
+    char *     textHitIdList[2];
     int        topicCnt;
     int        i;
     XmString * titlesList = NULL;
@@ -605,7 +609,16 @@ static int HitLoadTopics (
     if (_DtHelpOpenVolume(file->fullFilePath, &volHandle) != 0 ) 
         return -1;                                      /* RETURN: error */
 
-    topicCnt = _DtHelpCeFindKeyword(volHandle,hit->indexEntry,&origTopicIdList);
+    /* a full text hit is a single topic, not an index entry */
+    if (hit->topicId)
+    {
+       textHitIdList[0] = hit->topicId;
+       textHitIdList[1] = NULL;
+       origTopicIdList = textHitIdList;
+       topicCnt = 1;
+    }
+    else
+       topicCnt = _DtHelpCeFindKeyword(volHandle,hit->indexEntry,&origTopicIdList);
     if (topicCnt <= 0) return -1;                       /* RETURN: error */
     
     /* get results font list */
@@ -873,6 +886,12 @@ static _DtHelpGlobSrchHit * HitFree (
      {
        /* Free the index entry */
        XtFree(hit->indexEntry);
+       /* the title of a full text hit isn't in indexXmStrsList */
+       if (hit->topicId)
+       {
+          XmStringFree(hit->indexTitle);
+          XtFree(hit->topicId);
+       }
        XtFree((String)hit);
      }
 
@@ -1090,6 +1109,8 @@ done:
  *     The hits are added either to the end of the list, 
  *     so that the srchResultList presents the items in the order found,
  *     or in a sorted order.
+ *     Index entries are sorted ahead of any full text hits,
+ *     which are identified by their topicId.
  *     If a hit on that topic already exists, just the existing
  *     hit structure is returned.
  *
@@ -1105,6 +1126,7 @@ static int HitListAddFound (
     XmString             indexTitle,
     char *               indexEntry,
     Boolean              insertSorted,
+    char *               topicId,
     _DtHelpGlobSrchHit **ret_hit)
 {
    _DtHelpGlobSrchHit * prev;
@@ -1132,6 +1154,9 @@ static int HitListAddFound (
       {
         int ret;
 
+        /* full text hits follow the index entries */
+        if ( NULL != next->topicId ) break;             /* BREAK */
+
         /* do a NLS case insensitive compare using NLS collating */
         if ( (ret = (*strcollfn)(next->indexEntry,indexEntry)) >= 0 )
         {
@@ -1153,7 +1178,9 @@ static int HitListAddFound (
            prev = next, next = next->next )
       {
         if (    newKey == next->indexKey                    /* quick compare */
-             && strcmp(indexEntry,next->indexEntry) == 0 )  /* long compare */
+             && strcmp(indexEntry,next->indexEntry) == 0    /* long compare */
+             && (topicId == NULL) == (next->topicId == NULL)
+             && (topicId == NULL || strcmp(topicId,next->topicId) == 0) )
         {
           if(ret_hit) *ret_hit = next;
           return 0;                                    /* RETURN */
@@ -1173,6 +1200,7 @@ static int HitListAddFound (
    else
       srcHit->indexTitle = indexTitle;
    srcHit->indexEntry = XtNewString(indexEntry);
+   if (topicId) srcHit->topicId = XtNewString(topicId);
    srcHit->indexKey = newKey;
    srcHit->volume = curFile;
 
@@ -1638,6 +1666,10 @@ static void VolListFree (
     /* no need to free indexEntriesList because these aren't owned by vol */
     vol->indexEntriesList = NULL;
 
+    /* drop a full text index that was still being built */
+    _DtHelpTextIndexBuildEnd(vol->textIndexBuild);
+    vol->textIndexBuild = NULL;
+
     /* free indexXmStrsList */
     /* indexXmStrs are XmStrings and we can't use FreeStringArray() */
     for ( nextStr = vol->indexXmStrsList;
@@ -2398,70 +2430,243 @@ static void ResultsListUpdate(
 
 
 
+/*****************************************************************************
+ * The search word is compiled once per search into a matcher.  A word
+ * without regular expression operators is matched as a literal with a
+ * Boyer-Moore-Horspool scan over wide characters, so multibyte code sets
+ * (where an ASCII byte may be the tail of another character) are handled
+ * and case is folded with towupper() on both sides.  Only a word that
+ * really is a regular expression is given to regcomp(), and just once.
+ *****************************************************************************/
+#define	SRCH_RE_CHARS	L".[]()*+?{}|^$\\"
+
+typedef struct _DtHelpSrchMatcherRec
+{
+        char *            pattern;	/* the word compiled, for reuse test */
+        Boolean           isRegex;	/* use the re, not the literal */
+#ifndef NO_REGEX
+# ifndef NO_REGCOMP
+        regex_t           re;
+# else
+        char *            compiledRE;
+# endif
+#endif
+        wchar_t *         wcPattern;	/* literal, upper cased */
+        size_t            wcLen;
+        size_t            skip[256];	/* shifts, by low byte of a wchar */
+        wchar_t *         wcText;	/* string being searched, converted */
+        size_t            wcTextMax;
+} _DtHelpSrchMatcherRec;
+
+/*****************************************************************************
+ * Function:	    void MatcherFree()
+ *
+ * Parameters:      matcher     matcher to free; may be NULL
+ *
+ * Return Value:    void
+ *
+ * Purpose: 	    Release a matcher from MatcherCompile()
+ *****************************************************************************/
+static void MatcherFree(
+          _DtHelpSrchMatcherRec * matcher)
+{
+    if (NULL == matcher) return;                 /* RETURN */
+
+#ifndef NO_REGEX
+    if (matcher->isRegex)
+    {
+# ifndef NO_REGCOMP
+       regfree(&matcher->re);
+# else
+       free(matcher->compiledRE);
+# endif
+    }
+#endif
+    XtFree(matcher->pattern);
+    XtFree((char *) matcher->wcPattern);
+    XtFree((char *) matcher->wcText);
+    XtFree((char *) matcher);
+}
+
+
+/*****************************************************************************
+ * Function:	    void MatcherCompile()
+ *
+ * Parameters:      pattern     search word, in the application code set
+ *
+ * Return Value:    the matcher, or NULL if the word can't be compiled
+ *
+ * Purpose: 	    Decide how the word is to be matched and prepare that
+ *                  once, rather than for every string searched.
+ *****************************************************************************/
+static _DtHelpSrchMatcherRec * MatcherCompile(
+          char * pattern)
+{
+    _DtHelpSrchMatcherRec * matcher;
+    size_t  len;
+    size_t  i;
+    int     n;
+    wchar_t wc;
+    char *  ptr;
+
+    matcher = (_DtHelpSrchMatcherRec *) XtCalloc(1, sizeof(*matcher));
+    matcher->pattern = XtNewString(pattern);
+
+    len = strlen(pattern);
+    matcher->wcPattern = (wchar_t *) XtMalloc(sizeof(wchar_t) * (len + 1));
+
+    /* convert a character at a time; operators in a multibyte */
+    /* code set are only found on character boundaries */
+    for (ptr = pattern; *ptr != EOS; ptr += n)
+    {
+       n = mbtowc(&wc, ptr, MB_CUR_MAX);
+       if (n <= 0) break;                        /* BREAK */
+#ifndef NO_REGEX
+       if (NULL != wcschr(SRCH_RE_CHARS, wc)) matcher->isRegex = True;
+#endif
+       matcher->wcPattern[matcher->wcLen++] = towupper(wc);
+    }
+    matcher->wcPattern[matcher->wcLen] = 0;
+
+    /* a bad sequence can't be matched as a literal */
+    if (*ptr != EOS)
+    {
+#ifdef NO_REGEX
+       MatcherFree(matcher);
+       return NULL;                              /* RETURN */
+#else
+       matcher->isRegex = True;
+#endif
+    }
+
+#ifndef NO_REGEX
+    if (matcher->isRegex)
+    {
+# ifndef NO_REGCOMP
+       if (regcomp(&matcher->re,pattern,REG_NOSUB|REG_ICASE|REG_EXTENDED) != 0)
+       {
+          matcher->isRegex = False;             /* nothing to regfree */
+          MatcherFree(matcher);
+          return NULL;                           /* RETURN */
+       }
+# else
+       matcher->compiledRE = (char *)regcmp(pattern, (char *) NULL);
+       if (NULL == matcher->compiledRE)
+       {
+          matcher->isRegex = False;
+          MatcherFree(matcher);
+          return NULL;                           /* RETURN */
+       }
+# endif
+       return matcher;                           /* RETURN */
+    }
+#endif
+
+    /* Horspool shifts; a byte shared by several characters */
+    /* keeps the smallest shift, which is always safe */
+    for (i = 0; i < 256; i++)
+       matcher->skip[i] = matcher->wcLen;
+    for (i = 0; i + 1 < matcher->wcLen; i++)
+       matcher->skip[matcher->wcPattern[i] & 0xff] = matcher->wcLen - 1 - i;
+
+    return matcher;
+}
+
+
+/*****************************************************************************
+ * Function:	    void MatcherGet()
+ *
+ * Parameters:      srch        search main data structure
+ *                  pattern     search word
+ *
+ * Return Value:    the matcher for pattern, or NULL
+ *
+ * Purpose: 	    Return the compiled search word, compiling it only
+ *                  when it differs from the one compiled last.
+ *****************************************************************************/
+static _DtHelpSrchMatcherRec * MatcherGet(
+          _DtHelpGlobSearchStuff * srch,
+          char *                   pattern)
+{
+    if (   NULL != srch->matcher
+        && strcmp(srch->matcher->pattern, pattern) == 0)
+       return srch->matcher;                     /* RETURN */
+
+    MatcherFree(srch->matcher);
+    srch->matcher = MatcherCompile(pattern);
+    return srch->matcher;
+}
+
+
 /*****************************************************************************
  * Function:	    void SearchForPattern()
  *
- * Parameters:  
+ * Parameters:      matcher     the compiled search word
+ *                  string      string to search
  *
  * Return Value:    True if pattern found, False if not found
  *
  * Purpose: 	    Find a pattern in a string
- *
- * WARNING:         may convert string to uppercase in place
- *                  depending on which code is compiled.
  *****************************************************************************/
 static Boolean SearchForPattern(
-          char * string,
-          char * pattern,
-          int     patternLen)
+          _DtHelpSrchMatcherRec * matcher,
+          char *                  string)
 {
-#if defined(NO_REGEX)  /* don't support regex in string searches */
-       char * hit;
-
-       _DtHelpCeUpperCase(string);
-       /* FIX: make this code much faster by using an improved
-          pattern search algorithm, such as Rabin-Karp. */
-       /* hit is set to NULL if no matching char is found */
-       while (_DtHelpCeStrchr(string, pattern, MB_CUR_MAX, &hit) == 0)
-       {
-          if ( strncmp(hit,pattern,patternLen) == 0 )
-             break;                             /* BREAK */
-          else
-             string = hit + mblen(hit,1);
-       }
-       return (NULL != hit);                    /* RETURN True or False */
-#else /* if NO_REGEX */
+    wchar_t * text;
+    wchar_t * pat;
+    size_t    len;
+    size_t    last;
+    size_t    i;
+
+    if (NULL == matcher) return False;          /* RETURN */
+
+#ifndef NO_REGEX
+    if (matcher->isRegex)
+    {
 # ifndef NO_REGCOMP
-        regex_t    re;
-        int        ret = -1;
+       /* a 0 return value indicates success */
+       return (regexec(&matcher->re,string,0,NULL,0) == 0);
+# else
+       /* a non NULL return value indicates success */
+       return (regex(matcher->compiledRE, string) != NULL);
+# endif
+    }
+#endif
 
-        /* use regexec to pattern match */
-        /* a 0 return value indicates success */
-        if ( regcomp(&re,pattern,REG_NOSUB|REG_ICASE|REG_EXTENDED) == 0 )
-        {
-           /* a 0 return value indicates success */
-           ret = regexec(&re,string,0,NULL,0);
-           regfree(&re);
-        }
-        return (ret == 0);                      /* RETURN True or False */
-# else  /* NO_REGCOMP */
-        char *compiledRE;
-        char *ret = NULL;
-
-        /* a non NULL return value indicates success */
-        compiledRE = (char *)regcmp(pattern, (char *) NULL);
-        if (compiledRE)
-        {
-           /* a non NULL return value indicates success */
-	   ret = regex(compiledRE, string);
-	   free(compiledRE);
-        }
-        return (ret != NULL);	                /* RETURN True or False */
-# endif /* NO_REGCOMP */
-#endif /* if NO_REGEX */
+    if (0 == matcher->wcLen) return True;       /* RETURN */
+
+    /* the converted string can't have more chars than bytes */
+    len = strlen(string);
+    if (len < matcher->wcLen) return False;     /* RETURN */
+    if (len + 1 > matcher->wcTextMax)
+    {
+       matcher->wcTextMax = len + 50;
+       matcher->wcText = (wchar_t *) XtRealloc((char *) matcher->wcText,
+                                    sizeof(wchar_t) * matcher->wcTextMax);
+    }
+    text = matcher->wcText;
+
+    len = mbstowcs(text, string, len + 1);
+    if ((size_t) -1 == len || len < matcher->wcLen)
+       return False;                             /* RETURN */
+
+    /* the scan only looks at a window at a time, but folding */
+    /* the whole string first keeps the compare loop simple */
+    for (i = 0; i < len; i++)
+       text[i] = towupper(text[i]);
+
+    pat = matcher->wcPattern;
+    last = matcher->wcLen - 1;
+    for (i = 0; i + last < len; i += matcher->skip[text[i + last] & 0xff])
+    {
+       if (   text[i + last] == pat[last]
+           && wmemcmp(&text[i], pat, last) == 0)
+          return True;                           /* RETURN */
+    }
+    return False;
 }
 
-
+
 /*****************************************************************************
  * Function:	    void OpenVolForSearch()
  *
@@ -2585,7 +2790,19 @@ static void CloseVolAfterSearch(
  *
  * Return Value:    Void.
  *
- * Purpose: 	    Get a single topic and search for the search word in it
+ * Purpose: 	    Search the text of the topics for the search words
+ *
+ * Commentary:      The topics are looked up in the full text index
+ *                  of the volume (see TextIndex.c).  A volume that
+ *                  has no index yet, because it was installed
+ *                  without running dthelpgen -index or changed
+ *                  since, is indexed numSearches topics per call,
+ *                  so the dialog stays responsive; the topic search
+ *                  stays in progress until the index is written.
+ *                  Looking up the words takes no time at all, so
+ *                  then the whole volume is searched in one call.
+ *                  The topics found are added to the hits ranked
+ *                  best first, after the index entries found.
  *
  *****************************************************************************/
 static void SearchTopic(
@@ -2596,69 +2813,64 @@ static void SearchTopic(
    int               srchWordLen,
    int               numSearches)
 {
-#if 0
-    int i;
-
-    /* if the volume is not open; don't continue */
-    if ( NULL == curVol->volHandle )
-       return;                                  /* RETURN */
-
-    if ( NULL == curVol->indexEntriesList )
-       _CEVolumeTopicList(curVol->volHandle,&curVol->indexEntriesList);
-    if ( NULL == curVol->volHandle || NULL == curVol->indexEntriesList )
+    _DtHelpTextIndex  textIndex = NULL;
+    _DtHelpTextHit *  textHits = NULL;
+    int               hitCnt;
+    int               status;
+    int               i;
+
+    /* the full index holds index entries only */
+    if ( NULL != srchWord && False == hw->help_dialog.srch.fullIndex )
     {
-       curVol->topicSearchInProgress = False;
-       curVol->topicSearchDone = True;
-       curVol->indexSearchInProgress = True;
-       if ( NULL == curVol->volHandle ) curVol->searchCompleted = True;
-       return;                                 /* RETURN */
-    }
-
-    curVol->topicSearchInProgress = True;
-
-
-    /* search the topics */
-    /* note that indexEntriesList[0] is correct; ptr is incremented */
-    /* we can increment the pointer because we don't own this memory;
-       the open volume does. */
-    for (i=0; 
-         i < numSearches && NULL != curVol->indexEntriesList[0]; 
-         i++, curVol->indexEntriesList++ )
-    {
-       char * topicTitle = NULL;
-       Boolean validTopic;
-
-       validTopic = _DtHelpGetTopicTitle( curVol->volHandle,
-                         curVol->indexEntriesList[0],&topicTitle);
-       if(validTopic)
+       if ( NULL == curVol->textIndexBuild )
        {
-          /* look for a hit and process if there was one */
-          if (SearchForPattern(topicTitle,srchWord,srchWordLen) == True)
-          {
-             HitListAddFound(curFile, curVol->indexEntriesList[0], True, NULL);
-          }
+          textIndex = _DtHelpTextIndexOpen(curFile->fullFilePath, False);
+          if ( NULL == textIndex )
+             curVol->textIndexBuild =
+                 _DtHelpTextIndexBuildStart(curFile->fullFilePath, NULL);
        }
 
-       /* clean up and advance to next topic */
-       XtFree(topicTitle);
-       curVol->searchedCnt++;
-    }  /* for all topics to search */
-#endif
+       if ( NULL != curVol->textIndexBuild )
+       {
+          status = _DtHelpTextIndexBuildStep(curVol->textIndexBuild,
+                                             numSearches);
+          if ( 1 == status )
+             return;                 /* RETURN: more topics to index */
+
+          _DtHelpTextIndexBuildEnd(curVol->textIndexBuild);
+          curVol->textIndexBuild = NULL;
+          if ( 0 == status )
+             textIndex = _DtHelpTextIndexOpen(curFile->fullFilePath, False);
+       }
+    }
 
-    if (    NULL == curVol->indexEntriesList      /* no topics queried */
-         || NULL == curVol->indexEntriesList[0] ) /* no more topics available */
+    if ( NULL != textIndex )
     {
-       /* hand off to next stage */
-       curVol->indexEntriesList = NULL;
-       curVol->topicSearchInProgress = False;
-       curVol->topicSearchDone = True;
-       curVol->indexSearchInProgress = True;
+       hitCnt = _DtHelpTextIndexSearch(textIndex, srchWord, &textHits);
+       for (i = 0; i < hitCnt; i++)
+       {
+          _DtHelpGlobSrchHit * hit = NULL;
+
+          /* False: keep the order of the ranking */
+          if (HitListAddFound(curFile, NULL, (char *) textHits[i].title, False,
+                          (char *) textHits[i].topicId, &hit) == 0)
+             hit->topicCnt = 1;
+       }
+       free(textHits);
+       _DtHelpTextIndexClose(textIndex);
+       curVol->searchedCnt++;        /* the volume's topics, as one */
     }
+
+    /* hand off to next stage */
+    curVol->indexEntriesList = NULL;
+    curVol->topicSearchInProgress = False;
+    curVol->topicSearchDone = True;
+    curVol->indexSearchInProgress = True;
 }
 
 
 
-
+
 /*****************************************************************************
  * Function:	    void SearchIndex()
  *
@@ -2697,6 +2909,7 @@ static void SearchIndex(
     char * indexEntry = NULL;
     size_t entryLen = 100;      /* starting size */
     Arg    args[5];
+    _DtHelpSrchMatcherRec * matcher = NULL;
 
     /* if the volume is not open; don't continue */
     if ( NULL == curVol->volHandle )
@@ -2760,6 +2973,10 @@ static void SearchIndex(
 
     curVol->indexSearchInProgress = True;
 
+    /* compiled once for the whole search, not per entry */
+    if (NULL != srchWord)
+       matcher = MatcherGet(&hw->help_dialog.srch, srchWord);
+
     /* alloc memory for index processing */
     indexEntry = XtMalloc(sizeof(char)*(entryLen+1));
     if (NULL == indexEntry) return;            /* RETURN */
@@ -2785,13 +3002,13 @@ static void SearchIndex(
        if (    NULL == srchWord
             || (   _DtHelpCeIconvStr(iconvContext,curVol->indexEntriesList[0],
                         &indexEntry, &entryLen,indexEntry,entryLen) == 0
-                && SearchForPattern(indexEntry, srchWord, srchWordLen) == True ) )
+                && SearchForPattern(matcher, indexEntry) == True ) )
        {
           _DtHelpGlobSrchHit * hit = NULL;
           char * *          topicIdList;
 
           HitListAddFound ( curFile, curVol->curIndexXmStr[0],
-                             curVol->indexEntriesList[0], True, &hit);
+                             curVol->indexEntriesList[0], True, NULL, &hit);
 
           /* topicIdList is set but not allocated & need not be freed */
           hit->topicCnt = _DtHelpCeFindKeyword(curVol->volHandle,
@@ -2870,9 +3087,9 @@ static void SearchVolume(
               hw->help_dialog.srch.wordFieldLen, numSearches);
   }
 
-  /* NOTE: because this isn't an "else if", we could potentially
-     search for 2*numSearches; but I know that I've disabled the
-     topic search.  Furthermore, my code depends upon the possibility
+  /* NOTE: because this isn't an "else if", the topic search, which
+     is done in one call once the volume has a full text index, is
+     followed by the first numSearches index entries.  Furthermore, my code depends upon the possibility
      of searching an entire volume in one call to the routine, if
      desired, and having an else if would break that.
   */
@@ -5180,6 +5397,7 @@ void  _DtHelpGlobSrchInitVars(
     srch->rawWordStr    = NULL;
     srch->normWordStr   = NULL;
     srch->localeWordStr = NULL;
+    srch->matcher       = NULL;
     srch->wordFieldFirstChar = 0;
     srch->wordFieldLen       = 0;
     srch->statusLineUsage = 0;  /* empty */
@@ -5266,6 +5484,8 @@ void  _DtHelpGlobSrchCleanAndClose(
        }
        XtFree(srch->normWordStr);
        srch->normWordStr=NULL;
+       MatcherFree(srch->matcher);
+       srch->matcher=NULL;
        XtFree(srch->rawWordStr);
        srch->rawWordStr=NULL;
        XtFree(srch->curVolPath);
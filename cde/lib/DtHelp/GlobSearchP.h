@@ -94,6 +94,8 @@ typedef struct _DtHelpGlobSrchVol {
   char *                    stdLocale;       /* CDE standard locale of the volume */
   char *                    iconv3Codeset;   /* iconv-compatible codeset of volume locale */
   _CEStrcollProc            strcollProc;     /* proc to do string coll */
+  struct _DtHelpTextIndexBuildRec * textIndexBuild; /* full text index */
+                                             /* being built, or NULL */
 } _DtHelpGlobSrchVol;
 
 /* maintained for each location hit encountered */
@@ -103,6 +105,8 @@ typedef struct _DtHelpGlobSrchHit {
   int                       indexKey;     /* hash value for quick compares */
   XmString                  indexTitle;   /* title used for display */
   char *                    indexEntry;   /* string used for retrieval */
+  char *                    topicId;      /* topic of a full text hit, */
+                                          /* NULL for an index entry */
   char **                   topicIdList;  /* list of topic ids of this index */
   char **                   topicFileList;/* list of files of the topics */
   XmString *                topicTitles;  /* list of titles of the topics */
@@ -5541,6 +5541,19 @@ _DtCanvasResize (
 
     if (canvas->metrics.width != oldWidth || _DtCvTRUE == force)
       {
+        /*
+         * only the width changed, the text measured for the old
+         * width is still good.  The line breaks are remembered with
+         * the room they were found for, so only the paragraphs whose
+         * room changed are broken anew.  A forced layout measures
+         * and breaks everything anew.
+         */
+        if (_DtCvTRUE == force)
+	  {
+	    _DtCvClearWidthCache(canvas);
+	    _DtCvClearBreakCache(canvas);
+	  }
+
         /*
          * remember the current selection.
          */
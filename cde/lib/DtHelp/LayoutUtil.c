@@ -70,6 +70,10 @@
  *
  *****************************************************************************/
 #define	GROW_SIZE	10
+/*
+ * the number of line breaks a canvas remembers.  A power of two.
+ */
+#define	BREAK_CACHE_SIZE	1024
 #define	CheckFormat(x) \
 	(((x)->format_y == -1 || (x)->format_y > (x)->y_pos) ? False : True)
 
@@ -1206,6 +1210,49 @@ _DtCvCheckAddHyperToTravList (
 	*cur_len = retLen;
 }
 
+/******************************************************************************
+ * Function:	GetBreakEntry
+ *
+ * Returns:	the slot of the line break cache for a line of 'seg'
+ *		starting at 'start' with 'work_width' room left, or NULL
+ *		if the cache can not be allocated.
+ *
+ *****************************************************************************/
+static _DtCvBreakCache *
+GetBreakEntry (
+    _DtCanvasStruct	*canvas,
+    _DtCvSegmentI	*seg,
+    unsigned int	 start,
+    _DtCvUnit		 work_width,
+    int			 lst_hyper)
+{
+    if (NULL == canvas->break_cache)
+	canvas->break_cache = (_DtCvBreakCache *) calloc (BREAK_CACHE_SIZE,
+						sizeof(_DtCvBreakCache));
+    if (NULL == canvas->break_cache)
+	return NULL;
+
+    return &(canvas->break_cache[((((unsigned long) seg) >> 4)
+				^ (start * 31) ^ (work_width * 17)
+				^ lst_hyper) & (BREAK_CACHE_SIZE - 1)]);
+}
+
+/******************************************************************************
+ * Function:	_DtCvClearBreakCache
+ *
+ * Purpose:	Forget the line breaks found.  Needed whenever the
+ *		segments of the canvas or the fonts behind them change.
+ *
+ *****************************************************************************/
+void
+_DtCvClearBreakCache (
+    _DtCanvasStruct	*canvas)
+{
+    if (NULL != canvas->break_cache)
+	memset ((void *) canvas->break_cache, 0,
+			sizeof(_DtCvBreakCache) * BREAK_CACHE_SIZE);
+}
+
 /******************************************************************************
  * Function: ProcessStringSegment
  *
@@ -1240,6 +1287,9 @@ _DtCvProcessStringSegment(
     char	 *strPtr;
     _DtCvValue    done    = False;
     _DtCvSegmentI *retSeg;
+    _DtCvBreakCache *brkEntry;
+    unsigned int  brkStart;
+    int		  brkHyper;
 
     if (NULL != _DtCvStringOfStringSeg(cur_seg))
       {
@@ -1487,6 +1537,40 @@ _DtCvProcessStringSegment(
 	    done = False;
 	    textWidth = 0;
 	    stringLen = 0;
+
+	    /*
+	     * a re-layout breaks the same paragraphs again.  If this
+	     * line has been broken before with the same room left,
+	     * the break found then holds.  A paragraph whose room
+	     * changed misses and is broken anew.
+	     */
+	    brkStart = *cur_start;
+	    brkHyper = lay_info->lst_hyper;
+	    brkEntry = GetBreakEntry (canvas, cur_seg, brkStart, workWidth,
+								brkHyper);
+	    if (NULL != brkEntry && brkEntry->seg == cur_seg
+				&& brkEntry->start == brkStart
+				&& brkEntry->work_width == workWidth
+				&& brkEntry->lst_hyper == brkHyper)
+	      {
+		if (0 < brkEntry->str_len)
+		  {
+	            _DtCvCheckAddHyperToTravList (canvas, cur_seg, _DtCvFALSE,
+					&(lay_info->lst_vis),
+					&(lay_info->lst_hyper),
+					&(lay_info->cur_len));
+
+		    _DtCvSetJoinInfo(lay_info, False, -1);
+		    spaceSize = brkEntry->space_size;
+		  }
+		*cur_start = brkEntry->end_start;
+		stringLen  = brkEntry->str_len;
+		textWidth  = brkEntry->txt_width;
+		retStart   = brkEntry->ret_start;
+		retCount   = brkEntry->ret_count;
+		done       = True;
+	      }
+
 	    while (!done)
 	      {
 		nWidth = _DtCvGetNextWidth (canvas, oldType,
@@ -1539,6 +1623,20 @@ _DtCvProcessStringSegment(
 		     * fit in the size given
 		     */
 		    done = True;
+
+		    if (NULL != brkEntry)
+		      {
+			brkEntry->seg        = cur_seg;
+			brkEntry->start      = brkStart;
+			brkEntry->work_width = workWidth;
+			brkEntry->lst_hyper  = brkHyper;
+			brkEntry->end_start  = *cur_start;
+			brkEntry->str_len    = stringLen;
+			brkEntry->txt_width  = textWidth;
+			brkEntry->space_size = spaceSize;
+			brkEntry->ret_start  = retStart;
+			brkEntry->ret_count  = retCount;
+		      }
 		  }
 	      }
 
@@ -105,6 +105,8 @@ extern	void		_DtCvCheckAddHyperToTravList (
 				_DtCvValue	*lst_vis,
 				int		*lst_hyper,
 				_DtCvUnit	*cur_len);
+extern	void		_DtCvClearBreakCache (
+				_DtCanvasStruct	*canvas);
 extern	_DtCvValue	_DtCvCheckLineSyntax (
 				_DtCanvasStruct	 *canvas,
 				_DtCvSegmentI	 *pSeg,
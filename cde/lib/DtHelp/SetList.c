@@ -722,10 +722,9 @@ _DtHelpDisplayAreaSetList (
 						&width, &height, &scrollY);
 
     /*
-     * free the old topic and remember the new
+     * give back the old topic and remember the new
      */
-    _DtHelpDestroyTopicData(pDAS->lst_topic, _DtHelpDADestroyRegion,
-						(_DtCvPointer) pDAS);
+    _DtHelpFormatReleaseTopic((XtPointer) pDAS, (XtPointer) pDAS->lst_topic);
 
     pDAS->lst_topic = (_DtCvTopicPtr) topic_handle;
 
@@ -864,10 +863,9 @@ _DtHelpUpdatePath (
 						&width, &height, NULL);
 
     /*
-     * free the old topic and remember the new
+     * give back the old topic and remember the new
      */
-    _DtHelpDestroyTopicData(pDAS->lst_topic, _DtHelpDADestroyRegion,
-						(_DtCvPointer) pDAS);
+    _DtHelpFormatReleaseTopic((XtPointer) pDAS, (XtPointer) pDAS->lst_topic);
 
     pDAS->lst_topic = (_DtCvTopicPtr) topic_handle;
 
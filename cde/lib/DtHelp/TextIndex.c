@@ -0,0 +1,1152 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/************************************<+>*************************************
+ ****************************************************************************
+ **
+ **   File:        TextIndex.c
+ **
+ **   Project:     DtHelp Project
+ **
+ **   Description: Builds, maps and searches the full text index of
+ **                the topics of a help volume.
+ **
+ **   The index of a volume is looked for next to the volume, with
+ **   the DtHelpTEXT_INDEX_EXT extension appended (dthelpgen -index
+ **   puts it there when it can write the directory, eg. at install
+ **   time), then in the user's $HOME/.dt/help/textindex directory.
+ **   An index is only used if it was built from the current size and
+ **   modification time of the volume and in the codeset of the current
+ **   locale, so a changed volume is simply indexed again.
+ **
+ **   All integers of the file are 32 bits in network byte order:
+ **   Header:   magic, version, size and mtime of the volume, offsets of
+ **             the volume path and codeset strings, number and offset
+ **             of the topics, number and offset of the words, file size.
+ **   Topics:   offsets of the location id and title strings, and a
+ **             reserved word, for each topic.
+ **   Words:    offset of the string, offset and number of postings,
+ **             for each word in strcmp order.
+ **   Postings: topic number and weight (occurrences in the text, plus
+ **             TIX_TITLE_WEIGHT for each in the title), by topic number.
+ **   Strings:  nul terminated, in the codeset of the locale.
+ **
+ ****************************************************************************
+ ************************************<+>*************************************/
+
+/*
+ * system includes
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+#include <wctype.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <netinet/in.h>		/* htonl, ntohl */
+
+#include <X11/Intrinsic.h>
+
+/*
+ * Canvas Engine includes
+ */
+#include "CanvasP.h"
+
+/*
+ * private includes
+ */
+#include "bufioI.h"
+#include "Access.h"
+#include "AccessI.h"
+#include "HelpTermP.h"
+#include "HelpXlate.h"
+#include "StringFuncsI.h"
+#include "TextIndexI.h"
+#include "Lock.h"
+
+/* lib/DtHelp/FormatTerm.c */
+extern int _DtHelpTermCreateCanvas(int maxColumns, _DtCvHandle *ret_canvas);
+extern int _DtHelpTermGetTopicData(_DtCvHandle canvasHandle,
+				   _DtHelpVolumeHdl volHandle,
+				   char *locationId,
+				   char ***helpList,
+				   DtHelpHyperLines **hyperList);
+
+/******** constants *********/
+#define	TIX_MAGIC	0x44544958	/* "DTIX" */
+#define	TIX_VERSION	1
+#define	TIX_USER_DIR	"%s/.dt/help/textindex"
+#define	TIX_HDR_INTS	11
+#define	TIX_MAX_WORD	64		/* longer words are truncated */
+#define	TIX_MAX_TERMS	32		/* words of a search */
+#define	TIX_TITLE_WEIGHT 4
+#define	TIX_COLUMNS	1024
+
+/* header words */
+enum { HdrMagic, HdrVersion, HdrVolSize, HdrVolMtime, HdrPath, HdrCodeset,
+       HdrTopicCnt, HdrTopics, HdrWordCnt, HdrWords, HdrFileSize };
+
+/******** types *********/
+struct _DtHelpTextIndexRec {
+  char *            map;
+  size_t            mapLen;
+  unsigned int      topicCount;
+  unsigned int      wordCount;
+  const uint32_t *  topics;
+  const uint32_t *  words;
+};
+
+typedef struct _TixWord {
+  struct _TixWord * next;         /* hash chain */
+  char *            word;
+  unsigned int *    posts;        /* topic number, weight pairs */
+  unsigned int      count;        /* number of pairs */
+  unsigned int      max;
+} TixWord;
+
+typedef struct _TixTopic {
+  struct _TixTopic * next;        /* hash chain */
+  char *             id;
+  char *             title;
+} TixTopic;
+
+typedef struct {
+  TixWord * *       wordHash;
+  unsigned int      wordHashSz;   /* power of 2 */
+  unsigned int      wordCount;
+  TixTopic *        topicHash[1024];
+  TixTopic * *      topics;       /* in the order found */
+  unsigned int      topicCount;
+  unsigned int      topicMax;
+  unsigned int      curTopic;
+  unsigned int      curWeight;
+} TixBuild;
+
+struct _DtHelpTextIndexBuildRec {
+  TixBuild              b;
+  _DtHelpVolumeHdl      vol;
+  _DtHelpCeIconvContext iconvContext;
+  struct stat           volStat;      /* of the volume when the build began */
+  char *                volPath;
+  char *                codeset;      /* of the locale */
+  char *                volCodeset;
+  char                  idxPath[MAXPATHLEN + 1];
+};
+
+typedef struct {
+  char *            terms[TIX_MAX_TERMS];
+  int               count;
+} TixTerms;
+
+/******** static variables *********/
+static _DtCvHandle  TixCanvas = NULL;
+
+/******************************************************************************
+ *
+ * Private functions
+ *
+ ******************************************************************************/
+/******************************************************************************
+ * Function: HashStr
+ *
+ *    Returns the FNV-1a hash of a string.
+ ******************************************************************************/
+static unsigned int
+HashStr (
+    const char	*str)
+{
+    unsigned int h = 2166136261u;
+
+    while (*str)
+	h = (h ^ (unsigned char) *str++) * 16777619u;
+    return h;
+}
+
+/******************************************************************************
+ * Function: Log2
+ *
+ *    Returns the integer logarithm of n, 0 for 0 and 1.
+ ******************************************************************************/
+static unsigned int
+Log2 (
+    unsigned int	n)
+{
+    unsigned int l = 0;
+
+    while (n >>= 1)
+	l++;
+    return l;
+}
+
+/******************************************************************************
+ * Function: ForEachWord
+ *
+ *    Calls proc for each word of a string in the codeset of the locale.
+ *    Words are runs of alphanumeric characters, lower cased.  The same
+ *    rule splits the topics and the search words, so a search word
+ *    matches however the text spelled it.
+ ******************************************************************************/
+static void
+ForEachWord (
+    const char	*str,
+    void	(*proc)(const char *, void *),
+    void	*data)
+{
+    wchar_t	 wbuf[TIX_MAX_WORD + 1];
+    char	 mbuf[(TIX_MAX_WORD + 1) * MB_LEN_MAX];
+    wchar_t	 wc;
+    int		 len;
+    int		 n = 0;
+
+    (void) mbtowc(NULL, NULL, 0);
+    for (;;)
+      {
+	len = 0;
+	wc  = 0;
+	if (*str != '\0' && (len = mbtowc(&wc, str, MB_CUR_MAX)) <= 0)
+	  {
+	    /* an invalid byte ends a word */
+	    len = 1;
+	    wc  = 0;
+	  }
+
+	if (wc != 0 && iswalnum(wc))
+	  {
+	    if (n < TIX_MAX_WORD)
+		wbuf[n++] = towlower(wc);
+	  }
+	else if (n > 0)
+	  {
+	    wbuf[n] = 0;
+	    n = 0;
+	    if (wcstombs(mbuf, wbuf, sizeof(mbuf)) != (size_t) -1)
+		(*proc)(mbuf, data);
+	  }
+
+	if (*str == '\0')
+	    break;
+	str += len;
+      }
+}
+
+/******************************************************************************
+ * Function: AddWord
+ *
+ *    Adds an occurrence of a word in the current topic to the index.
+ ******************************************************************************/
+static void
+AddWord (
+    const char	*word,
+    void	*data)
+{
+    TixBuild	 *b = (TixBuild *) data;
+    TixWord	 *w;
+    TixWord	**bucket;
+    TixWord	**oldHash;
+    TixWord	 *next;
+    unsigned int  oldSz;
+    unsigned int  i;
+
+    /* double the hash table when it has as many words as buckets */
+    if (b->wordCount >= b->wordHashSz)
+      {
+	oldHash = b->wordHash;
+	oldSz   = b->wordHashSz;
+	b->wordHashSz = (oldSz ? oldSz * 2 : 4096);
+	b->wordHash = (TixWord **) calloc(b->wordHashSz, sizeof(TixWord *));
+	if (b->wordHash == NULL)
+	  {
+	    b->wordHash   = oldHash;
+	    b->wordHashSz = oldSz;
+	    return;
+	  }
+	for (i = 0; i < oldSz; i++)
+	    for (w = oldHash[i]; w != NULL; w = next)
+	      {
+		next   = w->next;
+		bucket = &b->wordHash[HashStr(w->word) & (b->wordHashSz - 1)];
+		w->next = *bucket;
+		*bucket = w;
+	      }
+	free(oldHash);
+      }
+
+    bucket = &b->wordHash[HashStr(word) & (b->wordHashSz - 1)];
+    for (w = *bucket; w != NULL && strcmp(w->word, word) != 0; w = w->next)
+	;
+
+    if (w == NULL)
+      {
+	w = (TixWord *) calloc(1, sizeof(TixWord));
+	if (w == NULL || (w->word = strdup(word)) == NULL)
+	  {
+	    free(w);
+	    return;
+	  }
+	w->next = *bucket;
+	*bucket = w;
+	b->wordCount++;
+      }
+
+    /* topics are indexed one after the other */
+    if (w->count > 0 && w->posts[2 * (w->count - 1)] == b->curTopic)
+      {
+	w->posts[2 * (w->count - 1) + 1] += b->curWeight;
+	return;
+      }
+
+    if (w->count == w->max)
+      {
+	unsigned int *posts;
+
+	posts = (unsigned int *) realloc(w->posts,
+			(w->max ? w->max * 2 : 4) * 2 * sizeof(unsigned int));
+	if (posts == NULL)
+	    return;
+	w->posts = posts;
+	w->max   = (w->max ? w->max * 2 : 4);
+      }
+    w->posts[2 * w->count]     = b->curTopic;
+    w->posts[2 * w->count + 1] = b->curWeight;
+    w->count++;
+}
+
+/******************************************************************************
+ * Function: AddTopic
+ *
+ *    Adds a location id to the topics of the index.
+ *    Returns True if it is new, False if it is known or an error occurred.
+ ******************************************************************************/
+static int
+AddTopic (
+    TixBuild	*b,
+    const char	*id)
+{
+    TixTopic	 *t;
+    TixTopic	**bucket;
+
+    bucket = &b->topicHash[HashStr(id) % XtNumber(b->topicHash)];
+    for (t = *bucket; t != NULL; t = t->next)
+	if (strcmp(t->id, id) == 0)
+	    return False;
+
+    if (b->topicCount == b->topicMax)
+      {
+	TixTopic **topics;
+
+	topics = (TixTopic **) realloc(b->topics,
+			(b->topicMax ? b->topicMax * 2 : 256) * sizeof(TixTopic *));
+	if (topics == NULL)
+	    return False;
+	b->topics   = topics;
+	b->topicMax = (b->topicMax ? b->topicMax * 2 : 256);
+      }
+
+    t = (TixTopic *) calloc(1, sizeof(TixTopic));
+    if (t == NULL || (t->id = strdup(id)) == NULL)
+      {
+	free(t);
+	return False;
+      }
+    t->next = *bucket;
+    *bucket = t;
+    b->topics[b->topicCount++] = t;
+    return True;
+}
+
+/******************************************************************************
+ * Function: WalkTopics
+ *
+ *    Adds a topic and, unless it was already known, its children.
+ ******************************************************************************/
+static void
+WalkTopics (
+    TixBuild		*b,
+    _DtHelpVolumeHdl	 vol,
+    char		*id)
+{
+    char	**children = NULL;
+    char	**next;
+
+    if (AddTopic(b, id) == False)
+	return;
+
+    if (_DtHelpCeGetTopicChildren(vol, id, &children) > 0 && children != NULL)
+	for (next = children; *next != NULL; next++)
+	    WalkTopics(b, vol, *next);
+
+    if (children != NULL)
+	_DtHelpCeFreeStringArray(children);
+}
+
+/******************************************************************************
+ * Function: CompareWords
+ ******************************************************************************/
+static int
+CompareWords (
+    const void	*a,
+    const void	*b)
+{
+    return strcmp((*(TixWord **) a)->word, (*(TixWord **) b)->word);
+}
+
+/******************************************************************************
+ * Function: WriteIndex
+ *
+ *    Lays out the index built in b and writes it to idxPath.
+ *    Returns 0 if successful, -1 if not.
+ ******************************************************************************/
+static int
+WriteIndex (
+    TixBuild		*b,
+    const char		*idxPath,
+    const char		*volPath,
+    const char		*codeset,
+    struct stat		*volStat)
+{
+    TixWord	**words;
+    TixWord	 *w;
+    uint32_t	 *buf;
+    uint32_t	 *p;
+    char	 *strs;
+    char	  tmpPath[MAXPATHLEN + 16];
+    size_t	  nPosts = 0;
+    size_t	  strLen;
+    size_t	  ints;
+    size_t	  size;
+    size_t	  len;
+    unsigned int  i, j, n;
+    int		  fd;
+    int		  result = -1;
+
+    /* gather the words in strcmp order */
+    words = (TixWord **) malloc((b->wordCount + 1) * sizeof(TixWord *));
+    if (words == NULL)
+	return -1;
+    for (i = 0, n = 0; i < b->wordHashSz; i++)
+	for (w = b->wordHash[i]; w != NULL; w = w->next)
+	  {
+	    words[n++] = w;
+	    nPosts += w->count;
+	  }
+    qsort(words, n, sizeof(TixWord *), CompareWords);
+
+    /* size the file */
+    strLen = strlen(volPath) + strlen(codeset) + 2;
+    for (i = 0; i < b->topicCount; i++)
+	strLen += strlen(b->topics[i]->id) + strlen(b->topics[i]->title) + 2;
+    for (i = 0; i < n; i++)
+	strLen += strlen(words[i]->word) + 1;
+    ints = TIX_HDR_INTS + 3 * b->topicCount + 3 * n + 2 * nPosts;
+    size = ints * sizeof(uint32_t) + strLen;
+    if (size > UINT32_MAX || (buf = (uint32_t *) malloc(size)) == NULL)
+      {
+	free(words);
+	return -1;
+      }
+    strs = (char *) (buf + ints);
+
+#define	ADD_STR(s) \
+	(len = strlen(s) + 1, memcpy(strs, (s), len), strs += len, \
+	 htonl((uint32_t) (strs - len - (char *) buf)))
+
+    p = buf;
+    p[HdrMagic]    = htonl(TIX_MAGIC);
+    p[HdrVersion]  = htonl(TIX_VERSION);
+    p[HdrVolSize]  = htonl((uint32_t) volStat->st_size);
+    p[HdrVolMtime] = htonl((uint32_t) volStat->st_mtime);
+    p[HdrPath]     = ADD_STR(volPath);
+    p[HdrCodeset]  = ADD_STR(codeset);
+    p[HdrTopicCnt] = htonl(b->topicCount);
+    p[HdrTopics]   = htonl(TIX_HDR_INTS * sizeof(uint32_t));
+    p[HdrWordCnt]  = htonl(n);
+    p[HdrWords]    = htonl((TIX_HDR_INTS + 3 * b->topicCount) * sizeof(uint32_t));
+    p[HdrFileSize] = htonl((uint32_t) size);
+    p += TIX_HDR_INTS;
+
+    for (i = 0; i < b->topicCount; i++)
+      {
+	*p++ = ADD_STR(b->topics[i]->id);
+	*p++ = ADD_STR(b->topics[i]->title);
+	*p++ = 0;
+      }
+
+    /* postings follow the word table */
+    nPosts = TIX_HDR_INTS + 3 * b->topicCount + 3 * n;
+    for (i = 0; i < n; i++)
+      {
+	w = words[i];
+	*p++ = ADD_STR(w->word);
+	*p++ = htonl((uint32_t) (nPosts * sizeof(uint32_t)));
+	*p++ = htonl(w->count);
+	for (j = 0; j < 2 * w->count; j++)
+	    buf[nPosts + j] = htonl(w->posts[j]);
+	nPosts += 2 * w->count;
+      }
+#undef	ADD_STR
+
+    /* write a temporary file and rename it, so readers never see a part */
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%d", idxPath, (int) getpid());
+    fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1)
+      {
+	if (write(fd, buf, size) == (ssize_t) size && close(fd) == 0)
+	    result = rename(tmpPath, idxPath);
+	else
+	    close(fd);
+	if (result != 0)
+	    unlink(tmpPath);
+      }
+
+    free(buf);
+    free(words);
+    return (result == 0 ? 0 : -1);
+}
+
+/******************************************************************************
+ * Function: UserIndexPath
+ *
+ *    Puts the path of the user's index of a volume in path.
+ *    If create is True, makes the directory of the user's indexes.
+ *    Returns 0 if successful, -1 if not.
+ ******************************************************************************/
+static int
+UserIndexPath (
+    const char	*volPath,
+    const char	*codeset,
+    int		 create,
+    char	*path)
+{
+    const char	*home = getenv("HOME");
+    const char	*base;
+    unsigned int h;
+
+    if (home == NULL || *home == '\0')
+	return -1;
+
+    if (create)
+      {
+	snprintf(path, MAXPATHLEN, "%s/.dt", home);
+	(void) mkdir(path, 0755);
+	strcat(path, "/help");
+	(void) mkdir(path, 0755);
+	snprintf(path, MAXPATHLEN, TIX_USER_DIR, home);
+	if (mkdir(path, 0755) == -1 && errno != EEXIST)
+	    return -1;
+      }
+
+    /* the same volume read in another codeset gets another index */
+    h = (HashStr(volPath) * 31) ^ HashStr(codeset);
+    base = strrchr(volPath, '/');
+    base = (base ? base + 1 : volPath);
+    if (snprintf(path, MAXPATHLEN, TIX_USER_DIR "/%s.%08x%s", home, base, h,
+		 DtHelpTEXT_INDEX_EXT) >= MAXPATHLEN)
+	return -1;
+    return 0;
+}
+
+/******************************************************************************
+ * Function: MapIndex
+ *
+ *    Maps an index file and checks that it is an index of the volume,
+ *    as it is now, in the codeset.  Returns NULL if not.
+ ******************************************************************************/
+static _DtHelpTextIndex
+MapIndex (
+    const char		*idxPath,
+    const char		*volPath,
+    const char		*codeset,
+    struct stat		*volStat)
+{
+    _DtHelpTextIndex	 index;
+    struct stat		 buf;
+    const uint32_t	*hdr;
+    uint32_t		 topics, words;
+    uint32_t		 path, cs;
+    int			 fd;
+
+    fd = open(idxPath, O_RDONLY);
+    if (fd == -1)
+	return NULL;
+    if (fstat(fd, &buf) == -1 ||
+	buf.st_size < (off_t) (TIX_HDR_INTS * sizeof(uint32_t)) ||
+	buf.st_size > UINT32_MAX)
+      {
+	close(fd);
+	return NULL;
+      }
+
+    index = (_DtHelpTextIndex) calloc(1, sizeof(struct _DtHelpTextIndexRec));
+    if (index == NULL)
+      {
+	close(fd);
+	return NULL;
+      }
+    index->mapLen = buf.st_size;
+    index->map = (char *) mmap(NULL, index->mapLen, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (index->map == (char *) MAP_FAILED)
+      {
+	free(index);
+	return NULL;
+      }
+
+    /* the tables must fit and the strings must be terminated */
+    hdr = (const uint32_t *) index->map;
+    index->topicCount = ntohl(hdr[HdrTopicCnt]);
+    index->wordCount  = ntohl(hdr[HdrWordCnt]);
+    topics = ntohl(hdr[HdrTopics]);
+    words  = ntohl(hdr[HdrWords]);
+    path   = ntohl(hdr[HdrPath]);
+    cs     = ntohl(hdr[HdrCodeset]);
+    if (ntohl(hdr[HdrMagic]) != TIX_MAGIC ||
+	ntohl(hdr[HdrVersion]) != TIX_VERSION ||
+	ntohl(hdr[HdrFileSize]) != index->mapLen ||
+	ntohl(hdr[HdrVolSize]) != (uint32_t) volStat->st_size ||
+	ntohl(hdr[HdrVolMtime]) != (uint32_t) volStat->st_mtime ||
+	index->map[index->mapLen - 1] != '\0' ||
+	path >= index->mapLen || strcmp(index->map + path, volPath) != 0 ||
+	cs >= index->mapLen || strcmp(index->map + cs, codeset) != 0 ||
+	topics % sizeof(uint32_t) != 0 || words % sizeof(uint32_t) != 0 ||
+	topics > index->mapLen ||
+	index->topicCount > (index->mapLen - topics) / (3 * sizeof(uint32_t)) ||
+	words > index->mapLen ||
+	index->wordCount > (index->mapLen - words) / (3 * sizeof(uint32_t)))
+      {
+	_DtHelpTextIndexClose(index);
+	return NULL;
+      }
+
+    index->topics = (const uint32_t *) (index->map + topics);
+    index->words  = (const uint32_t *) (index->map + words);
+    return index;
+}
+
+/******************************************************************************
+ * Function: IndexStr
+ *
+ *    Returns the string at an offset of the index, "" if it is invalid.
+ ******************************************************************************/
+static const char *
+IndexStr (
+    _DtHelpTextIndex	 index,
+    uint32_t		 offset)
+{
+    offset = ntohl(offset);
+    return (offset < index->mapLen ? index->map + offset : "");
+}
+
+/******************************************************************************
+ * Function: Postings
+ *
+ *    Returns the postings of word number w and their number in *ret_count,
+ *    or NULL if they are not inside the file.
+ ******************************************************************************/
+static const uint32_t *
+Postings (
+    _DtHelpTextIndex	 index,
+    unsigned int	 w,
+    unsigned int	*ret_count)
+{
+    uint32_t offset = ntohl(index->words[3 * w + 1]);
+    uint32_t count  = ntohl(index->words[3 * w + 2]);
+
+    if (offset % sizeof(uint32_t) != 0 || offset > index->mapLen ||
+	count > (index->mapLen - offset) / (2 * sizeof(uint32_t)))
+	return NULL;
+    *ret_count = count;
+    return (const uint32_t *) (index->map + offset);
+}
+
+/******************************************************************************
+ * Function: AddTerm
+ *
+ *    Collects the words of a search.
+ ******************************************************************************/
+static void
+AddTerm (
+    const char	*word,
+    void	*data)
+{
+    TixTerms *terms = (TixTerms *) data;
+
+    if (terms->count < TIX_MAX_TERMS &&
+	(terms->terms[terms->count] = strdup(word)) != NULL)
+	terms->count++;
+}
+
+/******************************************************************************
+ * Function: CompareHits
+ *
+ *    Orders hits by score, best first, then in the order of the volume.
+ ******************************************************************************/
+static int
+CompareHits (
+    const void	*a,
+    const void	*b)
+{
+    const _DtHelpTextHit *ha = (const _DtHelpTextHit *) a;
+    const _DtHelpTextHit *hb = (const _DtHelpTextHit *) b;
+
+    if (ha->score != hb->score)
+	return (ha->score < hb->score ? 1 : -1);
+    return (ha->topicId < hb->topicId ? -1 : ha->topicId > hb->topicId);
+}
+
+/******************************************************************************
+ *
+ * Semi-Public functions
+ *
+ ******************************************************************************/
+/******************************************************************************
+ * Function: _DtHelpTextIndexBuilder _DtHelpTextIndexBuildStart (
+ *					char *volPath, char *idxPath)
+ *
+ * Parameters:	volPath		Specifies the path of the volume.
+ *		idxPath		Specifies the index file to write, or
+ *				NULL for where _DtHelpTextIndexOpen()
+ *				looks for it first.
+ *
+ * Returns:	The state of the build, NULL if an error occurred.
+ *
+ * Purpose:	Opens the volume and finds the topics to index: all
+ *		topics of a volume that are in its table of contents
+ *		or its keyword index.  _DtHelpTextIndexBuildStep() then
+ *		indexes them a few at a time, so that a caller running
+ *		in a work procedure stays responsive.
+ ******************************************************************************/
+_DtHelpTextIndexBuilder
+_DtHelpTextIndexBuildStart (
+    const char	*volPath,
+    const char	*idxPath)
+{
+    _DtHelpTextIndexBuilder bld;
+    char		 *volLocale;
+    char		 *topId = NULL;
+    char		**keywords = NULL;
+    char		**ids;
+    char		 *ptr;
+    char		  usrPath[MAXPATHLEN + 1];
+
+    bld = (_DtHelpTextIndexBuilder) calloc(1, sizeof(*bld));
+    if (bld == NULL)
+	return NULL;
+
+    if (stat(volPath, &bld->volStat) == -1 ||
+	_DtHelpOpenVolume((char *) volPath, &bld->vol) != 0)
+      {
+	free(bld);
+	return NULL;
+      }
+    bld->volPath = strdup(volPath);
+
+    _DtHelpProcessLock();
+    if (TixCanvas == NULL)
+	_DtHelpTermCreateCanvas(TIX_COLUMNS, &TixCanvas);
+    _DtHelpProcessUnlock();
+
+    _DtHelpCeGetLcCtype(NULL, NULL, &bld->codeset);
+    if (TixCanvas == NULL || bld->codeset == NULL || bld->volPath == NULL)
+      {
+	_DtHelpTextIndexBuildEnd(bld);
+	return NULL;
+      }
+
+    if (idxPath != NULL)
+	snprintf(bld->idxPath, sizeof(bld->idxPath), "%s", idxPath);
+    else
+      {
+	/* next to the volume if we may write there, else the user's */
+	snprintf(bld->idxPath, sizeof(bld->idxPath), "%s%s", volPath,
+		 DtHelpTEXT_INDEX_EXT);
+	ptr = strrchr(bld->idxPath, '/');
+	if (ptr != NULL && ptr != bld->idxPath)
+	  {
+	    *ptr = '\0';
+	    if (access(bld->idxPath, W_OK) == 0)
+		*ptr = '/';
+	    else if (UserIndexPath(volPath, bld->codeset, True, usrPath) == 0)
+		strcpy(bld->idxPath, usrPath);
+	    else
+		*ptr = '/';
+	  }
+      }
+
+    /* titles are in the codeset of the volume */
+    volLocale = _DtHelpGetVolumeLocale(bld->vol);
+    if (volLocale != NULL && _DtHelpCeStrchr(volLocale, ".", 1, &ptr) == 0 &&
+	*++ptr != '\0')
+	bld->volCodeset = strdup(ptr);
+    free(volLocale);
+    if (bld->volCodeset != NULL && strcmp(bld->volCodeset, bld->codeset) != 0)
+	_DtHelpCeIconvOpen(&bld->iconvContext, bld->volCodeset, bld->codeset,
+			   ' ', ' ');
+
+    /* find the topics of the table of contents and the keyword index */
+    if (_DtHelpCeGetTopTopicId(bld->vol, &topId) == True && topId != NULL)
+	WalkTopics(&bld->b, bld->vol, topId);
+    free(topId);
+    if (_DtHelpCeGetKeywordList(bld->vol, &keywords) > 0 && keywords != NULL)
+	for (; *keywords != NULL; keywords++)
+	    if (_DtHelpCeFindKeyword(bld->vol, *keywords, &ids) > 0)
+		for (; *ids != NULL; ids++)
+		    WalkTopics(&bld->b, bld->vol, *ids);
+
+    return bld;
+}
+
+/******************************************************************************
+ * Function: int _DtHelpTextIndexBuildStep (_DtHelpTextIndexBuilder bld,
+ *					int count)
+ *
+ * Parameters:	bld		Specifies the build.
+ *		count		Specifies how many topics to index.
+ *
+ * Returns:	1 if there are topics left, 0 if the index has been
+ *		written, -1 if an error occurred.
+ *
+ * Purpose:	Indexes the text and titles of the next count topics.
+ *		The text is formatted as for a terminal, in the codeset
+ *		of the locale.  Writes the index after the last topic.
+ ******************************************************************************/
+int
+_DtHelpTextIndexBuildStep (
+    _DtHelpTextIndexBuilder	 bld,
+    int				 count)
+{
+    TixBuild	 *b = &bld->b;
+    char	**helpList;
+    char	**line;
+    char	 *title;
+    char	 *ptr;
+    size_t	  len;
+    unsigned int  i;
+
+    for (; count > 0 && b->curTopic < b->topicCount; count--, b->curTopic++)
+      {
+	i = b->curTopic;
+
+	title = NULL;
+	if (_DtHelpGetTopicTitle(bld->vol, b->topics[i]->id, &title) == 0 &&
+	    title != NULL && bld->iconvContext != NULL)
+	  {
+	    /* iconv(3) needs an output buffer to start with */
+	    len = strlen(title) + 1;
+	    ptr = (char *) malloc(len);
+	    if (ptr != NULL && _DtHelpCeIconvStr(bld->iconvContext, title, &ptr,
+						 &len, ptr, len) == 0)
+	      {
+		free(title);
+		title = ptr;
+	      }
+	    else
+		free(ptr);
+	  }
+	b->topics[i]->title = (title ? title : strdup(b->topics[i]->id));
+	if (b->topics[i]->title == NULL)
+	    return -1;
+
+	b->curWeight = TIX_TITLE_WEIGHT;
+	ForEachWord(b->topics[i]->title, AddWord, b);
+
+	helpList = NULL;
+	if (_DtHelpTermGetTopicData(TixCanvas, bld->vol, b->topics[i]->id,
+				    &helpList, NULL) == 0 && helpList != NULL)
+	  {
+	    b->curWeight = 1;
+	    for (line = helpList; *line != NULL; line++)
+		ForEachWord(*line, AddWord, b);
+	  }
+	_DtHelpFreeTopicData(helpList, NULL);
+      }
+
+    if (b->curTopic < b->topicCount)
+	return 1;
+
+    return WriteIndex(b, bld->idxPath, bld->volPath, bld->codeset,
+		      &bld->volStat);
+}
+
+/******************************************************************************
+ * Function: void _DtHelpTextIndexBuildEnd (_DtHelpTextIndexBuilder bld)
+ *
+ * Purpose:	Frees a build, finished or not.
+ ******************************************************************************/
+void
+_DtHelpTextIndexBuildEnd (
+    _DtHelpTextIndexBuilder	 bld)
+{
+    TixBuild	 *b;
+    TixWord	 *w, *nextW;
+    unsigned int  i;
+
+    if (bld == NULL)
+	return;
+
+    b = &bld->b;
+    for (i = 0; i < b->wordHashSz; i++)
+	for (w = b->wordHash[i]; w != NULL; w = nextW)
+	  {
+	    nextW = w->next;
+	    free(w->word);
+	    free(w->posts);
+	    free(w);
+	  }
+    free(b->wordHash);
+    for (i = 0; i < b->topicCount; i++)
+      {
+	free(b->topics[i]->id);
+	free(b->topics[i]->title);
+	free(b->topics[i]);
+      }
+    free(b->topics);
+    _DtHelpCeIconvClose(&bld->iconvContext);
+    free(bld->volCodeset);
+    free(bld->codeset);
+    free(bld->volPath);
+    _DtHelpCloseVolume(bld->vol);
+    free(bld);
+}
+
+/******************************************************************************
+ * Function: int _DtHelpTextIndexBuild (char *volPath, char *idxPath)
+ *
+ * Parameters:	volPath		Specifies the path of the volume.
+ *		idxPath		Specifies the index file to write, or NULL.
+ *
+ * Returns:	0 if successful, -1 if not.
+ *
+ * Purpose:	Indexes a volume in one go.
+ ******************************************************************************/
+int
+_DtHelpTextIndexBuild (
+    const char	*volPath,
+    const char	*idxPath)
+{
+    _DtHelpTextIndexBuilder bld;
+    int			    result;
+
+    if ((bld = _DtHelpTextIndexBuildStart(volPath, idxPath)) == NULL)
+	return -1;
+    result = _DtHelpTextIndexBuildStep(bld, INT_MAX);
+    _DtHelpTextIndexBuildEnd(bld);
+    return result;
+}
+
+/******************************************************************************
+ * Function: _DtHelpTextIndex _DtHelpTextIndexOpen (char *volPath, int build)
+ *
+ * Parameters:	volPath		Specifies the path of the volume.
+ *		build		Specifies whether to index the volume
+ *				if it has no usable index.
+ *
+ * Returns:	The index, or NULL if the volume has none.
+ *
+ * Purpose:	Finds and maps the index of a volume.  A built index
+ *		is written next to the volume if its directory can be
+ *		written, else to the user's index directory.
+ ******************************************************************************/
+_DtHelpTextIndex
+_DtHelpTextIndexOpen (
+    const char	*volPath,
+    int		 build)
+{
+    _DtHelpTextIndex	 index;
+    _DtHelpTextIndexBuilder bld;
+    struct stat		 volStat;
+    char		*codeset = NULL;
+    char		 path[MAXPATHLEN + 1];
+
+    if (volPath == NULL || stat(volPath, &volStat) == -1)
+	return NULL;
+
+    _DtHelpCeGetLcCtype(NULL, NULL, &codeset);
+    if (codeset == NULL)
+	return NULL;
+
+    snprintf(path, sizeof(path), "%s%s", volPath, DtHelpTEXT_INDEX_EXT);
+    index = MapIndex(path, volPath, codeset, &volStat);
+
+    if (index == NULL && UserIndexPath(volPath, codeset, False, path) == 0)
+	index = MapIndex(path, volPath, codeset, &volStat);
+
+    if (index == NULL && build &&
+	(bld = _DtHelpTextIndexBuildStart(volPath, NULL)) != NULL)
+      {
+	if (_DtHelpTextIndexBuildStep(bld, INT_MAX) == 0)
+	    index = MapIndex(bld->idxPath, volPath, codeset, &volStat);
+	_DtHelpTextIndexBuildEnd(bld);
+      }
+
+    free(codeset);
+    return index;
+}
+
+/******************************************************************************
+ * Function: void _DtHelpTextIndexClose (_DtHelpTextIndex index)
+ *
+ * Purpose:	Unmaps an index.  The strings of its hits become invalid.
+ ******************************************************************************/
+void
+_DtHelpTextIndexClose (
+    _DtHelpTextIndex	 index)
+{
+    if (index == NULL)
+	return;
+
+    munmap(index->map, index->mapLen);
+    free(index);
+}
+
+/******************************************************************************
+ * Function: int _DtHelpTextIndexSearch (_DtHelpTextIndex index,
+ *					char *words, _DtHelpTextHit **ret_hits)
+ *
+ * Parameters:	index		Specifies the index of the volume.
+ *		words		Specifies the words to look for, in the
+ *				codeset of the locale.
+ *		ret_hits	Returns the topics found, best first.
+ *				The array must be freed by the caller;
+ *				its strings belong to the index.
+ *
+ * Returns:	The number of topics found, -1 if an error occurred.
+ *
+ * Purpose:	Finds the topics containing all of the words, each
+ *		as the beginning of a word of the topic or its title.
+ *		A topic scores more for words that occur more often
+ *		in it and in fewer other topics, and in its title.
+ ******************************************************************************/
+int
+_DtHelpTextIndexSearch (
+    _DtHelpTextIndex	  index,
+    const char		 *words,
+    _DtHelpTextHit	**ret_hits)
+{
+    TixTerms		 terms;
+    _DtHelpTextHit	*hits;
+    const uint32_t	*posts;
+    unsigned int	*scores;
+    unsigned int	*masks;
+    unsigned int	 all;
+    unsigned int	 count;
+    unsigned int	 idf;
+    unsigned int	 topic;
+    unsigned int	 lo, hi, mid;
+    unsigned int	 w, p, t;
+    size_t		 len;
+    int			 i;
+    int			 result = -1;
+
+    if (ret_hits != NULL)
+	*ret_hits = NULL;
+    if (index == NULL || words == NULL || ret_hits == NULL)
+	return -1;
+
+    terms.count = 0;
+    ForEachWord(words, AddTerm, &terms);
+    if (terms.count == 0 || index->topicCount == 0)
+      {
+	result = 0;
+	goto done;
+      }
+
+    scores = (unsigned int *) calloc(index->topicCount, sizeof(unsigned int));
+    masks  = (unsigned int *) calloc(index->topicCount, sizeof(unsigned int));
+    if (scores == NULL || masks == NULL)
+      {
+	free(scores);
+	free(masks);
+	goto done;
+      }
+
+    for (i = 0; i < terms.count; i++)
+      {
+	/* find the first word not less than the term */
+	len = strlen(terms.terms[i]);
+	lo  = 0;
+	hi  = index->wordCount;
+	while (lo < hi)
+	  {
+	    mid = (lo + hi) / 2;
+	    if (strcmp(IndexStr(index, index->words[3 * mid]), terms.terms[i]) < 0)
+		lo = mid + 1;
+	    else
+		hi = mid;
+	  }
+
+	/* and score the topics of all words it begins */
+	for (w = lo; w < index->wordCount &&
+		strncmp(IndexStr(index, index->words[3 * w]),
+			terms.terms[i], len) == 0; w++)
+	  {
+	    if ((posts = Postings(index, w, &count)) == NULL || count == 0)
+		continue;
+	    idf = 1 + Log2((index->topicCount << 4) / count);
+	    for (p = 0; p < count; p++)
+	      {
+		topic = ntohl(posts[2 * p]);
+		if (topic >= index->topicCount)
+		    continue;
+		scores[topic] += (1 + Log2(ntohl(posts[2 * p + 1]))) * idf;
+		masks[topic]  |= 1u << i;
+	      }
+	  }
+      }
+
+    /* keep the topics with all of the words */
+    all = (terms.count == 32 ? ~0u : (1u << terms.count) - 1);
+    for (t = 0, count = 0; t < index->topicCount; t++)
+	if (masks[t] == all)
+	    count++;
+
+    hits = NULL;
+    if (count > 0 &&
+	(hits = (_DtHelpTextHit *) malloc(count * sizeof(_DtHelpTextHit))) == NULL)
+	count = 0;
+    for (t = 0, count = 0; hits != NULL && t < index->topicCount; t++)
+	if (masks[t] == all)
+	  {
+	    hits[count].topicId = IndexStr(index, index->topics[3 * t]);
+	    hits[count].title   = IndexStr(index, index->topics[3 * t + 1]);
+	    hits[count].score   = scores[t];
+	    count++;
+	  }
+    if (count > 1)
+	qsort(hits, count, sizeof(_DtHelpTextHit), CompareHits);
+
+    free(scores);
+    free(masks);
+    *ret_hits = hits;
+    result = (int) count;
+
+done:
+    for (i = 0; i < terms.count; i++)
+	free(terms.terms[i]);
+    return result;
+}
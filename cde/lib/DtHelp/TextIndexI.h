@@ -0,0 +1,72 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/************************************<+>*************************************
+ ****************************************************************************
+ **
+ **   File:        TextIndexI.h
+ **
+ **   Project:     DtHelp Project
+ **
+ **   Description: Full text index of the topics of a help volume
+ **
+ ****************************************************************************
+ ************************************<+>*************************************/
+#ifndef _TextIndexI_h
+#define _TextIndexI_h
+
+/* file name extension of an index stored next to its volume */
+#define	DtHelpTEXT_INDEX_EXT	".tix"
+
+typedef struct _DtHelpTextIndexRec * _DtHelpTextIndex;
+typedef struct _DtHelpTextIndexBuildRec * _DtHelpTextIndexBuilder;
+
+/* one topic found by _DtHelpTextIndexSearch() */
+typedef struct {
+  const char *    topicId;     /* location id of the topic */
+  const char *    title;       /* title of the topic, in the locale codeset */
+  unsigned int    score;       /* higher is better */
+} _DtHelpTextHit;
+
+extern	int		 _DtHelpTextIndexBuild (
+				const char	*volPath,
+				const char	*idxPath);
+extern	void		 _DtHelpTextIndexBuildEnd (
+				_DtHelpTextIndexBuilder bld);
+extern	_DtHelpTextIndexBuilder _DtHelpTextIndexBuildStart (
+				const char	*volPath,
+				const char	*idxPath);
+extern	int		 _DtHelpTextIndexBuildStep (
+				_DtHelpTextIndexBuilder bld,
+				int		 count);
+extern	void		 _DtHelpTextIndexClose (
+				_DtHelpTextIndex  index);
+extern	_DtHelpTextIndex _DtHelpTextIndexOpen (
+				const char	*volPath,
+				int		 build);
+extern	int		 _DtHelpTextIndexSearch (
+				_DtHelpTextIndex  index,
+				const char	 *words,
+				_DtHelpTextHit	**ret_hits);
+
+#endif /* _TextIndexI_h */
+/* DON'T ADD ANYTHING AFTER THIS #endif */
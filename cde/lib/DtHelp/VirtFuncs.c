@@ -69,6 +69,10 @@
 /*****************************************************************************
  *		Private Defines
  *****************************************************************************/
+/*
+ * the number of text run widths a canvas remembers.  A power of two.
+ */
+#define	WIDTH_CACHE_SIZE	1024
 /*****************************************************************************
  *		Private Variables
  *****************************************************************************/
@@ -99,12 +103,32 @@ _DtCvGetStringWidth (
 {
     _DtCvUnit	result = -1;
     _DtCvStringInfo strInfo;
+    _DtCvWidthCache *entry = NULL;
 
     strInfo.string   = string;
     strInfo.byte_len = len;
     strInfo.wc       = _DtCvIsSegWideChar(segment);
     strInfo.font_ptr = _DtCvFontOfStringSeg(segment);
 
+    /*
+     * the layout measures the same runs over again for every
+     * resize.  A run is known by where it starts in its segment,
+     * its length and its font, none of which change while the
+     * topic is on the canvas.
+     */
+    if (NULL == canvas->width_cache)
+	canvas->width_cache = (_DtCvWidthCache *) calloc (WIDTH_CACHE_SIZE,
+						sizeof(_DtCvWidthCache));
+    if (NULL != canvas->width_cache)
+      {
+	entry = &(canvas->width_cache[((((unsigned long) string) >> 2)
+				^ (((unsigned long) strInfo.font_ptr) << 3)
+				^ (len * 31)) & (WIDTH_CACHE_SIZE - 1)]);
+	if (entry->string   == string && entry->byte_len == len &&
+	    entry->font_ptr == strInfo.font_ptr && entry->wc == strInfo.wc)
+	    return entry->width;
+      }
+
     if (canvas->virt_functions.get_width != NULL)
 	result = (*(canvas->virt_functions.get_width)) (
 			canvas->client_data, _DtCvSTRING_TYPE,
@@ -112,10 +136,40 @@ _DtCvGetStringWidth (
     if (result <= 0)
 	result = 1;
 
+    if (NULL != entry)
+      {
+	entry->string   = string;
+	entry->byte_len = len;
+	entry->font_ptr = strInfo.font_ptr;
+	entry->wc       = strInfo.wc;
+	entry->width    = result;
+      }
+
     return result;
 
 } /* End _DtCvGetStringWidth */
 
+/******************************************************************************
+ * Function:    void _DtCvClearWidthCache (_DtCanvasStruct *canvas)
+ *
+ * Parameters:
+ *
+ * Returns:
+ *
+ * Purpose:	Forget the text widths measured.  Needed whenever the
+ *		strings of the canvas or the fonts behind them change.
+ *
+ *****************************************************************************/
+void
+_DtCvClearWidthCache (
+    _DtCanvasStruct      *canvas)
+{
+    if (NULL != canvas->width_cache)
+	memset ((void *) canvas->width_cache, 0,
+			sizeof(_DtCvWidthCache) * WIDTH_CACHE_SIZE);
+
+} /* End _DtCvClearWidthCache */
+
 /******************************************************************************
  * Function:    void _DtCvFontMetrics (_DtCanvasStruct canvas,
  *
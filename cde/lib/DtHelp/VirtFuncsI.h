@@ -59,6 +59,8 @@ extern "C" {
 
 /********    Private Function Declarations    ********/
 
+extern	void		_DtCvClearWidthCache(
+				_DtCanvasStruct	*canvas);
 extern	void		_DtCvFontMetrics(
 				_DtCanvasStruct	*canvas,
 				_DtCvPointer	 font_handle,
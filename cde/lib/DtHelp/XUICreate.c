@@ -494,6 +494,7 @@ HelpCreateDA(
     pDAS->vertIsMapped  = False;
     pDAS->horzIsMapped  = False;
     pDAS->lst_topic     = NULL;
+    pDAS->topic_cache   = NULL;
     pDAS->nextNonVisible = 0;
     pDAS->media_resolution = media_resolution;
     pDAS->honor_size = honor_size;
@@ -0,0 +1,497 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/************************************<+>*************************************
+ ****************************************************************************
+ **
+ **   File:	   canvasbench.c
+ **
+ **   Project:     CDE Help System
+ **
+ **   Description: Times re-laying out help topics on a canvas while
+ **		   its width is dragged, the way a help window is
+ **		   resized, with and without the measured text and
+ **		   line break tables kept with the canvas.
+ **
+ **		   usage: canvasbench [scale [seed]]
+ **
+ **		   The topic set is made up here, so no help volume or
+ **		   display is needed:
+ **		     prose   long paragraphs of mixed font runs
+ **		     lists   nested, indented list items
+ **		     tables  four column tables of short cells
+ **		   scale multiplies the size of every topic (default 1).
+ **		   Text is measured with a per character width table,
+ **		   as XTextWidth() does for a core font.
+ **
+ ****************************************************************************
+ ************************************<+>*************************************/
+
+/*
+ * system includes
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/*
+ * Canvas Engine includes
+ */
+#include "CanvasP.h"
+#include "CanvasSegP.h"
+
+/******************************************************************************
+ *
+ * Private variables and defines.
+ *
+ *****************************************************************************/
+#define	MAX_WIDTH	800	/* canvas width at the start of a drag */
+#define	MIN_WIDTH	500	/* narrowest width of the drag         */
+#define	DRAG_STEP	6	/* width change between two re-layouts */
+
+#define	FONT_REGULAR	((_DtCvPointer) 1)
+#define	FONT_BOLD	((_DtCvPointer) 2)
+
+typedef	struct {
+	_DtCvUnit	width;
+	long		measured;	/* calls to BenchStrWidth */
+} BenchInfo;
+
+static	_DtCvUnit	CharWidth[2][256];
+
+static	const char	*Words[] =
+  {
+    "the", "help", "volume", "topic", "window", "canvas", "resize",
+    "paragraph", "table", "cell", "column", "font", "hypertext", "link",
+    "display", "widget", "a", "of", "to", "in", "is", "and", "for", "on",
+    "with", "internationalization", "configuration", "DtHelpDialog",
+    "XmNwidth", "application", "desktop", "manager", "session", "action",
+    "datatype", "icon", "file", "directory", "selection", "traversal",
+  };
+#define	NUM_WORDS	(sizeof(Words) / sizeof(Words[0]))
+
+/******************************************************************************
+ *
+ * Canvas functions
+ *
+ *****************************************************************************/
+static	void
+BenchMetrics (
+    _DtCvPointer	client_data,
+    _DtCvElemType	elem_type,
+    _DtCvPointer	ret_metrics)
+{
+    BenchInfo *info = (BenchInfo *) client_data;
+
+    if (_DtCvCANVAS_TYPE == elem_type)
+      {
+	_DtCvMetrics *retCanvas = (_DtCvMetrics *) ret_metrics;
+
+        retCanvas->width          = info->width;
+        retCanvas->height         = 600;
+	retCanvas->top_margin     = 5;
+	retCanvas->side_margin    = 5;
+	retCanvas->line_height    = 15;
+	retCanvas->horiz_pad_hint = 7;
+      }
+    else if (_DtCvLOCALE_TYPE == elem_type)
+      {
+	_DtCvLocale *retLocale = (_DtCvLocale *) ret_metrics;
+
+	retLocale->line_wrap_mode   = _DtCvModeWrapNone;
+	retLocale->cant_begin_chars = NULL;
+	retLocale->cant_end_chars   = NULL;
+      }
+    else if (_DtCvLINK_TYPE == elem_type || _DtCvTRAVERSAL_TYPE == elem_type)
+	memset(ret_metrics, 0, sizeof(_DtCvSpaceMetrics));
+}
+
+static	void
+BenchRenderElem (
+    _DtCvPointer	client_data,
+    _DtCvElemType	elem_type,
+    _DtCvUnit		x,
+    _DtCvUnit		y,
+    int			link_type,
+    _DtCvFlags		old_flags,
+    _DtCvFlags		new_flags,
+    _DtCvElemType	trav_type,
+    _DtCvPointer	trav_data,
+    _DtCvPointer	data)
+{
+}
+
+static	_DtCvUnit
+BenchStrWidth (
+    _DtCvPointer	client_data,
+    _DtCvElemType	elem_type,
+    _DtCvPointer	data)
+{
+    _DtCvStringInfo	*strInfo = (_DtCvStringInfo *) data;
+    const unsigned char	*str;
+    _DtCvUnit		*widths;
+    _DtCvUnit		 width = 0;
+    int			 i;
+
+    if (elem_type != _DtCvSTRING_TYPE)
+	return 0;
+
+    ((BenchInfo *) client_data)->measured++;
+    widths = CharWidth[FONT_BOLD == strInfo->font_ptr];
+    str    = (const unsigned char *) strInfo->string;
+    for (i = 0; i < strInfo->byte_len; i++)
+	width += widths[str[i]];
+
+    return width;
+}
+
+static	void
+BenchFontMetrics (
+    _DtCvPointer	 client_data,
+    _DtCvPointer	 font_ptr,
+    _DtCvUnit		*ret_ascent,
+    _DtCvUnit		*ret_descent,
+    _DtCvUnit		*char_width,
+    _DtCvUnit		*ret_super,
+    _DtCvUnit		*ret_sub)
+{
+    if (ret_ascent)
+	*ret_ascent = 11;
+    if (ret_descent)
+	*ret_descent = 3;
+    if (char_width)
+	*char_width = 7;
+    if (ret_super)
+	*ret_super = 4;
+    if (ret_sub)
+	*ret_sub = 3;
+}
+
+static _DtCvVirtualInfo	BenchVirtInfo =
+  {
+	BenchMetrics,		/* void      (*_DtCvGetMetrics)(); */
+	BenchRenderElem,	/* void      (*_DtCvRenderElem)(); */
+	BenchStrWidth,		/* _DtCvUnit (*_DtCvGetElemWidth)(); */
+	BenchFontMetrics,	/* void      (*_DtCvGetFontMetrics)(); */
+	NULL,			/* _DtCvStatus   (*_DtCvBuildSelection)(); */
+	NULL,			/* _DtCvStatus   (*_DtCvFilterExecCmd)(); */
+  };
+
+/******************************************************************************
+ *
+ * Topic set
+ *
+ *****************************************************************************/
+static	_DtCvSegment *
+NewContainer (
+    char	*id,
+    _DtCvUnit	 lmargin,
+    _DtCvFrmtOption flow)
+{
+    _DtCvSegment *seg = (_DtCvSegment *) calloc (1, sizeof(_DtCvSegment));
+
+    seg->type     = _DtCvCONTAINER;
+    seg->link_idx = -1;
+    _DtCvContainerIdOfSeg(seg)      = id;
+    _DtCvContainerTypeOfSeg(seg)    = _DtCvDYNAMIC;
+    _DtCvContainerBorderOfSeg(seg)  = _DtCvBORDER_NONE;
+    _DtCvContainerJustifyOfSeg(seg) = _DtCvJUSTIFY_LEFT;
+    _DtCvContainerVJustifyOfSeg(seg) = _DtCvJUSTIFY_TOP;
+    _DtCvContainerOrientOfSeg(seg)  = _DtCvJUSTIFY_LEFT_MARGIN;
+    _DtCvContainerVOrientOfSeg(seg) = _DtCvJUSTIFY_TOP;
+    _DtCvContainerFlowOfSeg(seg)    = flow;
+    _DtCvContainerLMarginOfSeg(seg) = lmargin;
+    _DtCvContainerBMarginOfSeg(seg) = 5;
+
+    return seg;
+}
+
+/*
+ * a paragraph of 'words' words, in runs of regular and bold text.
+ */
+static	_DtCvSegment *
+NewParagraph (
+    char	*id,
+    _DtCvUnit	 lmargin,
+    int		 words)
+{
+    _DtCvSegment  *para = NewContainer(id, lmargin, _DtCvWRAP);
+    _DtCvSegment **next = &_DtCvContainerListOfSeg(para);
+    _DtCvSegment  *seg  = NULL;
+    char	   buf[4096];
+    int		   len;
+    int		   run;
+
+    while (0 < words)
+      {
+	run = 1 + rand() % 12;
+	if (run > words)
+	    run = words;
+	words -= run;
+
+	for (len = 0; 0 < run && len < sizeof(buf) - 32; run--)
+	  {
+	    strcpy(&buf[len], Words[rand() % NUM_WORDS]);
+	    len += strlen(&buf[len]);
+	    if (0 < run - 1 || 0 < words)
+	        buf[len++] = ' ';
+	  }
+	buf[len] = '\0';
+
+	seg = (_DtCvSegment *) calloc (1, sizeof(_DtCvSegment));
+	seg->type     = _DtCvSTRING;
+	seg->link_idx = -1;
+	_DtCvStringOfStringSeg(seg) = strdup(buf);
+	_DtCvFontOfStringSeg(seg)   = (0 == rand() % 6) ? FONT_BOLD
+							: FONT_REGULAR;
+	*next = seg;
+	next  = &_DtCvNextSeg(seg);
+      }
+
+    if (NULL != seg)
+	seg->type = _DtCvSetTypeToNewLine(seg->type);
+
+    return para;
+}
+
+static	_DtCvSegment *
+ProseTopic (
+    int		 scale)
+{
+    _DtCvSegment  *list = NULL;
+    _DtCvSegment **next = &list;
+    int		   i;
+
+    for (i = 0; i < 1500 * scale; i++)
+      {
+	*next = NewParagraph(NULL, 0, 20 + rand() % 140);
+	next  = &_DtCvNextSeg(*next);
+      }
+
+    return list;
+}
+
+static	_DtCvSegment *
+ListsTopic (
+    int		 scale)
+{
+    _DtCvSegment  *list = NULL;
+    _DtCvSegment **next = &list;
+    int		   i;
+
+    for (i = 0; i < 2000 * scale; i++)
+      {
+	*next = NewParagraph(NULL, 20 * (1 + rand() % 3), 5 + rand() % 40);
+	next  = &_DtCvNextSeg(*next);
+      }
+
+    return list;
+}
+
+static	_DtCvSegment *
+TablesTopic (
+    int		 scale)
+{
+    static const char *colW[] = { "1", "2", "1", "3", NULL };
+    _DtCvSegment  *list = NULL;
+    _DtCvSegment **next = &list;
+    _DtCvSegment  *table;
+    _DtCvSegment **cells;
+    char	 **cellIds;
+    char	   id[32];
+    char	   row_ids[128];
+    int		   numCols = 4;
+    int		   numRows = 25;
+    int		   t, r, c;
+
+    for (t = 0; t < 40 * scale; t++)
+      {
+	/* an introduction for each table */
+	*next = NewParagraph(NULL, 0, 30 + rand() % 40);
+	next  = &_DtCvNextSeg(*next);
+
+	cells   = (_DtCvSegment **) calloc (numRows * numCols + 1,
+						sizeof(_DtCvSegment *));
+	cellIds = (char **) calloc (numRows + 1, sizeof(char *));
+	for (r = 0; r < numRows; r++)
+	  {
+	    row_ids[0] = '\0';
+	    for (c = 0; c < numCols; c++)
+	      {
+		sprintf(id, "t%dr%dc%d", t, r, c);
+		cells[r * numCols + c] = NewParagraph(strdup(id), 0,
+							1 + rand() % 20);
+		if (0 < c)
+		    strcat(row_ids, " ");
+		strcat(row_ids, id);
+	      }
+	    /* the layout writes into the id strings */
+	    cellIds[r] = strdup(row_ids);
+	  }
+
+	table = (_DtCvSegment *) calloc (1, sizeof(_DtCvSegment));
+	table->type     = _DtCvTABLE;
+	table->link_idx = -1;
+	_DtCvNumColsOfTableSeg(table) = numCols;
+	_DtCvColWOfTableSeg(table)    = (char **) colW;
+	_DtCvCellIdsOfTableSeg(table) = cellIds;
+	_DtCvCellsOfTableSeg(table)   = cells;
+
+	*next = table;
+	next  = &_DtCvNextSeg(table);
+      }
+
+    return list;
+}
+
+/******************************************************************************
+ *
+ * Benchmark
+ *
+ *****************************************************************************/
+static	double
+Seconds (void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*
+ * drag the width from MAX_WIDTH to MIN_WIDTH and back, re-laying out
+ * at every step.  Returns the time taken and the heights laid out.
+ */
+static	double
+DragWidth (
+    _DtCvHandle	 canvas,
+    BenchInfo	*info,
+    _DtCvValue	 force,
+    _DtCvUnit	*heights,
+    int		*steps)
+{
+    _DtCvUnit	 width;
+    int		 n = 0;
+    int		 dir = -1;
+    double	 start = Seconds();
+
+    info->width = MAX_WIDTH;
+    do
+      {
+	info->width += dir * DRAG_STEP;
+	if (info->width <= MIN_WIDTH)
+	    dir = 1;
+	_DtCanvasResize(canvas, force, &width, &heights[n++]);
+      } while (info->width < MAX_WIDTH);
+
+    *steps = n;
+    return Seconds() - start;
+}
+
+int
+main (
+    int		 argc,
+    char	**argv)
+{
+    static const struct {
+	const char	 *name;
+	_DtCvSegment	*(*make)(int);
+    } topics[] =
+      {
+	{ "prose",  ProseTopic  },
+	{ "lists",  ListsTopic  },
+	{ "tables", TablesTopic },
+      };
+    _DtCvUnit	heights[2][2 * (MAX_WIDTH - MIN_WIDTH) / DRAG_STEP + 2];
+    _DtCvTopicInfo topic;
+    _DtCvHandle	canvas;
+    BenchInfo	info;
+    double	cached, uncached;
+    long	cachedCnt, uncachedCnt;
+    int		scale = 1;
+    int		seed  = 1;
+    int		steps;
+    int		failed = 0;
+    int		i, c;
+
+    if (argc > 1)
+	scale = atoi(argv[1]);
+    if (argc > 2)
+	seed = atoi(argv[2]);
+    if (scale < 1)
+      {
+	fprintf(stderr, "usage: %s [scale [seed]]\n", argv[0]);
+	return 2;
+      }
+
+    for (c = 0; c < 256; c++)
+      {
+	CharWidth[0][c] = 4 + (c * 7) % 5;
+	CharWidth[1][c] = CharWidth[0][c] + 1;
+      }
+
+    printf("width %d..%d in steps of %d, scale %d, seed %d\n",
+			MIN_WIDTH, MAX_WIDTH, DRAG_STEP, scale, seed);
+    printf("%-8s %8s %21s %25s\n", "", "",
+			"ms per layout", "widths measured per layout");
+    printf("%-8s %8s %10s %10s %12s %12s\n", "topic", "layouts",
+			"cached", "uncached", "cached", "uncached");
+
+    for (i = 0; i < sizeof(topics) / sizeof(topics[0]); i++)
+      {
+	srand(seed);
+	memset(&topic, 0, sizeof(topic));
+	topic.seg_list = (*topics[i].make)(scale);
+
+	info.width = MAX_WIDTH;
+	canvas = _DtCanvasCreate(BenchVirtInfo, (_DtCvPointer) &info);
+	_DtCanvasSetTopic(canvas, &topic, _DtCvFALSE, NULL, NULL, NULL);
+
+	/*
+	 * a forced re-layout clears the tables kept with the canvas
+	 * first, which is what every re-layout cost without them.
+	 */
+	info.measured = 0;
+	uncached    = DragWidth(canvas, &info, _DtCvTRUE, heights[0], &steps);
+	uncachedCnt = info.measured;
+
+	info.measured = 0;
+	cached    = DragWidth(canvas, &info, _DtCvFALSE, heights[1], &steps);
+	cachedCnt = info.measured;
+
+	if (memcmp(heights[0], heights[1], steps * sizeof(_DtCvUnit)) != 0)
+	  {
+	    fprintf(stderr, "%s: cached and uncached layouts differ\n",
+							topics[i].name);
+	    failed = 1;
+	  }
+
+	printf("%-8s %8d %10.2f %10.2f %12ld %12ld\n", topics[i].name, steps,
+			cached * 1000 / steps, uncached * 1000 / steps,
+			cachedCnt / steps, uncachedCnt / steps);
+
+	_DtCanvasDestroy(canvas);
+      }
+
+    return failed;
+}
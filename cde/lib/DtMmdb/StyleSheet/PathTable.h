@@ -110,6 +110,7 @@ public:
    unsigned int operator==(const PathFeature&) const;
 
    unsigned int match(SSPath& p);
+   unsigned int match(SSPath& p, EncodedPath& ep);
 };
 
 class PathFeatureList : public CC_TPtrDlist<PathFeature> 
@@ -133,6 +134,20 @@ typedef CC_TPtrDlistIterator<PathFeature> PathFeatureListIterator;
 
 typedef CC_TPtrDlist<PathFeature>* CC_TPtrDlist_PathFeature_Ptr_T;
 
+// resolved paths, keyed by the symbol ids of the element path.
+// Only used when none of the candidate rules has a selector,
+// since the result then depends on nothing else.
+#define PATH_CACHE_SIZE 1024
+
+class PathCacheEntry
+{
+public:
+   LetterType* f_letters;
+   int f_size;
+   unsigned int f_hash;
+   FeatureSet* f_featureSet;
+};
+
 class PathTable
 {
 public:
@@ -157,17 +172,27 @@ public:
 // deleting the object
   FeatureSet* getFeatureSet(SSPath&);
 
+// turn the resolved path cache on or off (for testing); clears it
+  void usePathCache(unsigned int);
+
   friend ostream& operator<<(ostream&, PathTable&);
 
 private:
   CC_TPtrDlist<PathFeature> f_pathFeatureList;
   CC_TPtrDlist_PathFeature_Ptr_T *f_lastSymIndex;
   unsigned int		    f_lastSymIndexCount ;
+  char*			    f_lastSymHasSelector ;
+
+  PathCacheEntry*	    f_pathCache ;
+  unsigned int		    f_usePathCache ;
+  LetterType*		    f_letterBuf ;
+  int			    f_letterBufSize ;
 
 private:
   void initLastSymIndex();
+  void clearPathCache();
   unsigned int findIndex(SSPath&);
-  FeatureSet* getFeatureSet(int bucketIndex, SSPath&, int& pathId);
+  FeatureSet* getFeatureSet(int bucketIndex, SSPath&, EncodedPath*&, int& pathId);
 };
 
 extern PathTable* gPathTab;
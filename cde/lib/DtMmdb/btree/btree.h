@@ -74,6 +74,13 @@
 #include "dstr/index_agent.h"
 
 
+// an insert held back in batch mode
+struct btree_put {
+   char*   key;
+   size_t  key_size;
+   voidPtr dt;
+};
+
 class btree : public index_agent
 {
 
@@ -87,6 +94,10 @@ public:
    Boolean remove(data_t& w);
    Boolean member(data_t& w);
 
+// group inserts into few large transactions
+   void batch_begin();
+   void batch_end();
+
    ostream& asciiOut(ostream& out);
    istream& asciiIn(istream& in);
 
@@ -95,10 +106,18 @@ protected:
    MDB_dbi btree_DB;
    MDB_env *btree_env;
 
+// batch mode state, v_batch is 0 outside batch mode
+   btree_put* v_batch;
+   unsigned int* v_batch_hash;   // v_batch index + 1, 0 if free
+   unsigned int v_batch_cnt;
+
 protected:
    void data_t_2_DBT(data_t& w);
    MDB_txn *txn_begin(unsigned int flags = 0);
    void txn_commit(MDB_txn *txn);
+   void grow_map();
+   unsigned int *batch_slot(const MDB_val& key);
+   void batch_flush();
 };
 
 #endif
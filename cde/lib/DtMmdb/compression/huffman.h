@@ -73,6 +73,21 @@ public:
 };
 
 
+////////////////////////////////////////
+// decode table: the next HUFF_LUT_BITS bits
+// of the input either finish a code (eu set,
+// bits = code length) or lead to an inner
+// node from where decoding goes on bitwise.
+////////////////////////////////////////
+#define HUFF_LUT_BITS 10
+
+struct huff_lut_entry
+{
+   encoding_unit* eu;
+   htr_node* node;
+   unsigned char bits;
+};
+
 ////////////////////////////////////////
 //
 ////////////////////////////////////////
@@ -85,9 +100,15 @@ protected:
    trie* tri;
    htr_node* htr_root;
 
+   huff_lut_entry* lut;
+   unsigned int* v_words;
+   int v_words_sz;
+
 protected:
    void build_tree();
    void calculate_code();
+   void build_lut();
+   void decompress_bitwise(buffer& compressed, buffer& uncompressed) ;
    encoding_unit* get_e_unit(unsigned char*& data, int len);
 
 public:
@@ -70,6 +70,9 @@ public:
    virtual Boolean member(data_t& v) = 0; // member test
    virtual void clean() = 0; 		   // remove all keys
 
+   virtual void batch_begin() {};      // many inserts follow
+   virtual void batch_end() {};        // done with them
+
    virtual int no_keys() const { return n; }; // return key set size
 
    virtual ostream& asciiOut(ostream& out) = 0;
@@ -110,7 +110,7 @@ public:
 
 protected:
    int chunk_sz;
-   int chunks;
+   int chunks;        // chunks in the next carrier
    dlist chunk_carrier_list;
    dlist free_chunk_list;
 
@@ -133,9 +133,58 @@ public:
 // free a char*
    virtual void free(char*); 
 
+// allocation counters
+   int allocs() const { return f_allocs; };
+   int frees() const { return f_frees; };
+   int bytes_in_use() const { return f_bytes_in_use; };
+
+   ostream& print_stats(ostream&);
+
 protected:
    int max_alloc_size_from_pool;
    vm_pool_array_t vm_pool_vector; 
+
+   int f_allocs;
+   int f_frees;
+   int f_bytes_in_use;
+};
+
+//////////////////////////////////////////////////////
+// A pool of equal sized objects. Objects are carved
+// from slabs that double in size as the pool grows, 
+// and freed objects are chained through their first 
+// word, so there is no per object overhead.
+//////////////////////////////////////////////////////
+class slab_pool
+{
+
+public:
+   slab_pool(int obj_sz);
+   virtual ~slab_pool();
+
+   char* alloc();
+   void free(char*); 
+
+   int obj_size() const { return f_obj_sz; };
+
+// allocation counters
+   int allocs() const { return f_allocs; };
+   int frees() const { return f_frees; };
+   int slab_bytes() const { return f_slab_bytes; };
+
+   ostream& print_stats(ostream&);
+
+protected:
+   int f_obj_sz;
+   int f_objs_in_next_slab;
+   char* f_slabs;         // slabs chained through their first word
+   char* f_free_list;
+
+   int f_allocs;
+   int f_frees;
+   int f_slab_bytes;
+
+   void add_slab();
 };
 
 #ifdef C_API
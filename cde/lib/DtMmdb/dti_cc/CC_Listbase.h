@@ -70,6 +70,10 @@ friend class CC_List_Iterator_base;
 public:
   CC_Link_base():f_next(NULL),f_prev(NULL) {}
 
+  // links are carved from slab pools, one per link size
+  static void *alloc_link (size_t sz);
+  static void free_link (void *p, size_t sz);
+
 private:
 
   CC_Link_base *f_next;
@@ -52,6 +52,11 @@ private:
     : f_element (element)
     { }
   
+  void *operator new (size_t sz)
+    { return CC_Link_base::alloc_link (sz); }
+  void operator delete (void *p, size_t sz)
+    { CC_Link_base::free_link (p, sz); }
+
   T*    f_element;
 };
 
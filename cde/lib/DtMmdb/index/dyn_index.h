@@ -64,6 +64,8 @@ public:
    virtual ~dyn_index();
 
 // insert index functions
+   virtual Boolean batch_index_begin();
+   virtual Boolean batch_index_end();
    virtual Boolean insert_key_loc(const handler&, const oid_t&) ;
    virtual Boolean insert_key_loc(const oid_t&, const oid_t&) ;
   
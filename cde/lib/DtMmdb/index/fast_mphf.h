@@ -145,6 +145,9 @@ protected:
 // return the ith g value from the g array (in packed form)
    int gValue(int, int& gvalue, int& ctl_bit) ;
 
+// read the packed g array in (once) for gValue().
+   void load_gvalues();
+
    void print_tbls(ostream&out = cerr) ;
    int print_bits(unsigned, ostream& = cout);
 
@@ -161,6 +164,8 @@ protected:
 
    Boolean v_long_string_core_indexed;
 
+   unsigned* v_gvalues;    // in core copy of the packed g array
+
    unsigned int v_no_ps,  // number of partitions (buckets)
                 v_p1, v_p2, // parameters p1 and p2.
                 r,
@@ -75,7 +75,7 @@ public:
    virtual void destroy();
 
    void* operator new( size_t ); 
-   void operator delete( void* ); 
+   void operator delete( void*, size_t ); 
 
    root* operator ->();
    operator root&();
@@ -88,9 +88,6 @@ public:
 
    abs_storage* its_store() const { return store; } ;
 
-protected:
-   //static memory_pool handler_space_pool;
-
 protected:
    abs_storage* store;
    oid_t obj_id;
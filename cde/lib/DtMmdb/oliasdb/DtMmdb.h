@@ -223,6 +223,15 @@ DtMmdbLocatorGetSectionLoc DtMmdb_PROTO1(DtMmdbInfoRequest* request);
 DtMmdbHandle* 
 DtMmdbLocatorGetSectionObjectId DtMmdb_PROTO1(DtMmdbInfoRequest* request);
 
+/* resolve a NULL terminated list of locators of one bookcase in one
+   call. An unresolved locator gets the ground id. */
+DtMmdbHandle** 
+DtMmdbLocatorGetSectionObjectIds DtMmdb_PROTO3(
+	int bookcase_descriptor, 
+	const char** locators,
+	unsigned int* list_length
+	);
+
 /*****************************************************/
 /* Graphic */
 /*****************************************************/
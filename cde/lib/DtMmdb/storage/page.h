@@ -116,6 +116,7 @@ public:
    friend class page_storage;
    friend class page_cache_global_part;
    friend class dyn_hash;
+   friend void remove_from_global_cache(const void*);
 
 
 protected:
@@ -31,6 +31,10 @@ class page_storage;
 #define MMDB_CACHED_PAGES 100
 #define MIN_MMDB_CACHED_PAGES 10
 
+// default memory budget of the page cache, in bytes. It can
+// be set with the shell variable MMDB_CACHE_SIZE (suffix k or m).
+#define MMDB_CACHE_SIZE (8 * 1024 * 1024)
+
 #include "dstr/bset.h"
 
 class page_cache_local_part
@@ -74,8 +78,9 @@ public:
 //////////////////////////////////////////////////////////////////////
 // The default value (0) triggers the constructor to 
 // search for the value in the shell variable MMDB_CACHED_PAGES.
-// If the varialble is undefind, the value set by const MMDB_CACHED_PAGES
-// will be used.
+// If the varialble is undefind, the cache is bounded by a memory
+// budget instead: the shell variable MMDB_CACHE_SIZE or the value
+// set by const MMDB_CACHE_SIZE.
 //////////////////////////////////////////////////////////////////////
    page_cache_global_part(unsigned int total_allowed_pages = 0);
    virtual ~page_cache_global_part() ;
@@ -92,8 +97,12 @@ public:
    friend void remove_from_global_cache(const void*);
 
 protected:
-   unsigned int    f_total_allowed_pages;
+   unsigned int    f_total_allowed_pages;  // 0: no page count limit
+   unsigned int    f_total_allowed_bytes;  // 0: no memory limit
+   unsigned int    f_cached_bytes;
    lru             f_replace_policy;
+
+   Boolean room_for_page(int page_sz);
 };
 
 #endif
@@ -225,6 +225,7 @@ public:
 // paging counting function
    void reset_paging_count();
    int paging_count() const;
+   int page_access_count() const { return total_page_access; };
 
    Boolean io_mode(int mode) ;
 
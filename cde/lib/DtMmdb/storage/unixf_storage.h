@@ -70,6 +70,13 @@ protected:
    int _open(int mode);
    Boolean v_file_exist;
 
+// read-only files are mapped in and read with memcpy().
+// Set the shell variable MMDB_NO_MMAP to use the stream instead.
+   char* v_map;
+   int v_map_sz;
+   Boolean v_map_tried;
+   Boolean _map();
+
 public:
 // mode: see ios::in etc. stuff in file iostream.h 
    unixf_storage( char* file_path, 
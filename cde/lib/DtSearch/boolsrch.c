@@ -33,19 +33,26 @@
 /*
  *   COMPONENT_NAME: austext
  *
- *   FUNCTIONS: boolean_search
+ *   FUNCTIONS: and_sorted_stems
+ *		boolean_search
  *		calc_result_bitvec_WK
  *		calculate_idfs
  *		dbread_filter_WK
+ *		get_colloc_bitvec
  *		get_proximity
  *		got_USR_STOPSRCH
+ *		in_colloc_range
  *		load_DtSrResults_WK
  *		load_or_wordrecs
+ *		load_d99
+ *		open_d99
  *		read_d99
+ *		read_d99_close
  *		read_recno
  *		read_stem_bitvec_WK
  *		stuff_DtSrResult
  *		weights_filter_WK
+ *		wordpos_hitwords
  *
  *   ORIGINS: 27
  *
@@ -101,6 +108,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "vista.h"
 #include "boolpars.h"
 
@@ -108,11 +118,12 @@
 #define INIT_ITERATIONS	50
 #define MS_boolsrch	16
 /*
- * DBAS_PER_BLOCK is the max number of dbas to be read
- * from d99 file.  Note DBAS_PER_BLOCK * sizeof(DB_ADDR) = 512 bytes,
- * the standard blksize of one hard disk block.
+ * DBAS_PER_BLOCK is the max number of dbas to be decoded
+ * from d99 file at a time.  The postings of a term are mapped
+ * into memory if possible, otherwise they are read with stdio
+ * DBAS_PER_BLOCK * sizeof(DB_ADDR) = 16K bytes at a time.
  */
-#define DBAS_PER_BLOCK	128
+#define DBAS_PER_BLOCK	4096
 
 #define RESET_BIT(bv, by, bm)	bv[by] &= (UCHAR) ~bm
 
@@ -120,6 +131,30 @@
 #error DtSrMAX_STEMCOUNT does not equal 8.
 #endif
 
+/****************************************/
+/*					*/
+/*		D99READER		*/
+/*					*/
+/****************************************/
+/* State of read_d99() while it reads the d99 postings
+ * of one term.  Owned by the caller, so several terms
+ * may be read at the same time.
+ */
+typedef struct {
+    FILE	*fptr;
+    long	bal_read;	/* dbas not yet decoded */
+    char	*map;		/* mapped pages of d99 file, or NULL */
+    size_t	maplen;
+    char	*mapptr;	/* next undecoded dba in map */
+    DB_ADDR	*bufptr;	/* next decoded dba in buf */
+    DB_ADDR	*endbuf;
+    DB_ADDR	*heap;		/* load_d99() copy if not mapped */
+    DB_ADDR	buf [DBAS_PER_BLOCK];
+} D99READER;
+
+/* Rec# of a d99dba still in 'network' byte order */
+#define D99RECNO(d)	((DtSrUINT32) ntohl (d) >> 8)
+
 /****************************************/
 /*					*/
 /*		  PROXWT		*/
@@ -140,6 +175,7 @@ typedef struct {
 int			debugging_boolsrch =	FALSE;
 
 static int		all_key_types =		TRUE;
+static int		and_sorted =		FALSE;
 static UCHAR		*bitvec_allocp =	NULL;
 static size_t		bitvec_allocsz =	0;
 static long		bitveclen;	/* 1/8 of tot_addr_count */
@@ -1064,6 +1100,102 @@ static void	calc_result_bitvec_WK (void)
 } /* calc_result_bitvec_WK() */
 
 
+/****************************************/
+/*					*/
+/*		open_d99		*/
+/*					*/
+/****************************************/
+/* Subroutine of read_d99() and load_d99().
+ * Prepares the reader for the d99 addrs of the term in wordrec.
+ * The addrs are mapped into memory if possible,
+ * otherwise the d99 file is positioned at the first addr.
+ * Returns FALSE if the addrs run past the end of the d99 file.
+ */
+static int	open_d99 (D99READER *rdr, struct or_hwordrec *wordrec,
+		    int sequential)
+{
+    long	pagesize;
+    off_t	mapoffset;
+    struct stat	statbuf;
+
+    rdr->fptr = usrblk.dblk->iifile;
+    rdr->bal_read = wordrec->or_hwaddrs;
+    rdr->bufptr = rdr->endbuf = 0;	/* triggers block read */
+    rdr->map = NULL;
+    rdr->heap = NULL;
+    if (rdr->bal_read <= 0)
+	return TRUE;
+
+    /* If the file can't be stat'd, stdio will find any short read */
+    if (fstat (fileno (rdr->fptr), &statbuf) == -1) {
+	fseek (rdr->fptr, wordrec->or_hwoffset, SEEK_SET);
+	return TRUE;
+    }
+    if (wordrec->or_hwoffset < 0  ||
+	    wordrec->or_hwoffset > statbuf.st_size  ||
+	    rdr->bal_read > (statbuf.st_size - wordrec->or_hwoffset) /
+		(off_t) sizeof(DB_ADDR)) {
+	sprintf (msgbuf, CATGETS(dtsearch_catd, MS_boolsrch, 28,
+	    "%s Database Read Error in %s.d99.") ,
+	    PROGNAME"1128", usrblk.dblk->name);
+	DtSearchAddMessage (msgbuf);
+	rdr->bal_read = 0;
+	return FALSE;
+    }
+
+    pagesize = sysconf (_SC_PAGESIZE);
+    mapoffset = wordrec->or_hwoffset & ~(pagesize - 1);
+    rdr->maplen = wordrec->or_hwoffset - mapoffset +
+	rdr->bal_read * sizeof(DB_ADDR);
+    rdr->map = mmap (NULL, rdr->maplen, PROT_READ, MAP_PRIVATE,
+	fileno (rdr->fptr), mapoffset);
+    if (rdr->map == MAP_FAILED) {
+	rdr->map = NULL;
+	fseek (rdr->fptr, wordrec->or_hwoffset, SEEK_SET);
+	return TRUE;
+    }
+#if defined(MADV_SEQUENTIAL) && defined(MADV_RANDOM)
+    madvise (rdr->map, rdr->maplen,
+	(sequential) ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+    rdr->mapptr = rdr->map + (wordrec->or_hwoffset - mapoffset);
+    return TRUE;
+} /* open_d99() */
+
+
+/****************************************/
+/*					*/
+/*		load_d99		*/
+/*					*/
+/****************************************/
+/* Subroutine of and_sorted_stems().
+ * Returns the array of all the term's d99dbas, still in
+ * 'network' byte order, for random access.  It points into the
+ * mapped d99 file, or if that failed, to a copy read into memory.
+ * Returns NULL on read error.
+ * read_d99_close() must be called when done with the term.
+ */
+static DB_ADDR	*load_d99 (D99READER *rdr, struct or_hwordrec *wordrec)
+{
+    if (!open_d99 (rdr, wordrec, FALSE))
+	return NULL;
+    if (rdr->map)
+	return (DB_ADDR *) rdr->mapptr;
+
+    rdr->heap = austext_malloc (rdr->bal_read * sizeof(DB_ADDR) + 4,
+	PROGNAME"437", NULL);
+    if (fread (rdr->heap, sizeof(DB_ADDR), rdr->bal_read, rdr->fptr)
+	    != rdr->bal_read) {
+	sprintf (msgbuf, CATGETS(dtsearch_catd, MS_boolsrch, 28,
+	    "%s Database Read Error in %s.d99.") ,
+	    PROGNAME"438", usrblk.dblk->name);
+	DtSearchAddMessage (msgbuf);
+	return NULL;
+    }
+    return rdr->heap;
+} /* load_d99() */
+
+
 /****************************************/
 /*					*/
 /*		read_d99		*/
@@ -1075,40 +1207,36 @@ static void	calc_result_bitvec_WK (void)
  * the term's wordrec with d99 offset and size information.
  * Subsequent calls pass NULL.
  * Returns valid d99dba, or 0 at end of term's index, or -1 on error.
- * Actual reads are performed a disk block at a time,
- * with dbas stored in a static buffer for the next call.
+ * The term's postings are mapped into memory by open_d99()
+ * at the first call (or read with stdio if that fails) and byte swapped
+ * DBAS_PER_BLOCK at a time into the caller's reader.
+ * read_d99_close() must be called when done with the term.
  */
-static DB_ADDR	read_d99 (struct or_hwordrec *wordrec)
+static DB_ADDR	read_d99 (D99READER *rdr, struct or_hwordrec *wordrec)
 {
-    static DB_ADDR	readbuf [DBAS_PER_BLOCK];
-    static DB_ADDR	*bufptr, *endbuf;
-    static FILE		*fptr;
-    static long		bal_read, request_read;
+    long	request_read;
+    long	i;
 
     /* First call for new term */
-    if (wordrec) {
-	fptr = usrblk.dblk->iifile;
-	fseek (fptr, wordrec->or_hwoffset, SEEK_SET);
-	bal_read = wordrec->or_hwaddrs;
-	bufptr = endbuf = 0;	/* triggers block read */
-    }
+    if (wordrec  &&  !open_d99 (rdr, wordrec, TRUE))
+	return -1;
 
-    /* Time to read another block */
-    if (bufptr >= endbuf) {
-	if (bal_read <= 0)
+    /* Time to decode another block */
+    if (rdr->bufptr >= rdr->endbuf) {
+	if (rdr->bal_read <= 0)
 	    return 0;
-	if (bal_read > DBAS_PER_BLOCK) {
+	if (rdr->bal_read > DBAS_PER_BLOCK)
 	    request_read = DBAS_PER_BLOCK;
-	    bal_read -= DBAS_PER_BLOCK;
-	    endbuf = readbuf + DBAS_PER_BLOCK;
-	}
-	else {
-	    /* last block is usually short */
-	    request_read = bal_read;
-	    bal_read = 0;
-	    endbuf = readbuf + request_read;
+	else
+	    request_read = rdr->bal_read;	/* last block is usually short */
+	rdr->bal_read -= request_read;
+	rdr->endbuf = rdr->buf + request_read;
+
+	if (rdr->map) {
+	    memcpy (rdr->buf, rdr->mapptr, request_read * sizeof(DB_ADDR));
+	    rdr->mapptr += request_read * sizeof(DB_ADDR);
 	}
-	if (fread (readbuf, sizeof(DB_ADDR), request_read, fptr)
+	else if (fread (rdr->buf, sizeof(DB_ADDR), request_read, rdr->fptr)
 		!= request_read) {
 	    sprintf (msgbuf, CATGETS(dtsearch_catd, MS_boolsrch, 28,
 		"%s Database Read Error in %s.d99.") ,
@@ -1116,14 +1244,251 @@ static DB_ADDR	read_d99 (struct or_hwordrec *wordrec)
 	    DtSearchAddMessage (msgbuf);
 	    return -1;
 	}
-	bufptr = readbuf;
+
+	/* Swap the whole block in one simple loop the compiler can vectorize */
+	for (i = 0;  i < request_read;  i++)
+	    rdr->buf[i] = ntohl (rdr->buf[i]);
+	rdr->bufptr = rdr->buf;
     }
 
-    /******return *bufptr++;*******/
-    return ntohl (*bufptr++);
+    return *rdr->bufptr++;
 } /* read_d99() */
 
 
+/****************************************/
+/*					*/
+/*	      read_d99_close		*/
+/*					*/
+/****************************************/
+/* Releases the d99 mapping or copy of a term
+ * read with read_d99() or load_d99().
+ */
+static void	read_d99_close (D99READER *rdr)
+{
+    if (rdr->map) {
+	munmap (rdr->map, rdr->maplen);
+	rdr->map = NULL;
+    }
+    if (rdr->heap) {
+	free (rdr->heap);
+	rdr->heap = NULL;
+    }
+} /* read_d99_close() */
+
+
+/****************************************/
+/*					*/
+/*	     and_sorted_stems		*/
+/*					*/
+/****************************************/
+/* Subroutine of read_stem_bitvec_WK() for queries that only
+ * AND words together, in databases whose d99 addrs
+ * ascend by rec# (ORD_SORTEDD99).
+ * Instead of loading a bitvec for every stem and ANDing them
+ * in calc_result_bitvec_WK(), the rec#s of the rarest stem are
+ * looked up in the d99 addrs of each other stem, rarest first,
+ * by galloping (exponential then binary) search, so most of
+ * the addrs of common stems are never touched.  Stops as soon
+ * as no rec# is left.  Only the surviving rec#s are set,
+ * in every stem's bitvec, so the truth table still works.
+ * Returns 0 if successful, otherwise returns -1 and msgs.
+ */
+static int	and_sorted_stems (void)
+{
+    int		order [DtSrMAX_STEMCOUNT];
+    int		i, j, stemno;
+    DB_ADDR	*cands;
+    DB_ADDR	*addrs;
+    DtSrUINT32	recno;
+    long	candct, keepct, c;
+    long	pos, hi, lo, mid, step, m;
+    D99READER	rdr;
+
+    /* Sort stem numbers by ascending number of addrs */
+    for (i = 0;  i < saveusr.stemcount;  i++) {
+	for (j = i;  j > 0;  j--) {
+	    if (or_wordrecs [order [j-1]] .or_hwaddrs <=
+		    or_wordrecs [i] .or_hwaddrs)
+		break;
+	    order [j] = order [j-1];
+	}
+	order [j] = i;
+    }
+
+    /* Candidates are all the addrs of the rarest stem */
+    stemno = order [0];
+    candct = or_wordrecs [stemno] .or_hwaddrs;
+    if (candct <= 0)
+	return 0;
+    if ((addrs = load_d99 (&rdr, &or_wordrecs [stemno])) == NULL) {
+	read_d99_close (&rdr);
+	return -1;
+    }
+    cands = austext_malloc (candct * sizeof(DB_ADDR) + 4,
+	PROGNAME"439", NULL);
+    memcpy (cands, addrs, candct * sizeof(DB_ADDR));
+    read_d99_close (&rdr);
+    for (c = 0;  c < candct;  c++) {
+	if ((D99RECNO (cands[c]) >> 3) >= bitveclen) {
+	    sprintf (msgbuf, CATGETS(dtsearch_catd, MS_boolsrch, 32,
+		"%s Database Error: %s '%s'\n"
+		"in database '%s' has invalid d99 record number %ld.") ,
+		PROGNAME"396",
+		(usrblk.search_type == 'W') ?
+			CATGETS(dtsearch_catd, MS_boolsrch, 33, "Word") :
+			CATGETS(dtsearch_catd, MS_boolsrch, 34, "Stem of"),
+		usrblk.stems [stemno],
+		usrblk.dblk->label,
+		(long) D99RECNO (cands[c]));
+	    DtSearchAddMessage (msgbuf);
+	    free (cands);
+	    return -1;
+	}
+	if (do_stat_sort)
+	    wtvec [D99RECNO (cands[c])] += (float) idf [stemno] *
+		((float) (ntohl (cands[c]) & 0x000000ff) + 1.0);
+    }
+
+    /* Keep only candidates found in every other stem */
+    for (i = 1;  i < saveusr.stemcount  &&  candct > 0;  i++) {
+	stemno = order [i];
+	m = or_wordrecs [stemno] .or_hwaddrs;
+	if ((addrs = load_d99 (&rdr, &or_wordrecs [stemno])) == NULL) {
+	    read_d99_close (&rdr);
+	    free (cands);
+	    return -1;
+	}
+	pos = 0;
+	keepct = 0;
+	for (c = 0;  c < candct  &&  pos < m;  c++) {
+	    recno = D99RECNO (cands[c]);
+
+	    /* Gallop to a range whose end is >= recno... */
+	    step = 1;
+	    hi = pos;
+	    while (hi < m  &&  D99RECNO (addrs[hi]) < recno) {
+		pos = hi + 1;
+		hi += step;
+		step <<= 1;
+	    }
+	    if (hi > m)
+		hi = m;
+
+	    /* ...then binary search it for the first addr >= recno */
+	    lo = pos;
+	    while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (D99RECNO (addrs[mid]) < recno)
+		    lo = mid + 1;
+		else
+		    hi = mid;
+	    }
+	    pos = lo;
+	    if (pos >= m  ||  D99RECNO (addrs[pos]) != recno)
+		continue;
+
+	    cands [keepct++] = cands[c];
+	    if (do_stat_sort)
+		wtvec [recno] += (float) idf [stemno] *
+		    ((float) (ntohl (addrs[pos]) & 0x000000ff) + 1.0);
+	    pos++;
+	}
+	read_d99_close (&rdr);
+	candct = keepct;
+
+	if (debugging_boolsrch)
+	    fprintf (aa_stderr, PROGNAME"397 "
+		"and_sorted_stems: stem #%d '%s' addrs=%ld, %ld recs left.\n",
+		stemno, saveusr.stems [stemno], m, candct);
+    }
+
+    /* Set survivors in every stem's bitvec */
+    for (c = 0;  c < candct;  c++) {
+	recno = D99RECNO (cands[c]);
+	for (i = 0;  i < saveusr.stemcount;  i++)
+	    bitvecs [i] [recno >> 3] |= 1 << (recno % 8);
+    }
+    free (cands);
+    return 0;
+} /* and_sorted_stems() */
+
+
+/****************************************/
+/*					*/
+/*	     in_colloc_range		*/
+/*					*/
+/****************************************/
+/* Subroutine of get_colloc_bitvec().
+ * Compares two hilite tables, each in offset order.
+ * Returns TRUE if some occurrence of B starts after
+ * an occurrence of A and no more than range chars
+ * past its end.
+ */
+static int	in_colloc_range (
+		    DtSrHitword	*hitwords_A,
+		    long	hitwcount_A,
+		    DtSrHitword	*hitwords_B,
+		    long	hitwcount_B,
+		    long	range)
+{
+    int		got_a_colloc = FALSE;
+    long	a, b, offset_A, offset_B;
+    long	threshold_range;
+
+    b = 0;
+    for (a = 0;  a < hitwcount_A;  a++) {
+	offset_A = hitwords_A[a].offset;
+	threshold_range = offset_A + hitwords_A[a].length + range;
+	for (;  b < hitwcount_B;  b++) {
+	    offset_B = hitwords_B[b].offset;
+
+	    /* Advance B to first entry past A's offset */
+	    if (offset_B <= offset_A )
+		continue;	/* ...the B loop */
+	    if (offset_B <= threshold_range)
+		got_a_colloc = TRUE;
+	    break;		/* ...the B loop */
+	}  /* end B loop */
+	if (got_a_colloc  ||  b >= hitwcount_B)
+	    break;		/* ...the A loop */
+    } /* end A loop */
+    return got_a_colloc;
+} /* in_colloc_range() */
+
+
+/****************************************/
+/*					*/
+/*	     wordpos_hitwords		*/
+/*					*/
+/****************************************/
+/* Subroutine of get_colloc_bitvec().
+ * Loads count offset/length pairs from a d96 word block
+ * into a hilite table, reallocating it as necessary.
+ * Returns the hilite table.
+ */
+static DtSrHitword	*wordpos_hitwords (
+			    DtSrUINT32	*posns,
+			    long	count,
+			    DtSrHitword	**hitwords,
+			    long	*hitwsize)
+{
+    long	i;
+
+    if (count > *hitwsize) {
+	if (*hitwords)
+	    free (*hitwords);
+	*hitwsize = count + 64;
+	*hitwords = austext_malloc (*hitwsize * sizeof(DtSrHitword),
+	    PROGNAME"1531", NULL);
+    }
+    for (i = 0;  i < count;  i++) {
+	(*hitwords)[i].offset = ntohl (posns [2 * i]);
+	(*hitwords)[i].length = ntohl (posns [2 * i + 1]);
+    }
+    return *hitwords;
+} /* wordpos_hitwords() */
+
+
 /****************************************/
 /*					*/
 /*	     get_colloc_bitvec		*/
@@ -1138,13 +1503,16 @@ static DB_ADDR	read_d99 (struct or_hwordrec *wordrec)
  * containing both "ICE" and "CREAM" but only if they are separated
  * by no more than 5 characters.
  *
- * Since offset information is not stored in the inverted index
- * this module initially returns the intersection of the two words'
- * bit vectors (boolean AND).  Then it retrieves each record,
- * builds an offset (hilites) table for each of the two words,
- * then compares the offset differences in the tables.
+ * This module initially returns the intersection of the two words'
+ * bit vectors (boolean AND).  Then for each record it gets
+ * an offset (hilites) table for each of the two words,
+ * and compares the offset differences in the tables.
  * If no occurrence pairs are within the specified separation
  * range, the record is deleted from the bitvector.
+ * The offsets come from the word positions (d96) file
+ * written by dtsrindex when it has both words for the record.
+ * Otherwise the record is retrieved and the tables are
+ * built by parsing its text.
  * Returns 0 if successful, otherwise returns -1 and msgs.
 @@@@ rewrite as its own workproc--reading/hiliting can take a long time...
  */
@@ -1160,13 +1528,18 @@ static int	get_colloc_bitvec (void)
     UCHAR	bitmask;
     int		parse_type;
     int		got_a_colloc;
+    int		retncode =	0;
     char	*stemp;
     DtSrHitword *hitwords_A, *hitwords_B;
     long	hitwcount_A, hitwcount_B;
-    long	threshold_range;
     DB_ADDR	dba;
     LLIST	*bloblist;
-    long	a, b, offset_A, offset_B;
+    WORDPOS	wordpos;
+    char	fname [1024];
+    DtSrUINT32	*block_A = NULL, *block_B = NULL;
+    DtSrUINT32	*posns_A, *posns_B;
+    DtSrHitword	*posbuf_A = NULL, *posbuf_B = NULL;
+    long	possize_A = 0, possize_B = 0;
 
     /* First construct the set intersection (AND) of
      * each of the collocated terms in the colloc bitvec.
@@ -1187,8 +1560,21 @@ static int	get_colloc_bitvec (void)
 	fflush (aa_stderr);
     }
 
-    /* Read cleartext for each rec in intersection/colloc bitvec.
-     * Get hitwords (hilite table) for each collocation term.
+    /* Find both terms in the word positions file, if any */
+    snprintf (fname, sizeof(fname), "%s%s" EXT_WORDPOS,
+	usrblk.dblk->path, usrblk.dblk->name);
+    if (open_wordpos (&wordpos, fname)) {
+	block_A = find_wordpos (&wordpos, or_wordrecs[stemno_A].or_hwordkey);
+	block_B = find_wordpos (&wordpos, or_wordrecs[stemno_B].or_hwordkey);
+    }
+    if (debugging_boolsrch) {
+	fprintf (aa_stderr, PROGNAME"1532 d96 '%s': %s\n", fname,
+	    (block_A && block_B) ? "using positions" : "no positions");
+	fflush (aa_stderr);
+    }
+
+    /* Get hitwords (hilite table) for each collocation term
+     * of each rec in intersection/colloc bitvec.
      * Switch off recs in bitvec where no term pairs are in
      * collocation range. 
      */
@@ -1210,6 +1596,22 @@ static int	get_colloc_bitvec (void)
 	}
 	dba |= (OR_D00 << 24);
 
+	/* Use d96 positions if both terms have them for this rec */
+	if (block_A && block_B  &&
+		(hitwcount_A = find_wordpos_rec
+		    (block_A, (DtSrINT32) recno, &posns_A)) >= 0  &&
+		(hitwcount_B = find_wordpos_rec
+		    (block_B, (DtSrINT32) recno, &posns_B)) >= 0) {
+	    hitwords_A = wordpos_hitwords (posns_A, hitwcount_A,
+		&posbuf_A, &possize_A);
+	    hitwords_B = wordpos_hitwords (posns_B, hitwcount_B,
+		&posbuf_B, &possize_B);
+	    if (!in_colloc_range (hitwords_A, hitwcount_A,
+		    hitwords_B, hitwcount_B, range))
+		RESET_BIT (bitvec_C, byteno, bitmask);
+	    continue;
+	}
+
 	/* Silently skip records that have no document text */
 	if ((bloblist = ve_getblobs (dba, vistano)) == NULL) {
 	    if (debugging_boolsrch) {
@@ -1223,8 +1625,10 @@ static int	get_colloc_bitvec (void)
 	}
 
 	/* Uncompress record text into usrblk.cleartext */
-	if (oe_unblob (bloblist) != OE_OK)
-	    return -1;
+	if (oe_unblob (bloblist) != OE_OK) {
+	    retncode = -1;
+	    break;
+	}
 
 	/* Build 'hilite' table for stem A.  If stem
 	 * can't be found in the record, silently skip it.
@@ -1265,24 +1669,8 @@ static int	get_colloc_bitvec (void)
 	usrblk.hitwcount = 0;
 
 	/* Compare the two hilite tables for range matches */
-	got_a_colloc = FALSE;
-	b = 0;
-	for (a = 0;  a < hitwcount_A;  a++) {
-	    offset_A = hitwords_A[a].offset;
-	    threshold_range = offset_A + hitwords_A[a].length + range;
-	    for (;  b < hitwcount_B;  b++) {
-		offset_B = hitwords_B[b].offset;
-
-		/* Advance B to first entry past A's offset */
-		if (offset_B <= offset_A )
-		    continue;	/* ...the B loop */
-		if (offset_B <= threshold_range)
-		    got_a_colloc = TRUE;
-		break;		/* ...the B loop */
-	    }  /* end B loop */
-	    if (got_a_colloc  ||  b >= hitwcount_B)
-		break;		/* ...the A loop */
-	} /* end A loop */
+	got_a_colloc = in_colloc_range (hitwords_A, hitwcount_A,
+	    hitwords_B, hitwcount_B, range);
 	free (hitwords_A);
 	free (hitwords_B);
 
@@ -1294,7 +1682,12 @@ static int	get_colloc_bitvec (void)
 
     } /* end loop on each recno in intersection/colloc bitvec */
 
-    return 0;
+    close_wordpos (&wordpos);
+    if (posbuf_A)
+	free (posbuf_A);
+    if (posbuf_B)
+	free (posbuf_B);
+    return retncode;
 } /* get_colloc_bitvec() */
 
 
@@ -1313,19 +1706,27 @@ static void	read_stem_bitvec_WK (void)
     long	byteno;
     DB_ADDR	d99recno;
     float	weight;
+    D99READER	rdr;
 
     if (got_USR_STOPSRCH())
 	return;
 
+    /* ANDed stems of a sorted d99 are intersected all at once */
+    if (and_sorted) {
+	d99recno = and_sorted_stems();
+	save_stemno = saveusr.stemcount - 1;
+	goto DONE_READING;
+    }
+
     /* Process collocation 'stems' */
     if (saveusr.stems [save_stemno] [0] == '@') {
 	d99recno = get_colloc_bitvec();
 	goto DONE_READING;
     }
 
-    for (	d99recno = read_d99 (&or_wordrecs [save_stemno]);
+    for (	d99recno = read_d99 (&rdr, &or_wordrecs [save_stemno]);
 		d99recno;
-		d99recno = read_d99 (NULL)) {
+		d99recno = read_d99 (&rdr, NULL)) {
 	if (d99recno == -1)	/* read error */
 	    break;
 
@@ -1354,6 +1755,7 @@ static void	read_stem_bitvec_WK (void)
 		d99recno);
 	    DtSearchAddMessage (msgbuf);
 	    d99recno = -1;	/* force error return */
+	    read_d99_close (&rdr);
 	    goto DONE_READING;
 	}
 	bitvecs [save_stemno] [byteno] |= 1 << (d99recno % 8);
@@ -1366,6 +1768,7 @@ static void	read_stem_bitvec_WK (void)
 	    wtvec [d99recno] += weight * (float) idf [save_stemno];
 
     } /* end loop that retrieves every d99recno for curr stem */
+    read_d99_close (&rdr);
 
 DONE_READING:
 
@@ -1438,6 +1841,8 @@ void	boolean_search (void)
 	msgbuf = austext_malloc (500, PROGNAME"393", NULL);
     debugging_boolsrch =	(usrblk.debug & USRDBG_SRCHCMPL);
     need_zero_permute =	(final_truthtab.permutes[0] == 0);
+    and_sorted =	(qry_is_all_ANDs  &&  saveusr.stemcount > 1  &&
+	(usrblk.dblk->dbrec.or_dbflags & ORD_SORTEDD99) != 0);
     do_stat_sort =	((usrblk.flags & USR_SORT_WHITL) != 0);
     check_dates =	(usrblk.objdate1 || usrblk.objdate2);
     or_abstrsz =	usrblk.dblk->dbrec.or_abstrsz;
@@ -127,6 +127,7 @@ int             OE_bmhtab_strlen[DtSrMAX_STEMCOUNT] = { 0 };
 size_t          OE_bmhtables[DtSrMAX_STEMCOUNT][MAX_BMHTAB] = { { 0 } };
 int             OE_dbn = 0;	/* dynamic */
 int             OE_enable_markdel = 0;
+long            OE_cache_kbytes = 0L;
 int             OE_enable_usernotes = 0;
 int             OE_fastdecode = 0;
 char           *OE_fileio = NULL;
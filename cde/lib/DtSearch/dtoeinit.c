@@ -153,6 +153,7 @@ void            oe_initialize (void)
     OE_objsize =		0L;
     OE_search_type =		'P';	/* default is statistical searches */
     OE_words_hitlimit =		WORDS_HITLIMIT;
+    OE_cache_kbytes =		0L;	/* vista cache sized by CACHE_SIZE */
     OE_enable_markdel =		FALSE;	/* former lvl2 default: TRUE */
     OE_enable_usernotes =	FALSE;	/* former lvl2 default: TRUE */
     OE_fastdecode =		FALSE;	/* former lvl2 default: TRUE */
@@ -23,11 +23,15 @@
 /*
  *   COMPONENT_NAME: austext
  *
- *   FUNCTIONS: DtSearchGetKeytypes
+ *   FUNCTIONS: DtSearchCacheStats
+ *		DtSearchCloseSession
+ *		DtSearchGetKeytypes
  *		DtSearchHighlight
  *		DtSearchInit
+ *		DtSearchOpenSession
  *		DtSearchQuery
  *		DtSearchRetrieve
+ *		DtSearchSetSession
  *		aa_categories
  *		aa_is_semantic_db
  *		aa_netrc
@@ -105,13 +109,18 @@
  * Revision 1.18  1995/07/18  22:05:10  miker
  * Set OE_sitecnfg_fname to arg passed to ausapi_init().
  */
+#ifndef _XOPEN_SOURCE		/* before Search.h, for recursive mutexes */
+# define _XOPEN_SOURCE 600
+#endif
 #include "SearchE.h"
+#include "vista.h"
 #include <ctype.h>
 #include <signal.h>
 #include <locale.h>
 #include <string.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 #define PROGNAME	"DTSRAPI"
 #define SPRINTBUFSZ	1024
@@ -122,9 +131,37 @@
 /* Usrblk should not be visible to user interface code,
  * but must be visible to real engine... */
 USRBLK          usrblk = { { 0 } };
-static int      save_search_type = '$';
 static char    *sprintbuf = NULL;
 
+/****************************************/
+/*					*/
+/*		DtSrSession		*/
+/*					*/
+/****************************************/
+/* The part of usrblk that belongs to one caller between
+ * api calls: the stems and search type of its last search,
+ * and the cleartext and hitwords returned to it.
+ * The engine itself only works on usrblk, so every api call
+ * first swaps the calling thread's session into usrblk.
+ */
+struct _DtSrSession {
+    int		search_type;	/* of last search, for DtSearchHighlight() */
+    int		stemcount;
+    char	stems [DtSrMAX_STEMCOUNT] [DtSrMAXWIDTH_HWORD];
+    char	*cleartext;
+    long	clearlen;
+    DtSrHitword	*hitwords;
+    long	hitwcount;
+};
+
+static DtSrSession	default_session = { '$' };
+static DtSrSession	*usrblk_session = &default_session;
+				/* session currently in usrblk */
+static pthread_mutex_t	engine_mutex;	/* recursive, see aa_api_lock() */
+static pthread_once_t	engine_once = PTHREAD_ONCE_INIT;
+static pthread_once_t	session_once = PTHREAD_ONCE_INIT;
+static pthread_key_t	session_key;
+
 /*------------------- EXTERNS (aajoint.c) ---------------------*/
 extern int      aa_is_initialized;
 extern void     aa_check_initialization (void);
@@ -157,6 +194,206 @@ static void     signal_abort (int sig)
 }  /* signal_abort() */
 
 
+/************************************************/
+/*						*/
+/*		 engine_mutex_init		*/
+/*						*/
+/************************************************/
+static void     engine_mutex_init (void)
+{
+    pthread_mutexattr_t	attr;
+
+    pthread_mutexattr_init (&attr);
+    pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init (&engine_mutex, &attr);
+    pthread_mutexattr_destroy (&attr);
+}  /* engine_mutex_init() */
+
+
+/************************************************/
+/*						*/
+/*		   aa_api_lock			*/
+/*		  aa_api_unlock			*/
+/*						*/
+/************************************************/
+/* The engine lock, without the session swap of lock_engine().
+ * Also taken by the api functions outside this module that
+ * touch process wide state: the message list (msgs.c),
+ * aa_maxhits and the result sorts (dtsrjoint.c).
+ * It is recursive so that they may be called while
+ * the engine already holds it.
+ */
+void            aa_api_lock (void)
+{
+    pthread_once (&engine_once, engine_mutex_init);
+    aa_api_lock ();
+}  /* aa_api_lock() */
+
+void            aa_api_unlock (void)
+{
+    aa_api_unlock ();
+}  /* aa_api_unlock() */
+
+
+/************************************************/
+/*						*/
+/*		  session_key_init		*/
+/*						*/
+/************************************************/
+static void     session_key_init (void)
+{
+    pthread_key_create (&session_key, NULL);
+}  /* session_key_init() */
+
+
+/************************************************/
+/*						*/
+/*		   lock_engine			*/
+/*						*/
+/************************************************/
+/* Called at the start of every api call.  Serializes
+ * the engine and swaps the calling thread's session,
+ * or the default session, into usrblk.
+ */
+static void     lock_engine (void)
+{
+    DtSrSession    *session;
+
+    pthread_once (&session_once, session_key_init);
+    if ((session = pthread_getspecific (session_key)) == NULL)
+	session = &default_session;
+    aa_api_lock ();
+    if (session == usrblk_session)
+	return;
+
+    if (usrblk_session) {
+	usrblk_session->stemcount = usrblk.stemcount;
+	memcpy (usrblk_session->stems, usrblk.stems, sizeof(usrblk.stems));
+	usrblk_session->cleartext = usrblk.cleartext;
+	usrblk_session->clearlen = usrblk.clearlen;
+	usrblk_session->hitwords = usrblk.hitwords;
+	usrblk_session->hitwcount = usrblk.hitwcount;
+    }
+    usrblk.stemcount = session->stemcount;
+    memcpy (usrblk.stems, session->stems, sizeof(usrblk.stems));
+    usrblk.cleartext = session->cleartext;
+    usrblk.clearlen = session->clearlen;
+    usrblk.hitwords = session->hitwords;
+    usrblk.hitwcount = session->hitwcount;
+    usrblk_session = session;
+    return;
+}  /* lock_engine() */
+
+
+/************************************************/
+/*						*/
+/*		  unlock_engine			*/
+/*						*/
+/************************************************/
+static void     unlock_engine (void)
+{
+    aa_api_unlock ();
+}  /* unlock_engine() */
+
+
+/************************************************/
+/*						*/
+/*	       DtSearchOpenSession		*/
+/*						*/
+/************************************************/
+/* Returns a new, empty session.  Threads that search
+ * at the same time should each use their own session
+ * (DtSearchSetSession) so that one thread's search or
+ * retrieval doesn't replace the stems, cleartext and
+ * hitwords another thread was given.
+ */
+DtSrSession    *DtSearchOpenSession (void)
+{
+    DtSrSession    *session;
+
+    session = austext_malloc (sizeof (DtSrSession), PROGNAME "140", NULL);
+    memset (session, 0, sizeof (DtSrSession));
+    session->search_type = '$';
+    return session;
+}  /* DtSearchOpenSession() */
+
+
+/************************************************/
+/*						*/
+/*	       DtSearchCloseSession		*/
+/*						*/
+/************************************************/
+/* Frees a session from DtSearchOpenSession() and the cleartext
+ * and hitwords it still owns.  If it is the calling thread's
+ * session, the thread goes back to the default session.
+ */
+void            DtSearchCloseSession (DtSrSession *session)
+{
+    if (session == NULL || session == &default_session)
+	return;
+    pthread_once (&session_once, session_key_init);
+    if (pthread_getspecific (session_key) == session)
+	pthread_setspecific (session_key, NULL);
+
+    aa_api_lock ();
+    if (session == usrblk_session) {
+	clear_usrblk_record ();
+	clear_hitwords ();
+	usrblk_session = NULL;
+    }
+    else {
+	if (session->cleartext)
+	    free (session->cleartext);
+	if (session->hitwords)
+	    free (session->hitwords);
+    }
+    aa_api_unlock ();
+    free (session);
+    return;
+}  /* DtSearchCloseSession() */
+
+
+/************************************************/
+/*						*/
+/*	        DtSearchSetSession		*/
+/*						*/
+/************************************************/
+/* Makes session the one used by the calling thread's
+ * subsequent api calls.  NULL selects the default session
+ * shared by all threads that never set one.
+ * Returns the thread's previous session, NULL if default.
+ */
+DtSrSession    *DtSearchSetSession (DtSrSession *session)
+{
+    DtSrSession    *previous;
+
+    pthread_once (&session_once, session_key_init);
+    previous = pthread_getspecific (session_key);
+    pthread_setspecific (session_key,
+	(session == &default_session) ? NULL : session);
+    return previous;
+}  /* DtSearchSetSession() */
+
+
+/************************************************/
+/*						*/
+/*	        DtSearchCacheStats		*/
+/*						*/
+/************************************************/
+/* Returns the number of database page requests found in the
+ * vista cache and read from file since DtSearchInit, and the
+ * number of cache pages (0 if no database is open).
+ * Any of the pointers may be NULL.
+ */
+void            DtSearchCacheStats (long *hits, long *misses, int *pages)
+{
+    aa_api_lock ();
+    d_cachestats (hits, misses, pages);
+    aa_api_unlock ();
+    return;
+}  /* DtSearchCacheStats() */
+
+
 /************************************************/
 /*						*/
 /*		   valid_dbname			*/
@@ -284,14 +521,14 @@ static int      aa_reinit (void)
 
 /************************************************/
 /*						*/
-/*		  DtSearchInit			*/
+/*		 api_init			*/
 /*						*/
 /************************************************/
 /* Initializes ausapi and the AusText engine (performs OE_INIT).
  * Must be first ausapi call.  Must be called only once (reinit?).
  * See dtsearch.doc for specs.
  */
-int             DtSearchInit (
+static int      api_init (
                     char	*argv0,
                     char	*userid,
                     long	switches,
@@ -408,19 +645,44 @@ int             DtSearchInit (
     }
 
     return DtSrOK;
+}  /* api_init() */
+
+
+/************************************************/
+/*						*/
+/*		 DtSearchInit			*/
+/*						*/
+/************************************************/
+/* Public api wrapper: api_init() under the engine lock. */
+int             DtSearchInit (
+                    char	*argv0,
+                    char	*userid,
+                    long	switches,
+                    char	*config_file,
+                    FILE	*err_file,
+                    char	***dbnames,
+                    int		*dbcount)
+{
+    int             retncode;
+
+    lock_engine ();
+    retncode = api_init (argv0, userid, switches, config_file, err_file,
+	dbnames, dbcount);
+    unlock_engine ();
+    return retncode;
 }  /* DtSearchInit() */
 
 
 /************************************************/
 /*						*/
-/*	         DtSearchReinit			*/
+/*		 api_reinit			*/
 /*						*/
 /************************************************/
 /* Returns pointer to dbnames array.
  * Used after database or config file changes to trigger
  * engine reinitialization and to reaccess the database names.
  */
-int	DtSearchReinit (char ***dbnames, int *dbcount)
+static int      api_reinit (char ***dbnames, int *dbcount)
 {
     aa_check_initialization();
     usrblk.request = OE_PING;
@@ -444,12 +706,29 @@ int	DtSearchReinit (char ***dbnames, int *dbcount)
 	default:
 	    return DtSrERROR;
     }
+}  /* api_reinit() */
+
+
+/************************************************/
+/*						*/
+/*		 DtSearchReinit			*/
+/*						*/
+/************************************************/
+/* Public api wrapper: api_reinit() under the engine lock. */
+int	DtSearchReinit (char ***dbnames, int *dbcount)
+{
+    int             retncode;
+
+    lock_engine ();
+    retncode = api_reinit (dbnames, dbcount);
+    unlock_engine ();
+    return retncode;
 }  /* DtSearchReinit() */
 
 
 /************************************************/
 /*						*/
-/*	       DtSearchGetKeytypes		*/
+/*		 api_keytypes			*/
 /*						*/
 /************************************************/
 /* Returns pointer to keytypes array of specified database.
@@ -457,7 +736,7 @@ int	DtSearchReinit (char ***dbnames, int *dbcount)
  * Caller may modify is_selected field but should
  * not alter other keytypes fields or pointers.
  */
-int	DtSearchGetKeytypes (
+static int      api_keytypes (
 		char	    *dbname,	/* 1 - 8 char database name */
 		int	    *ktcount,	/* number entries in array */
 		DtSrKeytype **keytypes)	/* array of database types */
@@ -467,6 +746,26 @@ int	DtSearchGetKeytypes (
     *ktcount = usrblk.dblk->ktcount;
     *keytypes = usrblk.dblk->keytypes;
     return DtSrOK;
+}  /* api_keytypes() */
+
+
+/************************************************/
+/*						*/
+/*		 DtSearchGetKeytypes		*/
+/*						*/
+/************************************************/
+/* Public api wrapper: api_keytypes() under the engine lock. */
+int	DtSearchGetKeytypes (
+		char	    *dbname,
+		int	    *ktcount,
+		DtSrKeytype **keytypes)
+{
+    int             retncode;
+
+    lock_engine ();
+    retncode = api_keytypes (dbname, ktcount, keytypes);
+    unlock_engine ();
+    return retncode;
 }  /* DtSearchGetKeytypes() */
 
 
@@ -508,7 +807,7 @@ static int      both_valid_dates (char *date1, char *date2)
 
 /************************************************/
 /*						*/
-/*		  DtSearchQuery			*/
+/*		 api_query			*/
 /*						*/
 /************************************************/
 /* Returns hitlist (dittolist) if search successful.
@@ -524,7 +823,7 @@ static int      both_valid_dates (char *date1, char *date2)
  * array of FZKEYSZ integers.
  * DtSearchQuery() was formerly named ausapi_search().
  */
-int             DtSearchQuery (
+static int      api_query (
 		void	*qry,		/* query, fzkeyi, nav string */
 		char	*dbname,	/* database name from dbnamesv */
 		int	search_type,	/* 'P', 'W', 'S', 'T', 'Z', or 'N' */
@@ -611,7 +910,7 @@ QUERY_ERROR:
     db = usrblk.dblk;
     db->maxhits = aa_maxhits;
     if (qryarg == TEXT)
-	save_search_type = usrblk.search_type = search_type;
+	usrblk_session->search_type = usrblk.search_type = search_type;
 
     if (usrblk.debug & USRDBG_SRCHCMPL) {
 	ptr = sprintbuf;
@@ -705,19 +1004,47 @@ END_OF_SEARCH:
 	     */
 	    return DtSrERROR;
     }	/* end switch */
+}  /* api_query() */
+
+
+/************************************************/
+/*						*/
+/*		 DtSearchQuery			*/
+/*						*/
+/************************************************/
+/* Public api wrapper: api_query() under the engine lock. */
+int             DtSearchQuery (
+		void	*qry,
+		char	*dbname,
+		int	search_type,
+		char	*date1,
+		char	*date2,
+		DtSrResult
+			**dittolist,
+		long	*dittocount,
+		char	*stems,
+		int	*stemcount)
+{
+    int             retncode;
+
+    lock_engine ();
+    retncode = api_query (qry, dbname, search_type, date1, date2,
+	dittolist, dittocount, stems, stemcount);
+    unlock_engine ();
+    return retncode;
 }  /* DtSearchQuery() */
 
 
 /************************************************/
 /*						*/
-/*		 DtSearchRetrieve		*/
+/*		 api_retrieve			*/
 /*						*/
 /************************************************/
 /* Mallocs and returns cleartext of a record given database address (dba).
  * fzkey integers start at bkt #2, just like categories.
  * WARNING! USER SHOULD NEITHER MALLOC NOR FREE HIS CLEARTEXT POINTER!
  */
-int             DtSearchRetrieve (
+static int      api_retrieve (
                     char *dbname,	/* 1 - 8 char database name */
                     DB_ADDR dba,	/* database address from dittolist */
                     char **cleartext,	/* cleartext put here (freed first) */
@@ -761,13 +1088,35 @@ int             DtSearchRetrieve (
 	     */
 	    return DtSrERROR;
     }	/* end switch */
+}  /* api_retrieve() */
+
+
+/************************************************/
+/*						*/
+/*		 DtSearchRetrieve		*/
+/*						*/
+/************************************************/
+/* Public api wrapper: api_retrieve() under the engine lock. */
+int             DtSearchRetrieve (
+                    char *dbname,
+                    DB_ADDR dba,
+                    char **cleartext,
+                    long *clearlen,
+                    int *fzkeyi)
+{
+    int             retncode;
+
+    lock_engine ();
+    retncode = api_retrieve (dbname, dba, cleartext, clearlen, fzkeyi);
+    unlock_engine ();
+    return retncode;
 }  /* DtSearchRetrieve() */
 
 
 
 /************************************************/
 /*						*/
-/*		 DtSearchHighlight		*/
+/*		 api_highlight			*/
 /*						*/
 /************************************************/
 /* Mallocs and returns hitwords array for passed text string
@@ -776,13 +1125,13 @@ int             DtSearchRetrieve (
  * the passed stems array MUST be defined:
  *      char   stems [DtSrMAX_STEMCOUNT] [DtSrMAXWIDTH_HWORD].
  */
-int             DtSearchHighlight (
+static int      api_highlight (
                     char *dbname,	/* database name */
                     char *cleartext,	/* text to be hilited */
                     DtSrHitword ** hitwords,
 					/* where to put hitwords array */
                     long *hitwcount,	/* num items in hitwords array */
-                    int search_type,	/* [opt] override save_search_type */
+                    int search_type,	/* [opt] override last search type */
                     char *stems,	/* [opt] override last search stems */
                     int stemcount	/* num stems in stems array */
 )
@@ -813,7 +1162,7 @@ int             DtSearchHighlight (
     if (search_type)
 	usrblk.search_type = search_type;
     else
-	usrblk.search_type = save_search_type;
+	usrblk.search_type = usrblk_session->search_type;
 
     if (stems) {
 	if (stemcount > DtSrMAX_STEMCOUNT) {
@@ -874,6 +1223,31 @@ int             DtSearchHighlight (
 	    }
 	    return DtSrERROR;
     }	/* end switch */
+}  /* api_highlight() */
+
+
+/************************************************/
+/*						*/
+/*		 DtSearchHighlight		*/
+/*						*/
+/************************************************/
+/* Public api wrapper: api_highlight() under the engine lock. */
+int             DtSearchHighlight (
+                    char *dbname,
+                    char *cleartext,
+                    DtSrHitword ** hitwords,
+                    long *hitwcount,
+                    int search_type,
+                    char *stems,
+                    int stemcount)
+{
+    int             retncode;
+
+    lock_engine ();
+    retncode = api_highlight (dbname, cleartext, hitwords, hitwcount,
+	search_type, stems, stemcount);
+    unlock_engine ();
+    return retncode;
 }  /* DtSearchHighlight() */
 
 /**************************** DTSRAPI.C *************************/
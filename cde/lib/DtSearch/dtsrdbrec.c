@@ -272,6 +272,12 @@ void            print_dbrec (char *dbname, struct or_dbrec * dbrec)
 	CATGETS(dtsearch_catd, MS_dbrec, 172, "MULTIPLE bytes") :
 	CATGETS(dtsearch_catd, MS_dbrec, 174, "a SINGLE byte"));
 
+    printf (CATGETS(dtsearch_catd, MS_dbrec, 176,
+	    "  Inverted index addresses are %s by record number.\n"),
+	(ORD_SORTEDD99 & dbrec->or_dbflags) ?
+	CATGETS(dtsearch_catd, MS_dbrec, 177, "SORTED") :
+	CATGETS(dtsearch_catd, MS_dbrec, 178, "NOT SORTED"));
+
     printf (CATGETS(dtsearch_catd, MS_dbrec, 200,
 	    "Current number of database objects (reccount) is %ld.\n"),
 	dbrec->or_reccount);
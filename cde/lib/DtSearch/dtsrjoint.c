@@ -297,10 +297,21 @@ char	*DtSearchFormatObjdate (DtSrObjdate objdate)
 /*						*/
 /************************************************/
 int	DtSearchGetMaxResults (void)
-{ return aa_maxhits; }
+{
+    int		maxhits;
+
+    aa_api_lock ();
+    maxhits = aa_maxhits;
+    aa_api_unlock ();
+    return maxhits;
+}
 
 void	DtSearchSetMaxResults (int newmax)
-{ aa_maxhits = newmax; }
+{
+    aa_api_lock ();
+    aa_maxhits = newmax;
+    aa_api_unlock ();
+}
 
 
 /************************************************/
@@ -314,7 +325,9 @@ void	DtSearchSetMaxResults (int newmax)
  */
 int             DtSearchFreeResults (DtSrResult ** dittolist)
 {
+    aa_api_lock ();
     free_llist ((LLIST **) dittolist);
+    aa_api_unlock ();
     return DtSrOK;
 }  /* DtSearchFreeResults() */
 
@@ -331,7 +344,7 @@ int             DtSearchFreeResults (DtSrResult ** dittolist)
  * else returns DtSrERROR for programming error.
  * Formerly named aa_merge_dittolists.
  */
-int	DtSearchMergeResults (DtSrResult **targ_list, DtSrResult **src_list)
+static int	merge_results (DtSrResult **targ_list, DtSrResult **src_list)
 {
     DtSrResult     *targ, *src, *nextsrc, **prevtargl;
 
@@ -393,6 +406,16 @@ int	DtSearchMergeResults (DtSrResult **targ_list, DtSrResult **src_list)
 
     *src_list = NULL;
     return DtSrOK;
+}  /* merge_results() */
+
+int	DtSearchMergeResults (DtSrResult **targ_list, DtSrResult **src_list)
+{
+    int		retn;
+
+    aa_api_lock ();
+    retn = merge_results (targ_list, src_list);
+    aa_api_unlock ();
+    return retn;
 }  /* DtSearchMergeResults() */
 
 
@@ -600,8 +623,10 @@ int             DtSearchSortResults (DtSrResult ** dittolist, int sort_type)
     switch (sort_type) {
 	case DtSrSORT_PROX:
 	case DtSrSORT_DATE:
+	    aa_api_lock ();	/* ditsort_type is shared */
 	    ditsort_type = sort_type;
 	    *dittolist = ditto_sort (*dittolist);	/* recursive call */
+	    aa_api_unlock ();
 	    return DtSrOK;
 	default:
 	    DtSearchAddMessage (PROGNAME "140 "
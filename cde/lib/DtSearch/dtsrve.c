@@ -169,7 +169,9 @@ int             ve_initialize (void)
 
     /* ---- PASS #1 and #2 ------------------------------------------
      * Open the d99 and vista database files.
+     * The vista cache grows to the CACHEKB budget, if any.
      */
+    d_setcache (OE_cache_kbytes);
     if (!open_dblk (&usrblk.dblist, 64, debugging))
 	return FALSE;
 
@@ -59,7 +59,14 @@
 /*					*/
 /****************************************/
 int	DtSearchHasMessages (void)
-{ return (ausapi_msglist != NULL); }
+{
+    int		has;
+
+    aa_api_lock ();
+    has = (ausapi_msglist != NULL);
+    aa_api_unlock ();
+    return has;
+}
 
 
 /****************************************/
@@ -68,7 +75,11 @@ int	DtSearchHasMessages (void)
 /*					*/
 /****************************************/
 void	DtSearchFreeMessages (void)
-{ free_llist (&ausapi_msglist); }
+{
+    aa_api_lock ();
+    free_llist (&ausapi_msglist);
+    aa_api_unlock ();
+}
 
 
 /****************************************/
@@ -91,8 +102,10 @@ void	DtSearchAddMessage (char *msg)
     new->link = NULL;
     new->data = new + 1;	/* hop over exactly 1 LLIST structure */
     strcpy (new->data, msg);
+    aa_api_lock ();
     for ( pp = &ausapi_msglist;  *pp != NULL;  pp = &((*pp)->link) ) ;
     *pp = new;
+    aa_api_unlock ();
     return;
 } /* DtSearchAddMessage() */
 
@@ -105,6 +118,7 @@ void	DtSearchAddMessage (char *msg)
 /* July 1994,
  * DtSearchGetMessages was formerly flatmessages().
  * Copies all msgs in ausapi_msglist into single, flat text buffer.
+ * The buffer is reused by the next call.
  */
 char	*DtSearchGetMessages (void)
 {
@@ -117,8 +131,11 @@ char	*DtSearchGetMessages (void)
     /* Since function is often used as an arg in printf,
      * be sure to return something safe when there are no msgs.
      */
-    if (ausapi_msglist == NULL)
+    aa_api_lock ();
+    if (ausapi_msglist == NULL) {
+	aa_api_unlock ();
 	return "";
+    }
 
     /* First Pass: Get the total length.
      * including room for inserted \n's.
@@ -154,6 +171,7 @@ char	*DtSearchGetMessages (void)
      * insert their own final \n.
      */
     targ[-2] = 0;
+    aa_api_unlock ();
     return flatbuf;
 }  /* DtSearchGetMessages() */
 
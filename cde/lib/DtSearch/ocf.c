@@ -1111,6 +1111,10 @@ OCFOPEN_OK:
 	    set_long (&OE_words_hitlimit, uprtoken, &strtok_buf);
 	    continue;
 	}
+	if (strcmp (uprtoken, "CACHEKB") == 0) {
+	    set_long (&OE_cache_kbytes, uprtoken, &strtok_buf);
+	    continue;
+	}
 	if (strcmp (token, "d3bug") == 0) {
 	    usrblk.debug |= atol (token + strlen (token) + 1);
 	    printf (PROGNAME "1630 %s: usrblk.debug = %ld, x%08lx.\n",
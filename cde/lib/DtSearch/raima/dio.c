@@ -27,6 +27,8 @@
  *              Pi
  *              cache_init
  *              clear_cache
+ *              d_cachestats
+ *              d_setcache
  *              d_setfiles
  *              d_setpages
  *              dio_clear
@@ -50,12 +52,15 @@
  *              dio_pzread
  *              dio_pzsetts
  *              dio_read
+ *              dio_readahead
  *              dio_release
  *              dio_rrlb
  *              dio_setdef
  *              dio_touch
  *              dio_write
  *              dio_wrlb
+ *              pg_hash_add
+ *              pg_hash_del
  *
  *   ORIGINS: 27, 157
  *
@@ -118,6 +123,7 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <time.h>
+#include <sys/stat.h>
 #include "vista.h"
 #include "dbtype.h"
 #include "dbswab.h"
@@ -133,10 +139,33 @@ int	debugging_dio_close = FALSE;
 
 #define DEFDBPAGES 16         /* default number of database cache pages */
 #define MINDBPAGES 8          /* minimum number of database cache pages */
+#define MAXDBPAGES 32767      /* lu_slot and pg_slot are shorts */
+#define READAHEAD_PAGES 32    /* pages hinted ahead of a sequential scan */
+
+/* Pages are found through a hash of (file, pageno).  Lookup slot
+ * and page slot are always the same, so a slot indexes both tables.
+ */
+#define PG_HASH(f, p) \
+   ((int)(((unsigned long)(p) * 31 + (unsigned long)(f)) & pg_hash_mask))
 
 extern BOOLEAN trcommit;
 
 int db_pgtab_sz = DEFDBPAGES;
+static long db_cache_kbytes = 0L;  /* memory budget for cache, 0 = none */
+
+static INT_P Pg_hash = POINTER_INIT(); /* first slot of each hash chain */
+static INT_P Pg_next = POINTER_INIT(); /* next slot on same hash chain */
+static int pg_hash_mask;
+
+static long cache_hits = 0L;   /* page requests found in cache */
+static long cache_misses = 0L; /* page requests read from file */
+
+static struct
+{
+   FILE_NO file;
+   F_ADDR pageno;
+   F_ADDR hinted;
+} last_read;                  /* last page read and end of readahead */
 
 LOOKUP_ENTRY_P Db_lookup = POINTER_INIT(); /* database page lookup table */
 PAGE_ENTRY_P Dbpg_table = POINTER_INIT(); /* database page table */
@@ -169,8 +198,13 @@ static int dio_pzinit(void);
 static int clear_cache(FILE_NO, FILE_NO);
 static int dio_pzflush(void);
 static int dio_in(PAGE_ENTRY *, LOOKUP_ENTRY *);
+static void dio_readahead(FILE_NO, F_ADDR);
+static void pg_hash_add(int);
+static void pg_hash_del(int);
 
 #define used_files Used_files.ptr
+#define pg_hash Pg_hash.ptr
+#define pg_next Pg_next.ptr
 #define db_lookup Db_lookup.ptr
 #define dbpg_table Dbpg_table.ptr
 
@@ -201,6 +235,41 @@ int ixpgs  /* # of index cache pages - ignored in single-user version */
    if ( dbpg_table ) return( dberr(S_SETPAGES) );
 
    db_pgtab_sz = (dbpgs <= MINDBPAGES) ? MINDBPAGES : dbpgs;
+   if ( db_pgtab_sz > MAXDBPAGES )
+      db_pgtab_sz = MAXDBPAGES;
+
+   return( db_status = S_OKAY );
+}
+
+
+/* Set memory budget for database cache, in kbytes.
+ * When opened, the cache gets as many pages as the budget
+ * allows, but no more than the database files hold,
+ * and no fewer than set by d_setpages.  Zero turns it off.
+ */
+int
+d_setcache(long kbytes)
+{
+   if ( dbpg_table ) return( dberr(S_SETPAGES) );
+
+   db_cache_kbytes = (kbytes < 0L) ? 0L : kbytes;
+
+   return( db_status = S_OKAY );
+}
+
+
+/* Return database cache counters
+*/
+int
+d_cachestats(
+long *hits,   /* page requests found in cache */
+long *misses, /* page requests read from file */
+int *pages    /* # of db cache pages */
+)
+{
+   if ( hits ) *hits = cache_hits;
+   if ( misses ) *misses = cache_misses;
+   if ( pages ) *pages = dbpg_table ? db_pgtab_sz : 0;
 
    return( db_status = S_OKAY );
 }
@@ -286,6 +355,7 @@ int
 dio_init(void)
 {
    CHAR_P Tempbuff;
+   int i;
 #define tempbuff Tempbuff.ptr
 
 #ifdef DEBUG_DIO
@@ -316,6 +386,26 @@ dio_init(void)
       return( S_OKAY );
    } /* end if ( dbpg_table ) */
 
+   /* size cache from memory budget */
+   if ( db_cache_kbytes > 0L ) {
+      struct stat st;
+      long budget, filepgs;
+
+      budget = db_cache_kbytes * 1024L / page_size;
+      for (i = 0, filepgs = 0L; i < size_ft && filepgs < budget; ++i) {
+	 if ( stat(file_table[i].ft_name, &st) == 0 )
+	    filepgs += st.st_size / file_table[i].ft_pgsize + 1;
+      }
+      if ( filepgs < budget )
+	 budget = filepgs;
+      if ( budget > MAXDBPAGES )
+	 budget = MAXDBPAGES;
+      if ( budget > db_pgtab_sz )
+	 db_pgtab_sz = (int)budget;
+   }
+   for (pg_hash_mask = 1; pg_hash_mask < 2*db_pgtab_sz; pg_hash_mask <<= 1)
+      ;
+
    used_files =
 	/* Macro references must be on one line for some compilers */ 
 	(int *)ALLOC(&Used_files, (size_ft+1)*sizeof(int), "used_files");
@@ -327,6 +417,12 @@ dio_init(void)
 	/* Macro references must be on one line for some compilers */ 
 	(PAGE_ENTRY *)
 	ALLOC(&Dbpg_table, db_pgtab_sz*sizeof(PAGE_ENTRY), "dbpg_table");
+   pg_hash =
+	/* Macro references must be on one line for some compilers */ 
+	(int *)ALLOC(&Pg_hash, pg_hash_mask*sizeof(int), "pg_hash");
+   pg_next =
+	/* Macro references must be on one line for some compilers */ 
+	(int *)ALLOC(&Pg_next, db_pgtab_sz*sizeof(int), "pg_next");
 #ifdef DEBUG_DIO
    if (debugging_dio_init) {
 	printf (__FILE__"345 dio_init: usedfls=%p lookup=%p pgtab=%p\n",
@@ -334,13 +430,20 @@ dio_init(void)
 	fflush(stdout);
    }
 #endif
-   if ( !used_files || !dbpg_table || !db_lookup )
+   if ( !used_files || !dbpg_table || !db_lookup || !pg_hash || !pg_next )
       return( dberr(S_NOMEMORY) );
    byteset(used_files, 0, (size_ft + 1)*sizeof(*used_files));
+   for (i = 0; i < pg_hash_mask; ++i)
+      pg_hash[i] = -1;
+   --pg_hash_mask;
 
    last_dblu.file = -1;
    last_dblu.pageno = -1L;
    last_dblu.slot = -1;
+   last_read.file = -1;
+   last_read.pageno = -1L;
+   last_read.hinted = -1L;
+   cache_hits = cache_misses = 0L;
 
    /* initialize database cache */
    cache_init((int)db_pgtab_sz, db_lookup, dbpg_table, (int)page_size);
@@ -422,6 +525,10 @@ void dio_free(void)
    FREE(&Used_files);
    MEM_UNLOCK(&Db_lookup);
    FREE(&Db_lookup);
+   MEM_UNLOCK(&Pg_hash);
+   FREE(&Pg_hash);
+   MEM_UNLOCK(&Pg_next);
+   FREE(&Pg_next);
    for (pgt_lc = db_pgtab_sz, pg_ptr = dbpg_table; --pgt_lc >= 0; ++pg_ptr) {
       MEM_UNLOCK(&pg_ptr->Buff);
       FREE(&pg_ptr->Buff);
@@ -477,8 +584,7 @@ FILE_NO to_file    /* ..to (not thru) file "to_file" */
    FILE_NO s_file;   /* start file to be cleared */
    FILE_NO e_file;   /* end file (+1) to be cleared */
    int i;
-   LOOKUP_ENTRY *lu_ptr, *lu2_ptr;
-   int pg_slot;
+   LOOKUP_ENTRY *lu_ptr;
    PAGE_ENTRY *pg_ptr;
    PGZERO *pgzero_ptr;
    FILE_ENTRY *file_ptr;
@@ -491,45 +597,24 @@ FILE_NO to_file    /* ..to (not thru) file "to_file" */
 	 ++e_file;
       else {
 	 if (s_file < e_file) {
-	    /* find range of pages to be cleared */
-	    dio_findpg(s_file, 0L, NULL, NULL, &lu_ptr);
-	    dio_findpg(e_file, 0L, NULL, NULL, &lu2_ptr);
-
 	    last_dblu.file = -1;
 	    last_dblu.pageno = -1L;
 	    last_dblu.slot = -1;
 
-	    if (lu_ptr < lu2_ptr) { /* otherwise file has no pages in cache */
-	       /* adjust lookup table entries */
-	       while ((lu_ptr > db_lookup) && ((--lu_ptr)->file >= 0)) {
-		  --lu2_ptr;
-
-		  lu2_ptr->file = lu_ptr->file;
-		  lu2_ptr->pageno = lu_ptr->pageno;
-		  /* exchange page slot numbers */
-                  pg_slot = lu_ptr->pg_slot;
-                  lu_ptr->pg_slot = lu2_ptr->pg_slot;
-                  lu2_ptr->pg_slot = pg_slot;
-                  dbpg_table[pg_slot].lu_slot = lu2_ptr - db_lookup;
-		  dbpg_table[lu_ptr->pg_slot].lu_slot = lu_ptr - db_lookup;
-	       }
-
-	       if ( lu_ptr->file < 0 )
-		  ++lu_ptr;
-
-	       while (lu_ptr < lu2_ptr) {
-
-		  lu_ptr->file = -1;
-		  lu_ptr->pageno = -1L;
-                  pg_ptr = &dbpg_table[lu_ptr->pg_slot];
-		  if ( pg_ptr->modified || pg_ptr->holdcnt ) {
-		     --no_modheld;
-		     pg_ptr->modified = FALSE;
-		  }
-		  pg_ptr->recently_used = FALSE;
-		  pg_ptr->holdcnt = 0;
-		  ++lu_ptr;
+	    /* clear every page of the files from the cache */
+	    for (i = 0, lu_ptr = db_lookup; i < db_pgtab_sz; ++i, ++lu_ptr) {
+	       if (lu_ptr->file < s_file || lu_ptr->file >= e_file)
+		  continue;
+	       pg_hash_del(i);
+	       lu_ptr->file = -1;
+	       lu_ptr->pageno = -1L;
+	       pg_ptr = &dbpg_table[i];
+	       if ( pg_ptr->modified || pg_ptr->holdcnt ) {
+		  --no_modheld;
+		  pg_ptr->modified = FALSE;
 	       }
+	       pg_ptr->recently_used = FALSE;
+	       pg_ptr->holdcnt = 0;
 	    }
 	    /* clear page zeroes and close files */
 	    for (i = s_file, pgzero_ptr = &pgzero[i];
@@ -811,10 +896,8 @@ LOOKUP_ENTRY * *xlu_ptr /* pointer to lookup table slot for found page*/
 {
    LOOKUP_ENTRY *lookup;  /* = db_lookup or ix_lookup */
    int pgtab_sz;          /* = db_pgtab_sz or ix_pgtab_sz */
-   long cmp = 0;
    int cnt;
-   int lu_slot = 0, l, u;
-   LOOKUP_ENTRY *lu_ptr = NULL, *replu_ptr;
+   LOOKUP_ENTRY *lu_ptr;
    PAGE_ENTRY *pg_ptr;
    int *lru_ptr;
    int pg_slot;
@@ -825,42 +908,37 @@ LOOKUP_ENTRY * *xlu_ptr /* pointer to lookup table slot for found page*/
       if (xlu_ptr != NULL)
          *xlu_ptr = &db_lookup[last_dblu.slot];
       if (xpg_ptr != NULL)
-         *xpg_ptr = &dbpg_table[db_lookup[last_dblu.slot].pg_slot];
+         *xpg_ptr = &dbpg_table[last_dblu.slot];
+      ++cache_hits;
       return( db_status = S_OKAY );
    }
    lookup = db_lookup;
    pgtab_sz = db_pgtab_sz;
-   /* perform binary search of sorted lookup table */
-   l = 0;
-   u = pgtab_sz - 1;
-   while (u >= l) {
-      lu_ptr = &lookup[lu_slot = (l + u)/2];
-	 if ((cmp = file - lu_ptr->file) == 0)
-	    cmp = page - lu_ptr->pageno;
-      if (cmp < 0)
-         u = lu_slot - 1;
-      else if (cmp > 0)
-         l = lu_slot + 1;
-      else {
-            last_dblu.file = lu_ptr->file;
-            last_dblu.pageno = lu_ptr->pageno;
-            last_dblu.slot = lu_slot;
+   /* search hash chain of page */
+   for (pg_slot = pg_hash[PG_HASH(file, page)];
+        pg_slot >= 0;
+        pg_slot = pg_next[pg_slot]) {
+      lu_ptr = &lookup[pg_slot];
+      if ((lu_ptr->file == file) && (lu_ptr->pageno == page)) {
+         last_dblu.file = file;
+         last_dblu.pageno = page;
+         last_dblu.slot = pg_slot;
          if (xlu_ptr != NULL)
             *xlu_ptr = lu_ptr;
          if (xpg_ptr != NULL)
-            *xpg_ptr = &pg_table[lu_ptr->pg_slot];
+            *xpg_ptr = &pg_table[pg_slot];
+         ++cache_hits;
 	 return( db_status = S_OKAY );
       }
    }
    if ( ! pg_table ) {
       /* null page table indicates that only a lookup was desired */
-      if (cmp > 0)
-         ++lu_ptr;
       if (xlu_ptr != NULL)
-         *xlu_ptr = lu_ptr;
+         *xlu_ptr = NULL;
       return( db_status = S_NOTFOUND );
    }
    /* page not found - read into cache */
+   ++cache_misses;
    /* select a page to replace */
    lru_ptr = &dbpg_lru_slot;
    for (cnt = 2*pgtab_sz, pg_slot = *lru_ptr, pg_ptr = &pg_table[pg_slot];
@@ -871,10 +949,9 @@ LOOKUP_ENTRY * *xlu_ptr /* pointer to lookup table slot for found page*/
          pg_slot = 0;
          pg_ptr = pg_table;
       }
-      replu_ptr = &lookup[pg_ptr->lu_slot];
       if (!pg_ptr->recently_used && (pg_ptr->holdcnt == 0)) {
 	 if (pg_ptr->modified) {
-	    dio_out(pg_ptr, replu_ptr);
+	    dio_out(pg_ptr, &lookup[pg_slot]);
 	    pg_ptr->modified = FALSE;
 	    --no_modheld;
 	 }
@@ -889,50 +966,100 @@ LOOKUP_ENTRY * *xlu_ptr /* pointer to lookup table slot for found page*/
    if (cnt < 0)
       return( dberr(S_FAULT) );
 
-   /* adjust lookup table */
-   if (replu_ptr < lu_ptr) {
-      if (cmp < 0)
-      {
-         --lu_ptr;
-         --lu_slot;
-      }
-      while (replu_ptr < lu_ptr) {
-	 bytecpy(replu_ptr, replu_ptr + 1, sizeof(*replu_ptr));
-         pg_table[replu_ptr->pg_slot].lu_slot = replu_ptr - lookup;
-	 ++replu_ptr;
-      }
-   }
-   else if (replu_ptr > lu_ptr) {
-      if (cmp > 0)
-      {
-         ++lu_ptr;
-         ++lu_slot;
-      }
-      while (replu_ptr > lu_ptr) {
-	 bytecpy(replu_ptr, replu_ptr - 1, sizeof(*replu_ptr));
-         pg_table[replu_ptr->pg_slot].lu_slot = replu_ptr - lookup;
-	 --replu_ptr;
-      }
-   }
-
+   /* move replaced slot to hash chain of new page */
+   lu_ptr = &lookup[pg_slot];
+   if (lu_ptr->file >= 0)
+      pg_hash_del(pg_slot);
    lu_ptr->file = file;
    lu_ptr->pageno = page;
-   lu_ptr->pg_slot = pg_slot;
-   pg_ptr->lu_slot = lu_slot;
+   pg_hash_add(pg_slot);
    if (xlu_ptr != NULL)
       *xlu_ptr = lu_ptr;
    if (xpg_ptr != NULL)
       *xpg_ptr = pg_ptr;
-   last_dblu.file = lu_ptr->file;
-   last_dblu.pageno = lu_ptr->pageno;
-   last_dblu.slot = lu_slot;
+   last_dblu.file = file;
+   last_dblu.pageno = page;
+   last_dblu.slot = pg_slot;
+   dio_readahead(file, page);
    dio_in(pg_ptr, lu_ptr);
 
    return( db_status );
-#undef tempbuff
 } /* dio_findpg() */
 
 
+/****************************************/
+/*					*/
+/*		pg_hash_add		*/
+/*					*/
+/****************************************/
+/* Link cache slot into hash chain of its page
+*/
+static void pg_hash_add(int slot)
+{
+   int *head;
+
+   head = &pg_hash[PG_HASH(db_lookup[slot].file, db_lookup[slot].pageno)];
+   pg_next[slot] = *head;
+   *head = slot;
+} /* pg_hash_add() */
+
+
+/****************************************/
+/*					*/
+/*		pg_hash_del		*/
+/*					*/
+/****************************************/
+/* Unlink cache slot from hash chain of its page
+*/
+static void pg_hash_del(int slot)
+{
+   int *link;
+
+   for (link = &pg_hash[PG_HASH(db_lookup[slot].file, db_lookup[slot].pageno)];
+        *link >= 0;
+        link = &pg_next[*link]) {
+      if (*link == slot) {
+         *link = pg_next[slot];
+         break;
+      }
+   }
+} /* pg_hash_del() */
+
+
+/****************************************/
+/*					*/
+/*		dio_readahead		*/
+/*					*/
+/****************************************/
+/* Tell system about sequential page reads.
+ * When pages of a file are read in ascending order,
+ * as d_recnext and d_keynext walks do, the next
+ * READAHEAD_PAGES pages are hinted to the system
+ * so they are read ahead of the walk.
+ */
+static void dio_readahead(FILE_NO file, F_ADDR page)
+{
+#ifdef POSIX_FADV_WILLNEED
+   FILE_ENTRY *file_ptr;
+
+   if (file == last_read.file && page == last_read.pageno + 1) {
+      if (page >= last_read.hinted && dio_open(file) == S_OKAY) {
+	 file_ptr = &file_table[file];
+	 posix_fadvise(file_ptr->ft_desc,
+	    (off_t)(page + 1) * file_ptr->ft_pgsize,
+	    (off_t)READAHEAD_PAGES * file_ptr->ft_pgsize,
+	    POSIX_FADV_WILLNEED);
+	 last_read.hinted = page + READAHEAD_PAGES;
+      }
+   }
+   else
+      last_read.hinted = page;
+#endif
+   last_read.file = file;
+   last_read.pageno = page;
+} /* dio_readahead() */
+
+
 /****************************************/
 /*					*/
 /*		 dio_out		*/
@@ -0,0 +1,231 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/*
+ *   COMPONENT_NAME: austext
+ *
+ *   FUNCTIONS: close_wordpos
+ *              find_wordpos
+ *              find_wordpos_rec
+ *              open_wordpos
+ *              wordpos_size
+ *
+ *   ORIGINS: 27
+ */
+/********************* WORDPOS.C **********************************
+ * Reads the word positions (d96) file, an optional companion
+ * of the d99 inverted index written by dtsrindex.
+ * For every word and stem it holds the byte offset and length
+ * of each occurrence in each record, in the same terms as the
+ * hitwords built by hilite_cleartext(), so collocations can be
+ * resolved without retrieving and parsing the record text.
+ *
+ * All integers are DtSrUINT32 in "network" byte order:
+ * Header:     magic, number of words, offset of directory.
+ * Word block: number of records n, n ascending rec#s,
+ *             n+1 position indexes (first position of each
+ *             record, then the total), then an offset and
+ *             a length for each position.
+ * Directory:  for each word in strcmp order, the offset of
+ *             the word's string and of its block, followed
+ *             by the nul terminated word strings.
+ *
+ * Records are numbered like d99 addrs (rec# base 1).
+ * Records may be missing from a word's block, eg records
+ * indexed before the d96 existed; callers must then
+ * fall back to the text.
+ */
+#include <cde_config.h>
+#include "SearchP.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#define PROGNAME	"WORDPOS"
+
+
+/****************************************/
+/*					*/
+/*		open_wordpos		*/
+/*					*/
+/****************************************/
+/* Maps passed d96 file into wp.
+ * Returns TRUE if successful.  Returns FALSE,
+ * without msgs, if file doesn't exist or is invalid.
+ */
+int	open_wordpos (WORDPOS *wp, char *fname)
+{
+    int		fd;
+    struct stat	statbuf;
+    DtSrUINT32	*hdr;
+    DtSrUINT32	diroffs;
+
+    memset (wp, 0, sizeof(WORDPOS));
+    if ((fd = open (fname, O_RDONLY)) < 0)
+	return FALSE;
+    if (fstat (fd, &statbuf) == -1  ||  statbuf.st_size < 16) {
+	close (fd);
+	return FALSE;
+    }
+    wp->maplen = statbuf.st_size;
+    wp->map = mmap (NULL, wp->maplen, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (wp->map == MAP_FAILED) {
+	wp->map = NULL;
+	return FALSE;
+    }
+
+    /* Directory must fit and the word strings must be terminated */
+    hdr = (DtSrUINT32 *) wp->map;
+    wp->wordcount = ntohl (hdr[1]);
+    diroffs = ntohl (hdr[2]);
+    if (ntohl (hdr[0]) != WORDPOS_MAGIC  ||
+	    diroffs % sizeof(DtSrUINT32) != 0  ||
+	    diroffs > wp->maplen  ||
+	    wp->wordcount > (wp->maplen - diroffs) / (2 * sizeof(DtSrUINT32))  ||
+	    wp->map [wp->maplen - 1] != 0) {
+	close_wordpos (wp);
+	return FALSE;
+    }
+    wp->dir = (DtSrUINT32 *) (wp->map + diroffs);
+    return TRUE;
+} /* open_wordpos() */
+
+
+/****************************************/
+/*					*/
+/*		close_wordpos		*/
+/*					*/
+/****************************************/
+void	close_wordpos (WORDPOS *wp)
+{
+    if (wp->map)
+	munmap (wp->map, wp->maplen);
+    memset (wp, 0, sizeof(WORDPOS));
+    return;
+} /* close_wordpos() */
+
+
+/****************************************/
+/*					*/
+/*		wordpos_size		*/
+/*					*/
+/****************************************/
+/* Returns number of DtSrUINT32s in passed word block */
+DtSrINT32	wordpos_size (DtSrUINT32 *block)
+{
+    DtSrUINT32	nrecs = ntohl (block[0]);
+
+    return 2 + 2 * nrecs + 2 * ntohl (block [1 + 2 * nrecs]);
+} /* wordpos_size() */
+
+
+/****************************************/
+/*					*/
+/*		find_wordpos		*/
+/*					*/
+/****************************************/
+/* Binary searches directory for passed word or stem
+ * (stems have the STEM_CH prefix, as in the d99 index).
+ * Returns its word block, or NULL if not in d96 file.
+ */
+DtSrUINT32	*find_wordpos (WORDPOS *wp, char *word)
+{
+    long	l, u, m;
+    int		cmp;
+    DtSrUINT32	offs, maxints;
+    DtSrUINT32	*block;
+
+    if (wp->map == NULL)
+	return NULL;
+    l = 0;
+    u = (long) wp->wordcount - 1;
+    while (l <= u) {
+	m = (l + u) / 2;
+	if ((offs = ntohl (wp->dir [2 * m])) >= wp->maplen)
+	    return NULL;
+	if ((cmp = strcmp (word, wp->map + offs)) < 0)
+	    u = m - 1;
+	else if (cmp > 0)
+	    l = m + 1;
+	else {
+	    /* Make sure the whole block is inside the file */
+	    offs = ntohl (wp->dir [2 * m + 1]);
+	    if (offs % sizeof(DtSrUINT32) != 0  ||  offs >= wp->maplen)
+		return NULL;
+	    block = (DtSrUINT32 *) (wp->map + offs);
+	    maxints = (wp->maplen - offs) / sizeof(DtSrUINT32);
+	    if (ntohl (block[0]) >= maxints / 2  ||
+		    ntohl (block [1 + 2 * ntohl (block[0])]) >= maxints / 2  ||
+		    (DtSrUINT32) wordpos_size (block) > maxints)
+		return NULL;
+	    return block;
+	}
+    }
+    return NULL;
+} /* find_wordpos() */
+
+
+/****************************************/
+/*					*/
+/*	       find_wordpos_rec		*/
+/*					*/
+/****************************************/
+/* Binary searches passed word block for rec# recno.
+ * Returns number of positions of the word in the record
+ * and sets *posns to the first offset/length pair.
+ * Returns -1 if record isn't in the block.
+ */
+DtSrINT32	find_wordpos_rec (DtSrUINT32 *block, DtSrINT32 recno,
+		    DtSrUINT32 **posns)
+{
+    DtSrUINT32	nrecs = ntohl (block[0]);
+    DtSrUINT32	*recnos = block + 1;
+    DtSrUINT32	*firsts = block + 1 + nrecs;
+    DtSrUINT32	first, next;
+    long	l, u, m;
+    DtSrINT32	r;
+
+    l = 0;
+    u = (long) nrecs - 1;
+    while (l <= u) {
+	m = (l + u) / 2;
+	r = ntohl (recnos [m]);
+	if (recno < r)
+	    u = m - 1;
+	else if (recno > r)
+	    l = m + 1;
+	else {
+	    first = ntohl (firsts [m]);
+	    next = ntohl (firsts [m + 1]);
+	    if (first > next  ||  next > ntohl (firsts [nrecs]))
+		return -1;
+	    *posns = firsts + nrecs + 1 + 2 * first;
+	    return next - first;
+	}
+    }
+    return -1;
+} /* find_wordpos_rec() */
+
+/********************* WORDPOS.C **********************************/
@@ -54,6 +54,7 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <pthread.h>
 #if defined(CSRG_BASED)
 #define MAXINT INT_MAX
 #else
@@ -111,6 +112,43 @@ typedef	struct	type_info
 	char			*orig_attr;
 } type_info_t;
 
+/*
+ * Compiled data criteria.  The value of a DATA_CRITERIA field is
+ * expanded and split into its '!', '&' and '|' separated terms the
+ * first time the field is used, instead of on every call of
+ * DtDtsDataToDataType.  Name and path patterns are classified so that
+ * most mismatches are found with a plain compare before gmatch runs.
+ */
+#define	PAT_GLOB	0	/* general pattern */
+#define	PAT_LITERAL	1	/* no wildcards at all */
+#define	PAT_SUFFIX	2	/* "*literal" */
+#define	PAT_PREFIX	3	/* "literal*" */
+
+typedef	struct	dc_term
+{
+	char		*value;		/* the term, without '!' and separator */
+	int		neg;		/* term is negated */
+	char		sep;		/* following separator, '\0' if last */
+	int		kind;		/* PAT_* */
+	size_t		lit_len;	/* length of literal part */
+} dc_term_t;
+
+typedef	struct	dc_field
+{
+	char		*text;		/* expanded field value, split up */
+	int		term_count;
+	dc_term_t	*terms;
+} dc_field_t;
+
+typedef	struct	dc_record
+{
+	int		field_count;
+	dc_field_t	**fields;	/* compiled on first use */
+} dc_record_t;
+
+static	dc_record_t	*dc_compiled = 0;	/* one per record */
+static	int		dc_compiled_count = 0;
+
 static	DtShmBoson	dtdts_path_pattern = 0;
 static	DtShmBoson	dtdts_name_pattern = 0;
 static	DtShmBoson	dtdts_mode = 0;
@@ -141,6 +179,8 @@ static	DtDtsMMRecord *	name_list(type_info_t *linfo,
 		DtDtsMMRecord *rec_ptr);
 static	const struct stat *get_stat();
 
+static	void	free_compiled(void);
+
 static int      csh_match(const char *, const char *);
 static int      csh_match_star(const char *, const char *);
 
@@ -165,6 +205,8 @@ _DtDtsClear(void)
 	dtdts_da_icon = 0;
 	dtdts_da_description = 0;
 	dtdts_da_label = 0;
+	free_compiled();
+	_DtDtsCacheClose();
 	_DtSvcProcessUnlock();
 }
 
@@ -300,7 +342,7 @@ max_buf(size_t size, type_info_t *info)
 	}
 	if(size > info->mb_size)
 	{
-		info->mb = (char *)realloc(info->mb, info->mb_size);
+		info->mb = (char *)realloc(info->mb, size);
 		info->mb_size = size;
 	}
 	return(info->mb);
@@ -1173,34 +1215,58 @@ type_mode(char *attr, type_info_t *info)
 }
 
 static int
-type_name(const char *name, char *attr)
+match_term(const char *string, dc_term_t *term)
+{
+#ifdef USE_FNMATCH
+	return(!fnmatch(term->value, string, 0));
+#else
+	size_t	len;
+
+	switch(term->kind)
+	{
+	case	PAT_LITERAL:
+		return(strcmp(string, term->value) == 0);
+	case	PAT_SUFFIX:
+		len = strlen(string);
+		if(len < term->lit_len ||
+		   memcmp(string + len - term->lit_len, term->value + 1,
+			  term->lit_len) != 0)
+		{
+			return(0);
+		}
+		break;
+	case	PAT_PREFIX:
+		if(strncmp(string, term->value, term->lit_len) != 0)
+		{
+			return(0);
+		}
+		break;
+	}
+	/* the compare may match in the middle of a multibyte character */
+	return(gmatch(string, term->value));
+#endif
+}
+
+static int
+type_name(const char *name, dc_term_t *term)
 {
 	int	match = 0;
 
 	if(name && name != (char *)-1)
 	{
-#ifdef USE_FNMATCH
-		match = !fnmatch(attr, name, 0);
-#else
-		match =  gmatch(name, attr);
-#endif
+		match = match_term(name, term);
 	}
 	return(match);
 }
 
 static int
-type_path(const char *path, char *attr)
+type_path(const char *path, dc_term_t *term)
 {
-	char	*c;
 	int	match = 0;
 
 	if(path && (intptr_t)path != -1)
 	{
-#ifdef USE_FNMATCH
-		match = !fnmatch(attr, path, 0);
-#else
-		match = gmatch(path, attr);
-#endif
+		match = match_term(path, term);
 	}
 	return(match);
 }
@@ -1229,44 +1295,141 @@ next_sep(char *str, char *sep)
 	return((char *)0);
 }
 
-char	*
-DtDtsDataToDataType(const char *fp,
-	const void		*buf,
-	const int		bs,
-	const struct stat	*fs,
-	const char		*ln,
-	const struct stat	*ls,
-	const char		*on)
+static void
+classify_term(dc_term_t *term)
 {
-	DtDtsMMDatabase	*db;
-	DtDtsMMRecord	*rec_ptr = 0;
-	DtDtsMMRecord	*rec_ptr_list;
-	DtDtsMMField	*fld_ptr;
+	/* a backslash escape forces gmatch, as do all wildcards but '*' */
+	char	*wild = _dt_strpbrk(term->value, "*?[\\");
+
+	if(!wild)
+	{
+		term->kind = PAT_LITERAL;
+		term->lit_len = strlen(term->value);
+	}
+	else if(wild == term->value && *wild == '*' &&
+		!_dt_strpbrk(wild + 1, "*?[\\"))
+	{
+		term->kind = PAT_SUFFIX;
+		term->lit_len = strlen(wild + 1);
+	}
+	else if(*wild == '*' && wild[1] == '\0')
+	{
+		term->kind = PAT_PREFIX;
+		term->lit_len = wild - term->value;
+	}
+	else
+	{
+		term->kind = PAT_GLOB;
+		term->lit_len = 0;
+	}
+}
+
+static dc_field_t *
+compile_field(DtDtsMMField *fld_ptr)
+{
+	dc_field_t	*field = (dc_field_t *)calloc(1, sizeof(dc_field_t));
+	dc_term_t	*term;
+	int		size = 0;
+	char		*attr;
+	char		*new_sep;
+
+	field->text = _DtDtsMMExpandValue(
+			_DtDtsMMBosonToString(fld_ptr->fieldValue));
+	attr = field->text ? field->text : "";
+	do
+	{
+		if(field->term_count == size)
+		{
+			size += 4;
+			field->terms = (dc_term_t *)realloc(field->terms,
+						size * sizeof(dc_term_t));
+		}
+		term = &field->terms[field->term_count++];
+
+		term->neg = 0;
+		while(*attr == '!')
+		{
+			term->neg = !term->neg;
+			attr++;
+		}
+		new_sep = next_sep(attr, "&|\0");
+		if(new_sep == 0)
+		{
+			new_sep = attr + strlen(attr);
+		}
+		term->value = attr;
+		term->sep = *new_sep;
+		if(*new_sep)
+		{
+			*new_sep = '\0';
+			attr = new_sep + 1;
+		}
+		classify_term(term);
+	} while(term->sep);
+
+	return(field);
+}
+
+static dc_field_t *
+get_compiled_field(DtDtsMMDatabase *db, DtDtsMMRecord *rec_ptr, int fld)
+{
+	DtDtsMMRecord	*record_list = _DtDtsMMGetPtr(db->recordList);
 	DtDtsMMField	*fld_ptr_list;
-	type_info_t	*info = 0;
-	int	i;
-	int	j;
-	int	rec_m = 0;
-	int	fld_m = 0;
-	int	atr_m = 0;
-	int	p_atr_m = 1;
-	int	c_atr_m = 1;
-	char	*ot = NULL;
-	char	*file;
-	char	*attr;
-	char	op;
+	dc_record_t	*rec;
 
-	_DtSvcAppLockDefault();
-	_DtSvcProcessLock();
-	db = get_dc_db();
-	if(!db)
+	if(!dc_compiled)
 	{
-		_DtSvcProcessUnlock();
-		_DtSvcAppUnlockDefault();
-		return(strdup("UNKNOWN"));
+		dc_compiled_count = db->recordCount;
+		dc_compiled = (dc_record_t *)calloc(dc_compiled_count,
+						sizeof(dc_record_t));
+	}
+	rec = &dc_compiled[rec_ptr - record_list];
+	if(!rec->fields)
+	{
+		rec->field_count = rec_ptr->fieldCount;
+		rec->fields = (dc_field_t **)calloc(rec->field_count,
+						sizeof(dc_field_t *));
 	}
+	if(!rec->fields[fld])
+	{
+		fld_ptr_list = _DtDtsMMGetPtr(rec_ptr->fieldList);
+		rec->fields[fld] = compile_field(&fld_ptr_list[fld]);
+	}
+	return(rec->fields[fld]);
+}
 
-	info = set_vals(fp, buf, bs, fs, ln, ls, on);
+static void
+free_compiled(void)
+{
+	dc_field_t	*field;
+	int		i;
+	int		j;
+
+	if(!dc_compiled)
+	{
+		return;
+	}
+	for(i = 0; i < dc_compiled_count; i++)
+	{
+		for(j = 0; j < dc_compiled[i].field_count; j++)
+		{
+			if((field = dc_compiled[i].fields[j]))
+			{
+				_DtDtsMMSafeFree(field->text);
+				free(field->terms);
+				free(field);
+			}
+		}
+		free(dc_compiled[i].fields);
+	}
+	free(dc_compiled);
+	dc_compiled = 0;
+	dc_compiled_count = 0;
+}
+
+static void
+init_bosons(void)
+{
 	if(!dtdts_path_pattern)
 	{
 		dtdts_path_pattern = _DtDtsMMStringToBoson(DtDTS_PATH_PATTERN);
@@ -1282,6 +1445,28 @@ DtDtsDataToDataType(const char *fp,
 		dtdts_da_description = _DtDtsMMStringToBoson(DtDTS_DA_DESCRIPTION);
 		dtdts_da_label = _DtDtsMMStringToBoson(DtDTS_DA_LABEL);
 	}
+}
+
+/*
+ * Find the data type described by info.  The bosons must have been
+ * initialized; fields that have not been compiled yet are compiled
+ * on the fly, so the caller must hold the process lock unless all of
+ * them have been compiled already (see DtDtsDataToDataTypeBatch).
+ * Frees info and returns an allocated data type name.
+ */
+static char *
+classify(type_info_t *info, DtDtsMMDatabase *db)
+{
+	DtDtsMMRecord	*rec_ptr = 0;
+	DtDtsMMField	*fld_ptr_list;
+	int	i;
+	int	j;
+	int	rec_m = 0;
+	int	fld_m = 0;
+	int	atr_m = 0;
+	int	p_atr_m = 1;
+	int	c_atr_m = 1;
+	char	*c;
 
 	for(i = 0; !rec_m && (rec_ptr = name_list(info, db, rec_ptr)); i++)
 	{
@@ -1291,51 +1476,21 @@ DtDtsDataToDataType(const char *fp,
 		{
 			char	sep = '&';
 			DtDtsMMField	*fld_ptr = &fld_ptr_list[j];
+			dc_field_t	*field = get_compiled_field(db, rec_ptr, j);
+			dc_term_t	*term = field->terms;
 
 			p_atr_m = 1;
 			c_atr_m = 1;
-			info->orig_attr = _DtDtsMMExpandValue(
-					_DtDtsMMBosonToString(fld_ptr->fieldValue));
-			attr = info->orig_attr;
 			do
 			{
-				int	neg = 0;
-				char	*new_sep;
-				int	n;
-				char	*c;
+				int	neg = term->neg;
 
 				atr_m = 1;
-				while(*attr == '!')
-				{
-					neg = !neg;
-					attr++;
-				}
-				new_sep = next_sep(attr, "&|\0");
-				if(new_sep == 0)
-				{
-					new_sep = attr + strlen(attr);
-				}
-				n = new_sep-attr+1;
-				c = max_buf((size_t)n, info);
-
-				strncpy(c, attr, new_sep-attr);
-				c[new_sep-attr] = '\0';
-				attr = new_sep;
-				new_sep = c;
-/*
-				while(new_sep = (char *)_dt_strpbrk(new_sep, "&|"))
-				{
-					new_sep--;
-					strcpy(new_sep, &new_sep[1]);
-					new_sep++;
-				}
-*/
-
 				if(fld_ptr->fieldName == dtdts_path_pattern)
 				{
 					atr_m = type_path(
 							get_file_path(info),
-							max_buf((size_t)0, info));
+							term);
 				}
 				else if(fld_ptr->fieldName == dtdts_name_pattern)
 				{
@@ -1343,13 +1498,13 @@ DtDtsDataToDataType(const char *fp,
 					{
 						atr_m = type_name(
 							get_name(info),
-							max_buf((size_t)0, info));
+							term);
 					}
 					else
 					{
 						atr_m = type_name(
 							get_opt_name(info),
-							max_buf((size_t)0, info));
+							term);
 					}
 				}
 				else if(fld_ptr->fieldName == dtdts_mode)
@@ -1357,7 +1512,7 @@ DtDtsDataToDataType(const char *fp,
 					if(get_file_path(info))
 					{
 						atr_m = type_mode(
-							max_buf((size_t)0, info), info);
+							term->value, info);
 					}
 					else
 					{
@@ -1368,37 +1523,35 @@ DtDtsDataToDataType(const char *fp,
 				{
 					atr_m = type_name(
 							get_link_name(info),
-							max_buf((size_t)0, info));
+							term);
 
 				}
 				else if(fld_ptr->fieldName == dtdts_link_path)
 				{
 					atr_m = type_path(
 							get_link_path(info),
-							max_buf((size_t)0, info));
+							term);
 				}
 				else if(fld_ptr->fieldName == dtdts_content)
 				{
-					atr_m = type_content(
-							max_buf((size_t)0, info), info);
+					/* type_content may modify its argument */
+					c = max_buf(strlen(term->value)+1, info);
+					strcpy(c, term->value);
+					atr_m = type_content(c, info);
 				}
 				else if(fld_ptr->fieldName == dtdts_data_attributes_name)
 				{
-					info->ot = strdup(max_buf((size_t)0, info));
+					info->ot = strdup(term->value);
 				}
 
 				if(info->error == ELOOP)
 				{
-				        _DtSvcProcessUnlock();
-					_DtSvcAppUnlockDefault();
 					return(
 					   cleanup(DtDTS_DT_RECURSIVE_LINK, info)
 						);
 				}
 				if(info->ot)
 				{
-				        _DtSvcProcessUnlock();
-					_DtSvcAppUnlockDefault();
 					return(cleanup(0, info));
 				}
 
@@ -1413,10 +1566,10 @@ DtDtsDataToDataType(const char *fp,
 					p_atr_m = atr_m || p_atr_m;
 					break;
 				}
-				if(attr && *attr)
+				if(term->sep)
 				{
-					sep = *attr;
-					attr++;
+					sep = term->sep;
+					term++;
 					switch(sep)
 					{
 					case	'&':
@@ -1432,11 +1585,6 @@ DtDtsDataToDataType(const char *fp,
 					c_atr_m = 0;
 				}
 			} while ( c_atr_m );
-			if(info->orig_attr)
-			{
-				_DtDtsMMSafeFree(info->orig_attr);
-				info->orig_attr = 0;
-			}
 
 			if(!p_atr_m)
 			{
@@ -1448,9 +1596,88 @@ DtDtsDataToDataType(const char *fp,
 			rec_m = 1;
 		}
 	}
+	return(cleanup(0, info));
+}
+
+/*
+ * Find the data type of a file, using the data type results cache
+ * (see DtsCache.c) for regular files if it is enabled.
+ */
+static char *
+classify_file(const char *fp,
+	const int		bs,
+	const struct stat	*fs,
+	const char		*ln,
+	const struct stat	*ls,
+	const char		*on,
+	DtDtsMMDatabase		*db)
+{
+	struct	stat	buf;
+	int		cacheable = 0;
+	char		*ot;
+
+	if(fp && *fp == '/' && _DtDtsCacheOpen())
+	{
+		if(!fs && stat(fp, &buf) == 0)
+		{
+			fs = &buf;
+		}
+		if(fs && (fs->st_mode&S_IFMT) == S_IFREG)
+		{
+			ot = _DtDtsCacheLookup(fp, ln, on, fs, ls != 0);
+			if(ot)
+			{
+				return(ot);
+			}
+			cacheable = 1;
+		}
+	}
+
+	ot = classify(set_vals(fp, 0, bs, fs, ln, ls, on), db);
+	if(cacheable)
+	{
+		_DtDtsCacheStore(fp, ln, on, fs, ls != 0, ot);
+	}
+	return(ot);
+}
+
+char	*
+DtDtsDataToDataType(const char *fp,
+	const void		*buf,
+	const int		bs,
+	const struct stat	*fs,
+	const char		*ln,
+	const struct stat	*ls,
+	const char		*on)
+{
+	DtDtsMMDatabase	*db;
+	type_info_t	*info;
+	char		*ot;
+
+	_DtSvcAppLockDefault();
+	_DtSvcProcessLock();
+	db = get_dc_db();
+	if(!db)
+	{
+		_DtSvcProcessUnlock();
+		_DtSvcAppUnlockDefault();
+		return(strdup("UNKNOWN"));
+	}
+
+	init_bosons();
+	if(!buf)
+	{
+		_DtDtsCacheOpen();
+		ot = classify_file(fp, bs, fs, ln, ls, on, db);
+	}
+	else
+	{
+		info = set_vals(fp, buf, bs, fs, ln, ls, on);
+		ot = classify(info, db);
+	}
 	_DtSvcProcessUnlock();
 	_DtSvcAppUnlockDefault();
-	return(cleanup(0, info));
+	return(ot);
 }
 
 char	*
@@ -1467,6 +1694,170 @@ DtDtsBufferToDataType(const void *buffer, const int size, const char *name)
 	return(dt);
 }
 
+/*
+ * DtDtsDataToDataTypeBatch
+ *
+ * The files are typed by up to BATCH_MAX_THREADS threads.  All data
+ * criteria are compiled up front, so the threads only read the
+ * database and need neither the application lock nor the process
+ * lock for the whole classification.  The database must not be
+ * reloaded by another thread while a batch is running.
+ */
+#define	BATCH_MAX_THREADS	16
+#define	BATCH_MIN_PER_THREAD	64	/* don't start threads for less */
+#define	BATCH_CHUNK		32	/* files handed out at a time */
+
+typedef	struct	batch_job
+{
+	DtDtsMMDatabase		*db;
+	int			count;
+	const char		**paths;
+	const struct stat	*stats;
+	char			**results;
+	int			next;
+	pthread_mutex_t		lock;
+} batch_job_t;
+
+static void
+compile_all(DtDtsMMDatabase *db)
+{
+	DtDtsMMRecord	*record_list = _DtDtsMMGetPtr(db->recordList);
+	int		i;
+	int		j;
+
+	for(i = 0; i < db->recordCount; i++)
+	{
+		for(j = 0; j < record_list[i].fieldCount; j++)
+		{
+			get_compiled_field(db, &record_list[i], j);
+		}
+	}
+}
+
+static void *
+batch_worker(void *arg)
+{
+	batch_job_t	*job = (batch_job_t *)arg;
+	int		i;
+	int		end;
+
+	for(;;)
+	{
+		pthread_mutex_lock(&job->lock);
+		i = job->next;
+		job->next += BATCH_CHUNK;
+		pthread_mutex_unlock(&job->lock);
+		if(i >= job->count)
+		{
+			break;
+		}
+
+		end = i + BATCH_CHUNK < job->count ? i + BATCH_CHUNK : job->count;
+		for(; i < end; i++)
+		{
+			job->results[i] = classify_file(job->paths[i], -1,
+				job->stats ? &job->stats[i] : 0,
+				0, 0, 0, job->db);
+		}
+	}
+	return(0);
+}
+
+int
+DtDtsDataToDataTypeBatch(const int count,
+	const char		**filepaths,
+	const struct stat	*stat_buffs,
+	char			**datatypes,
+	char			*buffer,
+	const int		buffer_size)
+{
+	batch_job_t	job;
+	pthread_t	threads[BATCH_MAX_THREADS];
+	int		n_threads;
+	int		i;
+	int		used = 0;
+	int		typed = 0;
+	int		len;
+	long		ncpu;
+
+	if(count <= 0)
+	{
+		return(0);
+	}
+
+	_DtSvcProcessLock();
+	job.db = get_dc_db();
+	if(job.db)
+	{
+		init_bosons();
+		compile_all(job.db);
+		_DtDtsCacheOpen();
+	}
+	_DtSvcProcessUnlock();
+
+	job.count = count;
+	job.paths = filepaths;
+	job.stats = stat_buffs;
+	job.results = (char **)calloc(count, sizeof(char *));
+	job.next = 0;
+	pthread_mutex_init(&job.lock, NULL);
+
+	if(job.db)
+	{
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		n_threads = count / BATCH_MIN_PER_THREAD;
+		if(n_threads > ncpu)
+		{
+			n_threads = ncpu;
+		}
+		if(n_threads > BATCH_MAX_THREADS)
+		{
+			n_threads = BATCH_MAX_THREADS;
+		}
+
+		/* the calling thread is one of the workers */
+		for(i = 0; i < n_threads - 1; i++)
+		{
+			if(pthread_create(&threads[i], NULL,
+					  batch_worker, &job) != 0)
+			{
+				break;
+			}
+		}
+		n_threads = i;
+		batch_worker(&job);
+		for(i = 0; i < n_threads; i++)
+		{
+			pthread_join(threads[i], NULL);
+		}
+	}
+	pthread_mutex_destroy(&job.lock);
+
+	/* copy the results into the caller's buffer, in order */
+	for(i = 0; i < count; i++)
+	{
+		if(!job.results[i])
+		{
+			job.results[i] = strdup("UNKNOWN");
+		}
+		datatypes[i] = 0;
+		if(typed == i)
+		{
+			len = strlen(job.results[i]) + 1;
+			if(used + len <= buffer_size)
+			{
+				datatypes[i] = memcpy(&buffer[used],
+						job.results[i], len);
+				used += len;
+				typed++;
+			}
+		}
+		free(job.results[i]);
+	}
+	free(job.results);
+	return(typed);
+}
+
 static char *
 expand_keyword(const char *attr_in, const char *in_pathname)
 {
@@ -0,0 +1,403 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/*
+ * Data type results cache.
+ *
+ * Remembers the data types of regular files, keyed by device, inode,
+ * size, mode, modification and change times, and the names the file
+ * was typed under, so that typing an unchanged file again doesn't need
+ * to read its contents for CONTENT rules.  The cache is a memory
+ * mapped file in the user's .dt directory, shared by all processes of
+ * the user on this host.  Processes may load different databases (a
+ * different DTDATABASESEARCHPATH or locale) or expand the criteria
+ * differently, so every entry also carries the database version (see
+ * _DtDtsMMDbVersion) and a signature of the expansion environment, and
+ * only matches a process that has both the same.
+ *
+ * The cache is only used if the DTDATATYPECACHE environment variable
+ * is set to a true value.
+ *
+ * Slots are written without locking; every slot carries a checksum,
+ * so a slot being written by another process at the same time is
+ * just a miss.
+ */
+#include <cde_config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include "Dt/DtsMM.h"
+#include "Dt/Dts.h"
+#include "DtSvcLock.h"
+
+#define	DTDTSCACHE_NAME		"%s/.dt/.dt_type_cache.%s"
+#define	DTDTSCACHE_MAGIC	0x44544332	/* "DTC2" */
+#define	DTDTSCACHE_SLOTS	16384
+#define	DTDTSCACHE_WAYS		4
+#define	DTDTSCACHE_TYPE_LEN	56
+
+typedef	struct
+{
+	unsigned int	magic;
+	unsigned int	slots;
+	unsigned int	entry_size;
+	unsigned int	pad;
+} DtDtsCacheHeader;
+
+typedef	struct
+{
+	unsigned int	check;		/* checksum of the rest, 0 if empty */
+	unsigned int	names;		/* hash of the names */
+	unsigned int	db_version;	/* _DtDtsMMDbVersion of the filler */
+	unsigned int	env;		/* expansion environment of the filler */
+	uint64_t	dev;
+	uint64_t	ino;
+	uint64_t	size;
+	int64_t		mtime;
+	int64_t		ctime;
+	unsigned int	mtime_nsec;
+	unsigned int	ctime_nsec;
+	unsigned int	mode;
+	unsigned int	pad;
+	char		datatype[DTDTSCACHE_TYPE_LEN];
+} DtDtsCacheEntry;
+
+static	DtDtsCacheHeader	*cache = 0;
+static	size_t			cache_size = 0;
+static	int			cache_state = 0;	/* 0 unknown, 1 open, -1 off */
+static	unsigned int		cache_db_version = 0;
+static	unsigned int		cache_env = 0;
+
+static unsigned int
+hash_bytes(unsigned int h, const void *p, size_t len)
+{
+	const unsigned char *c = (const unsigned char *)p;
+
+	while(len--)
+	{
+		h = (h ^ *c++) * 16777619u;
+	}
+	return(h);
+}
+
+static unsigned int
+entry_check(DtDtsCacheEntry *entry)
+{
+	unsigned int	h;
+
+	h = hash_bytes(2166136261u, &entry->names,
+		       sizeof(*entry) - sizeof(entry->check));
+	return(h ? h : 1);
+}
+
+static void
+make_key(DtDtsCacheEntry *entry,
+	const char *path,
+	const char *link_name,
+	const char *opt_name,
+	const struct stat *stat_buff,
+	int link_stat)
+{
+	unsigned int	h = 2166136261u;
+
+	memset(entry, 0, sizeof(*entry));
+
+	/* the names take part in NAME_PATTERN, PATH_PATTERN, LINK_* rules */
+	h = hash_bytes(h, path, strlen(path) + 1);
+	if(link_name)
+	{
+		h = hash_bytes(h, link_name, strlen(link_name) + 1);
+	}
+	h = hash_bytes(h, "", 1);
+	if(opt_name)
+	{
+		h = hash_bytes(h, opt_name, strlen(opt_name) + 1);
+	}
+	h = hash_bytes(h, link_stat ? "l" : "", 1);
+
+	entry->names = h;
+	entry->db_version = cache_db_version;
+	entry->env = cache_env;
+	entry->dev = stat_buff->st_dev;
+	entry->ino = stat_buff->st_ino;
+	entry->size = stat_buff->st_size;
+	entry->mtime = stat_buff->st_mtime;
+	entry->ctime = stat_buff->st_ctime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	/* a file rewritten within the same second must not keep its type */
+	entry->mtime_nsec = stat_buff->st_mtim.tv_nsec;
+	entry->ctime_nsec = stat_buff->st_ctim.tv_nsec;
+#endif
+	entry->mode = stat_buff->st_mode;
+}
+
+/*
+ * Signature of everything outside the database that the criteria
+ * depend on: the locale used for matching, and the expanded value of
+ * every criteria field that refers to an environment variable.
+ */
+static unsigned int
+env_signature(void)
+{
+	DtDtsMMDatabase	*db;
+	DtDtsMMRecord	*record_list;
+	DtDtsMMField	*field_list;
+	const char	*value;
+	char		*exp;
+	unsigned int	h = 2166136261u;
+	int		i;
+	int		j;
+
+	value = setlocale(LC_CTYPE, NULL);
+	if(value)
+	{
+		h = hash_bytes(h, value, strlen(value) + 1);
+	}
+
+	db = _DtDtsMMGet(DtDTS_DC_NAME);
+	if(!db)
+	{
+		return(h);
+	}
+	record_list = _DtDtsMMGetPtr(db->recordList);
+	for(i = 0; i < db->recordCount; i++)
+	{
+		field_list = _DtDtsMMGetPtr(record_list[i].fieldList);
+		for(j = 0; j < record_list[i].fieldCount; j++)
+		{
+			value = _DtDtsMMBosonToString(field_list[j].fieldValue);
+			if(!value || !strchr(value, '$'))
+			{
+				continue;
+			}
+			exp = _DtDtsMMExpandValue(value);
+			if(exp)
+			{
+				h = hash_bytes(h, exp, strlen(exp) + 1);
+				free(exp);
+			}
+		}
+	}
+	return(h);
+}
+
+static DtDtsCacheEntry *
+first_slot(DtDtsCacheEntry *key)
+{
+	DtDtsCacheEntry	*slots = (DtDtsCacheEntry *)&cache[1];
+	unsigned int	h;
+
+	h = hash_bytes(key->names, &key->dev, sizeof(key->dev) + sizeof(key->ino));
+	return(&slots[h & (cache->slots - DTDTSCACHE_WAYS)]);
+}
+
+/*
+ * Map the cache file, if the cache is enabled, and clear it if it was
+ * filled from a different database.  Called with the process lock
+ * held; returns 1 if the cache can be used.
+ */
+int
+_DtDtsCacheOpen(void)
+{
+	char		*home;
+	char		host[MAXHOSTNAMELEN + 1];
+	char		*name;
+	struct	stat	buf;
+	int		fd;
+
+	if(cache_state)
+	{
+		return(cache_state > 0);
+	}
+	cache_state = -1;
+
+	if(!DtDtsIsTrue(getenv("DTDATATYPECACHE")) ||
+	   (home = getenv("HOME")) == NULL)
+	{
+		return(0);
+	}
+	if(gethostname(host, sizeof(host)) == -1)
+	{
+		return(0);
+	}
+	host[MAXHOSTNAMELEN] = '\0';
+	name = malloc(strlen(DTDTSCACHE_NAME) + strlen(home) + strlen(host));
+	sprintf(name, DTDTSCACHE_NAME, home, host);
+	fd = open(name, O_RDWR|O_CREAT, 0600);
+	free(name);
+	if(fd == -1)
+	{
+		return(0);
+	}
+
+	cache_size = sizeof(DtDtsCacheHeader) +
+		     DTDTSCACHE_SLOTS * sizeof(DtDtsCacheEntry);
+	if(fstat(fd, &buf) == -1 || buf.st_uid != getuid() ||
+	   (buf.st_size < cache_size && ftruncate(fd, cache_size) == -1))
+	{
+		close(fd);
+		return(0);
+	}
+	cache = (DtDtsCacheHeader *)mmap(NULL, cache_size,
+					 PROT_READ|PROT_WRITE, MAP_SHARED,
+					 fd, 0);
+	close(fd);
+	if(cache == (DtDtsCacheHeader *)MAP_FAILED)
+	{
+		cache = 0;
+		return(0);
+	}
+
+	if(cache->magic != DTDTSCACHE_MAGIC ||
+	   cache->slots != DTDTSCACHE_SLOTS ||
+	   cache->entry_size != sizeof(DtDtsCacheEntry))
+	{
+		cache->magic = 0;
+		memset(&cache[1], 0, DTDTSCACHE_SLOTS * sizeof(DtDtsCacheEntry));
+		cache->slots = DTDTSCACHE_SLOTS;
+		cache->entry_size = sizeof(DtDtsCacheEntry);
+		cache->magic = DTDTSCACHE_MAGIC;
+	}
+	cache_db_version = _DtDtsMMDbVersion();
+	cache_env = env_signature();
+
+	cache_state = 1;
+	return(1);
+}
+
+/*
+ * Unmap the cache; the next _DtDtsCacheOpen checks it against the
+ * database again.
+ */
+void
+_DtDtsCacheClose(void)
+{
+	_DtSvcProcessLock();
+	if(cache)
+	{
+		munmap((caddr_t)cache, cache_size);
+		cache = 0;
+	}
+	cache_state = 0;
+	_DtSvcProcessUnlock();
+}
+
+/*
+ * Returns the cached data type of the file, as an allocated string,
+ * or NULL.
+ */
+char *
+_DtDtsCacheLookup(const char *path,
+	const char *link_name,
+	const char *opt_name,
+	const struct stat *stat_buff,
+	int link_stat)
+{
+	DtDtsCacheEntry	key;
+	DtDtsCacheEntry	entry;
+	DtDtsCacheEntry	*slot;
+	int		i;
+
+	if(!cache)
+	{
+		return(NULL);
+	}
+	make_key(&key, path, link_name, opt_name, stat_buff, link_stat);
+	slot = first_slot(&key);
+	for(i = 0; i < DTDTSCACHE_WAYS; i++)
+	{
+		memcpy(&entry, &slot[i], sizeof(entry));
+		if(entry.check == 0 || entry.check != entry_check(&entry))
+		{
+			continue;
+		}
+		if(entry.names == key.names &&
+		   entry.db_version == key.db_version &&
+		   entry.env == key.env &&
+		   entry.dev == key.dev &&
+		   entry.ino == key.ino &&
+		   entry.size == key.size &&
+		   entry.mtime == key.mtime &&
+		   entry.ctime == key.ctime &&
+		   entry.mtime_nsec == key.mtime_nsec &&
+		   entry.ctime_nsec == key.ctime_nsec &&
+		   entry.mode == key.mode)
+		{
+			entry.datatype[DTDTSCACHE_TYPE_LEN - 1] = '\0';
+			return(strdup(entry.datatype));
+		}
+	}
+	return(NULL);
+}
+
+void
+_DtDtsCacheStore(const char *path,
+	const char *link_name,
+	const char *opt_name,
+	const struct stat *stat_buff,
+	int link_stat,
+	const char *datatype)
+{
+	DtDtsCacheEntry	entry;
+	DtDtsCacheEntry	*slot;
+	int		i;
+
+	if(!cache || strlen(datatype) >= DTDTSCACHE_TYPE_LEN)
+	{
+		return;
+	}
+	make_key(&entry, path, link_name, opt_name, stat_buff, link_stat);
+	strcpy(entry.datatype, datatype);
+	entry.check = entry_check(&entry);
+
+	/* take an empty slot, or the one of this file, or replace one */
+	slot = first_slot(&entry);
+	for(i = 0; i < DTDTSCACHE_WAYS; i++)
+	{
+		if(slot[i].check == 0 ||
+		   (slot[i].dev == entry.dev && slot[i].ino == entry.ino &&
+		    slot[i].names == entry.names &&
+		    slot[i].db_version == entry.db_version &&
+		    slot[i].env == entry.env))
+		{
+			break;
+		}
+	}
+	if(i == DTDTSCACHE_WAYS)
+	{
+		i = (entry.check >> 8) % DTDTSCACHE_WAYS;
+	}
+
+	/* invalidate the slot while it is being written */
+	slot[i].check = 0;
+	memcpy(&slot[i].names, &entry.names,
+	       sizeof(entry) - sizeof(entry.check));
+	slot[i].check = entry.check;
+}
@@ -53,8 +53,13 @@
 #include <Dt/UserMsg.h>
 #include "DtSvcLock.h"
 
+extern char *_DtDbGetDataBaseEnv(void);
+
 extern char *strdup(const char *);
 static int MMValidateDb(DtDirPaths *dirs, char *suffix);
+#define	MM_DB_VALID	1
+#define	MM_DB_STALE	0
+#define	MM_DB_OTHER	(-1)
 static int _debug_print_name(char *name, char *label);
 
 typedef	int	(*genfunc)(const void *, const void *);
@@ -336,15 +341,39 @@ _DtDtsMMInit(int override)
 	else
 	{
 		int success = _DtDtsMMapDB(CacheFile);
+		int shared = 1;
 		if(success)
 		{
-			if(!MMValidateDb(dirs, ".dt"))
+			switch(MMValidateDb(dirs, ".dt"))
 			{
+			case	MM_DB_VALID:
+				_debug_print_name(CacheFile, "Mapped");
+				break;
+			case	MM_DB_OTHER:
+				/* The session's database is right for the
+				   session, just not for our search path or
+				   locale; leave it alone and build a private
+				   one, so that we don't rebuild it back and
+				   forth with the session's other clients. */
+				shared = 0;
 				success = 0;
+				break;
+			default:
+				success = 0;
+				break;
 			}
-			else
+		}
+		if(!success && shared && CacheFile)
+		{
+			/* Rebuild the session's database, so that the
+			   processes started after us can map it instead of
+			   building their own.  The new file is renamed into
+			   place, processes that still map the old one are not
+			   affected. */
+			success = _DtDtsMMCreateDb(dirs, CacheFile, 1);
+			if(success)
 			{
-				_debug_print_name(CacheFile, "Mapped");
+				_debug_print_name(CacheFile, "Rebuilt");
 			}
 		}
 		if(!success)
@@ -638,26 +667,70 @@ _DtDtsMMapDB(const char *CacheFile)
 	return(success);
 }
 
+/*
+ * Identifies what a database is built from, apart from the files
+ * themselves: the database search path and the LANG it is expanded
+ * with.  Processes with another DTDATABASESEARCHPATH or locale than
+ * the session get a different value.
+ */
+unsigned int
+_DtDtsMMSearchHash(void)
+{
+	unsigned int	h = 2166136261u;
+	char		*path = _DtDbGetDataBaseEnv();
+	const char	*lang = getenv("LANG");
+	const unsigned char *c;
+
+	for(c = (const unsigned char *)path; c && *c; c++)
+	{
+		h = (h ^ *c) * 16777619u;
+	}
+	h = (h ^ ',') * 16777619u;
+	for(c = (const unsigned char *)lang; c && *c; c++)
+	{
+		h = (h ^ *c) * 16777619u;
+	}
+	XtFree(path);
+	return(h);
+}
+
+/*
+ * Check that the mapped database is still up to date.  The file list
+ * that build_file_list recorded holds every database directory,
+ * followed by the database files found in it, each with its
+ * modification time.  A database file that is added, removed or
+ * renamed changes the modification time of its directory, so it is
+ * enough to stat the recorded entries and to check that the recorded
+ * directories are still the ones in the search path; there is no need
+ * to read the directories again.
+ *
+ * Returns MM_DB_VALID, MM_DB_STALE if one of the inputs of the
+ * database changed since it was built, or MM_DB_OTHER if it was built
+ * for another search path or locale (see _DtDtsMMSearchHash) than
+ * this process uses.
+ */
 static int
 MMValidateDb(DtDirPaths *dirs, char *suffix)
 {
-	DIR 			*dirp;
-	struct dirent		*direntp;
 	struct stat		buf;
-	struct stat		new_buf;
-	int			size = sizeof(buf.st_mtime);
 	DtShmBoson		*boson_list = 0;
 	time_t			*mtime_list;
 	int			count = 0;
 	int			i;
+	int			dir = 0;
 	const char		*file;
-	int			pathhash = _DtDtsMMPathHash(dirs);
 
 	_DtSvcProcessLock();
-	if(head->pathhash != pathhash)
+	if(head->search_magic != DtDtsMM_SEARCH_MAGIC)
 	{
+		/* written by an older library */
 	        _DtSvcProcessUnlock();
-		return(0);
+		return(MM_DB_STALE);
+	}
+	if(head->search_hash != _DtDtsMMSearchHash())
+	{
+	        _DtSvcProcessUnlock();
+		return(MM_DB_OTHER);
 	}
 
 	count = head->files_count;
@@ -667,17 +740,74 @@ MMValidateDb(DtDirPaths *dirs, char *suffix)
 	for(i = 0; i < count; i++)
 	{
 		file = _DtDtsMMBosonToString(boson_list[i]);
-		stat(file, &buf);
-		if(mtime_list[i]  != buf.st_mtime)
+		if(stat(file, &buf) == -1 || mtime_list[i] != buf.st_mtime)
 		{
 		        _DtSvcProcessUnlock();
-			return(0);
+			return(MM_DB_STALE);
+		}
+		if(S_ISDIR(buf.st_mode))
+		{
+			if(!dirs->paths[dir] || strcmp(file, dirs->paths[dir]) != 0)
+			{
+			        _DtSvcProcessUnlock();
+				return(MM_DB_STALE);
+			}
+			dir++;
 		}
 	}
+	if(dirs->paths[dir])
+	{
+		/* a directory was added to the search path */
+	        _DtSvcProcessUnlock();
+		return(MM_DB_STALE);
+	}
 
 	_DtSvcProcessUnlock();
-	return(1);
+	return(MM_DB_VALID);
+
+}
+
+/*
+ * Identifies the contents of the loaded database: a hash of the path
+ * hash and the names and modification times of the files it was built
+ * from, which is what MMValidateDb checks.  The same database gives
+ * the same value in every process, whether it is shared or private.
+ */
+unsigned int
+_DtDtsMMDbVersion(void)
+{
+	unsigned int	version = 2166136261u;
+	time_t		*mtime_list;
+	DtShmBoson	*boson_list;
+	const char	*file;
+	const unsigned char *c;
+	int		i;
+	int		n;
+
+	_DtSvcProcessLock();
+	if(!mmaped_db)
+	{
+		_DtDtsMMInit(0);
+	}
+	mtime_list = _DtDtsMMGetPtr(head->mtimes_offset);
+	boson_list = _DtDtsMMGetPtr(head->files_offset);
 
+#define	VERSION_ADD(p, len) \
+	for(c = (const unsigned char *)(p), n = (len); n > 0; c++, n--) \
+		version = (version ^ *c) * 16777619u
+
+	VERSION_ADD(&head->pathhash, sizeof(head->pathhash));
+	VERSION_ADD(&head->files_count, sizeof(head->files_count));
+	for(i = 0; i < head->files_count; i++)
+	{
+		file = _DtDtsMMBosonToString(boson_list[i]);
+		VERSION_ADD(file, strlen(file));
+		VERSION_ADD(&mtime_list[i], sizeof(time_t));
+	}
+#undef	VERSION_ADD
+
+	_DtSvcProcessUnlock();
+	return(version);
 }
 
 char *
@@ -104,6 +104,8 @@ _MMWriteDb(DtDirPaths *dirs, int num_db, DtDtsDbDatabase **db_list,
 	_DtMMAddActionsToDataAttribute(db);
 
 	header.pathhash = _DtDtsMMPathHash(dirs);
+	header.search_magic = DtDtsMM_SEARCH_MAGIC;
+	header.search_hash = _DtDtsMMSearchHash();
 	header.num_db = num_db;
 	header.db_offset = build_new_db(shm_handle, int_handle, num_db,
 db_list);
@@ -46,6 +46,7 @@
 #include "mp_s_procid_utils.h"
 
 class _Tt_s_pattern;
+class _Tt_s_pattern_cursor;
 
 class _Tt_s_message : public _Tt_message {
       public:
@@ -103,7 +104,7 @@ class _Tt_s_message : public _Tt_message {
 					const _Tt_msg_trace &trace);
 	int			match_observer(const _Tt_signature &pat,
 					const _Tt_msg_trace &trace);
-	int			match_patterns(_Tt_pattern_list_ptr &patterns,
+	int			match_patterns(_Tt_s_pattern_cursor &pcursor,
 					const _Tt_msg_trace &trace,
 					_Tt_pattern_ptr &best_pattern,
 					int deliver_to_observers);
@@ -51,6 +51,7 @@
 #include "mp_s_procid.h"
 #include "mp_s_procid_utils.h"
 #include "mp/mp_pattern_utils.h"
+#include "mp_s_pattern_index.h"
 #include "mp_typedb_utils.h"
 #include "mp_ptype_utils.h"
 #include "mp_otype_utils.h"
@@ -80,8 +81,7 @@ class _Tt_s_mp : public _Tt_mp {
 	_Tt_ptype_table_ptr		ptable;
 	_Tt_otype_table_ptr		otable;
 	_Tt_sigs_by_op_table_ptr	sigs;
-	_Tt_patlist_table_ptr		opful_pats;
-	_Tt_pattern_list_ptr		opless_pats;
+	_Tt_s_pattern_index_ptr		pattern_index;
 	unsigned int			now;
 	unsigned int			when_last_observer_registered;
 	_Tt_update_args			update_args;
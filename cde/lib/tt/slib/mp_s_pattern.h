@@ -70,6 +70,12 @@ class _Tt_s_pattern : public _Tt_pattern {
 					{ return _timestamp; }
 	void			set_timestamp(unsigned int stamp)
 					{ _timestamp = stamp; }
+	// registration order, used to keep the pattern index lists
+	// newest first (see mp_s_pattern_index.C)
+	unsigned int		serial() const
+					{ return _serial; }
+	void			set_serial(unsigned int serial)
+					{ _serial = serial; }
 
       protected:
 	// server-only methods that aid in matching patterns and
@@ -106,6 +112,7 @@ class _Tt_s_pattern : public _Tt_pattern {
       private:
 	_Tt_ptype_ptr		_generating_ptype;
 	unsigned int		_timestamp;
+	unsigned int		_serial;
 
 	friend class		_Tt_mp;
 	friend class		_Tt_message;
@@ -0,0 +1,117 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/* -*-C++-*-
+ *
+ * mp_s_pattern_index.h
+ *
+ * Tool Talk Message Passer (MP) - mp_s_pattern_index.h
+ *
+ * _Tt_s_pattern_index holds every registered pattern, filed under the
+ * field that best discriminates it, so that a message is only matched
+ * against the patterns that could possibly match it.
+ * _Tt_s_pattern_cursor walks the candidate patterns for one message
+ * in the order a linear scan of all patterns would have seen them.
+ */
+
+#ifndef _MP_S_PATTERN_INDEX_H
+#define _MP_S_PATTERN_INDEX_H
+
+#include "tt_options.h"
+#include "Tt/tt_c.h"
+#include "mp/mp_pattern_utils.h"
+#include "mp_s_pattern_utils.h"
+
+class _Tt_s_message;
+
+//
+// Number of slots for the message class dimension: one per Tt_class
+// plus one for values outside of the enum.
+//
+#define _TT_PATIDX_CLASSES	(TT_CLASS_LAST + 1)
+#define _TT_PATIDX_SCOPES	(TT_FILE_IN_SESSION + 1)
+
+class _Tt_s_pattern_index : public _Tt_object {
+      public:
+	_Tt_s_pattern_index();
+	virtual ~_Tt_s_pattern_index();
+
+	void			add(const _Tt_s_pattern_ptr &p);
+	void			remove(const _Tt_pattern_ptr &p);
+	void			add_file(const _Tt_pattern_ptr &p,
+					 const _Tt_string &file);
+	void			del_file(const _Tt_pattern_ptr &p,
+					 const _Tt_string &file);
+      private:
+	friend class _Tt_s_pattern_cursor;
+
+	void			purge();
+
+	// Each pattern is filed under exactly one of the following,
+	// tried in this order:
+	//   - each of its ops
+	//   - each of its sender ptypes
+	//   - each of its files, if it is only file-scoped
+	//   - each message scope and class it can match
+	_Tt_patlist_table_ptr	_by_op;
+	_Tt_patlist_table_ptr	_by_sender_ptype;
+	_Tt_patlist_table_ptr	_by_file;
+	// file-scoped patterns again, for TT_BOTH messages which
+	// may match them through their session.
+	_Tt_pattern_list_ptr	_file_only;
+	_Tt_pattern_list_ptr	_general[_TT_PATIDX_SCOPES][_TT_PATIDX_CLASSES];
+	// patterns removed while a cursor was open, and the number
+	// of open cursors.
+	_Tt_pattern_list_ptr	_dead;
+	int			_busy;
+};
+
+declare_ptr_to(_Tt_s_pattern_index)
+
+//
+// Merges the (at most four) candidate lists for a message.  Apart
+// from the op list each list is kept newest pattern first, so merging
+// them on the pattern serial number and then walking the op list
+// visits the candidates in the same order as the old single opless
+// list followed by the op list did, which keeps handler tie-breaking
+// unchanged.
+//
+#define _TT_PATIDX_LISTS	4
+
+class _Tt_s_pattern_cursor {
+      public:
+	_Tt_s_pattern_cursor(const _Tt_s_pattern_index_ptr &index,
+			     const _Tt_s_message &m);
+	~_Tt_s_pattern_cursor();
+
+	int			next();
+	_Tt_pattern_ptr		&operator *() const;
+	_Tt_pattern		*operator ->() const;
+      private:
+	_Tt_s_pattern_index_ptr	_index;
+	_Tt_pattern_list_cursor	_lists[_TT_PATIDX_LISTS];
+	int			_live[_TT_PATIDX_LISTS];
+	int			_current;
+	int			_started;
+};
+
+#endif				/* _MP_S_PATTERN_INDEX_H */
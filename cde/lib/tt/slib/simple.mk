@@ -31,6 +31,7 @@ mp_s_msg_context.o \
 mp_s_pat_context.o \
 mp_s_pattern.o \
 mp_s_pattern_utils.o \
+mp_s_pattern_index.o \
 mp_s_procid.o \
 mp_s_procid_utils.o \
 mp_s_session.o \
@@ -103,6 +104,9 @@ mp_s_pattern.o:	mp_s_pattern.C
 mp_s_pattern_utils.o:	mp_s_pattern_utils.C
 	$(CCC) $(CCCFLAGS) -o mp_s_pattern_utils.o -c mp_s_pattern_utils.C
 
+mp_s_pattern_index.o:	mp_s_pattern_index.C
+	$(CCC) $(CCCFLAGS) -o mp_s_pattern_index.o -c mp_s_pattern_index.C
+
 mp_s_procid.o:	mp_s_procid.C
 	$(CCC) $(CCCFLAGS) -o mp_s_procid.o -c mp_s_procid.C
 
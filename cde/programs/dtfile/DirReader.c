@@ -0,0 +1,598 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/************************************<+>*************************************
+ ****************************************************************************
+ *
+ *   FILE:           DirReader.c
+ *
+ *   COMPONENT_NAME: Desktop File Manager (dtfile)
+ *
+ *   Description:    Transport of directory entries from a directory
+ *                   reader process to the main dtfile process, either
+ *                   through the pipe or through a shared memory arena.
+ *
+ *   FUNCTIONS: FileData2toFileData
+ *              FileRecordSize
+ *              FileRecordString
+ *              FileRecordToFileData
+ *              PipeReadFileData3
+ *              PutFileRecord
+ *              ReadArenaCreate
+ *              ReadArenaDestroy
+ *              ReadArenaGetSlot
+ *              ReadArenaReceive
+ *              ReadArenaSend
+ *              ReadDirectoryToArena
+ *              ReadDirectoryToPipe
+ *
+ ****************************************************************************
+ ************************************<+>*************************************/
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <semaphore.h>
+
+#include <Xm/Xm.h>
+
+#include "Encaps.h"
+#include "FileMgr.h"
+#include "Desktop.h"
+#include "Main.h"
+#include "DirReader.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define	NILL '\0'
+
+
+FileData *
+FileData2toFileData(
+	FileData2 *file_data2,
+	int *l)
+{
+   FileData *file_data;
+   int n;
+   char file_name_buf[MAXPATHLEN];
+   char action_name_buf[MAXPATHLEN];
+   char logical_type_buf[MAXPATHLEN];
+   char link_buf[MAXPATHLEN];
+   char final_link_buf[MAXPATHLEN];
+   char *textptr = file_data2->text;
+
+   file_data = (FileData *)XtCalloc(1,sizeof(FileData));
+
+   strncpy(file_name_buf, textptr, n = file_data2->file_name);
+   file_name_buf[n] = NILL;
+   textptr += n;
+
+   strncpy(action_name_buf, textptr, n = file_data2->action_name);
+   action_name_buf[n] = NILL;
+   textptr += n;
+
+   strncpy(logical_type_buf, textptr, n = file_data2->logical_type);
+   logical_type_buf[n] = NILL;
+   textptr += n;
+
+   strncpy(link_buf, textptr, n = file_data2->link);
+   link_buf[n] = NILL;
+   textptr += n;
+
+   strncpy(final_link_buf, textptr, n = file_data2->final_link);
+   final_link_buf[n] = NILL;
+   textptr += n;
+
+   file_data->next		= NULL;
+   file_data->file_name		= XtNewString(file_name_buf);
+   file_data->action_name	= file_data2->action_name
+				? XtNewString(action_name_buf)
+				: NULL;
+   file_data->physical_type	= file_data2->physical_type;
+   file_data->logical_type	= XtNewString(logical_type_buf);
+   file_data->errnum		= file_data2->errnum;
+   file_data->stat		= file_data2->stat;
+
+   file_data->link		= file_data2->link
+				? XtNewString(link_buf)
+				: NULL;
+
+   file_data->final_link	= file_data2->final_link
+				? XtNewString(final_link_buf)
+				: NULL;
+   file_data->is_subdir		= file_data2->is_subdir;
+   file_data->is_broken		= file_data2->is_broken;
+
+   *l = sizeof(*file_data2) - sizeof(file_data2->text)
+         + file_data2->file_name + file_data2->action_name
+         + file_data2->logical_type + file_data2->link
+         + file_data2->final_link;
+
+   *l = (*l + sizeof(char *) - 1) & ~(sizeof(char *) - 1);
+
+   /* return the file data */
+   return file_data;
+}
+
+
+/*--------------------------------------------------------------------
+ *  ReadArena...
+ *  FileRecord...
+ *      Shared memory transport for directory reads.  Instead of
+ *      pushing every entry through the pipe, the reader process
+ *      stores compact FileRecords in a shared arena and only tells
+ *      the main process which slot to pick up.  If the arena can't
+ *      be set up (e.g. no process-shared semaphores on this system),
+ *      directories are read through the pipe as before.
+ *------------------------------------------------------------------*/
+
+ReadArena *
+ReadArenaCreate(void)
+{
+   ReadArena *arena;
+
+   arena = (ReadArena *) mmap(NULL, sizeof(ReadArena),
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+   if (arena == (ReadArena *) MAP_FAILED)
+      return NULL;
+
+   if (sem_init(&arena->free_slots, 1, READ_ARENA_SLOTS) != 0)
+   {
+      munmap((void *) arena, sizeof(ReadArena));
+      return NULL;
+   }
+
+   arena->parent = getpid();
+   arena->next_slot = 0;
+   return arena;
+}
+
+
+void
+ReadArenaDestroy(
+        ReadArena *arena)
+{
+   if (arena == NULL)
+      return;
+
+   sem_destroy(&arena->free_slots);
+   munmap((void *) arena, sizeof(ReadArena));
+}
+
+
+/* reader process: wait until the next slot is free */
+static char *
+ReadArenaGetSlot(
+        ReadArena *arena)
+{
+   struct timespec timeout;
+
+   for (;;)
+   {
+      clock_gettime(CLOCK_REALTIME, &timeout);
+      timeout.tv_sec++;
+      if (sem_timedwait(&arena->free_slots, &timeout) == 0)
+         break;
+
+      /* give up if the main process went away */
+      if (errno != EINTR && getppid() != arena->parent)
+         return NULL;
+   }
+
+   return arena->data[arena->next_slot];
+}
+
+
+/* reader process: hand the slot just filled to the main process */
+static void
+ReadArenaSend(
+        int pipe_fd,
+        ReadArena *arena,
+        short count,
+        int length)
+{
+   char msg[2*sizeof(short) + 2*sizeof(int)];
+
+   *(short *)msg = PIPEMSG_FILEDATA4;
+   *(short *)(msg + sizeof(short)) = count;
+   *(int *)(msg + 2*sizeof(short)) = arena->next_slot;
+   *(int *)(msg + 2*sizeof(short) + sizeof(int)) = length;
+   write(pipe_fd, msg, sizeof(msg));
+
+   arena->next_slot = (arena->next_slot + 1) % READ_ARENA_SLOTS;
+}
+
+
+/* size of the FileRecord for a FileData2 */
+static int
+FileRecordSize(
+        FileData2 *file_data2)
+{
+   int len;
+
+   len = sizeof(FileRecord)
+         + file_data2->file_name + file_data2->action_name
+         + file_data2->logical_type + file_data2->link
+         + file_data2->final_link + 5;
+
+   return (len + sizeof(char *) - 1) & ~(sizeof(char *) - 1);
+}
+
+
+/* store a FileData2 as a FileRecord */
+static void
+PutFileRecord(
+        char *buf,
+        FileData2 *file_data2)
+{
+   FileRecord rec;
+   char *textptr = file_data2->text;
+   char *p = buf + sizeof(FileRecord);
+   int len[5];
+   int i;
+
+   rec.length = FileRecordSize(file_data2);
+   rec.errnum = file_data2->errnum;
+   rec.stat = file_data2->stat;
+   rec.file_name = len[0] = file_data2->file_name;
+   rec.action_name = len[1] = file_data2->action_name;
+   rec.logical_type = len[2] = file_data2->logical_type;
+   rec.link = len[3] = file_data2->link;
+   rec.final_link = len[4] = file_data2->final_link;
+   rec.physical_type = file_data2->physical_type;
+   rec.is_subdir = file_data2->is_subdir;
+   rec.is_broken = file_data2->is_broken;
+
+   /* the buffer may not be aligned for struct stat */
+   memcpy(buf, &rec, sizeof(FileRecord));
+
+   for (i = 0; i < 5; i++)
+   {
+      memcpy(p, textptr, len[i]);
+      p[len[i]] = NILL;
+      p += len[i] + 1;
+      textptr += len[i];
+   }
+}
+
+
+/* copy the next string out of a FileRecord */
+static char *
+FileRecordString(
+        char **p,
+        int len,
+        Boolean null_if_empty)
+{
+   char *str = NULL;
+
+   if (len > 0 || !null_if_empty)
+   {
+      str = XtMalloc(len + 1);
+      memcpy(str, *p, len + 1);
+   }
+   *p += len + 1;
+
+   return str;
+}
+
+
+/* create FileData from a FileRecord; see FileData2toFileData */
+static FileData *
+FileRecordToFileData(
+        char *buf,
+        int *l)
+{
+   FileRecord rec;
+   FileData *file_data;
+   char *p = buf + sizeof(FileRecord);
+
+   memcpy(&rec, buf, sizeof(FileRecord));
+
+   file_data = (FileData *)XtMalloc(sizeof(FileData));
+   file_data->next		= NULL;
+   file_data->file_name		= FileRecordString(&p, rec.file_name, False);
+   file_data->action_name	= FileRecordString(&p, rec.action_name, True);
+   file_data->physical_type	= rec.physical_type;
+   file_data->logical_type	= FileRecordString(&p, rec.logical_type, False);
+   file_data->errnum		= rec.errnum;
+   file_data->stat		= rec.stat;
+   file_data->link		= FileRecordString(&p, rec.link, True);
+   file_data->final_link	= FileRecordString(&p, rec.final_link, True);
+   file_data->is_subdir		= rec.is_subdir;
+   file_data->is_broken		= rec.is_broken;
+
+   *l = rec.length;
+   return file_data;
+}
+
+/*--------------------------------------------------------------------
+ *  PipeReadFileData3
+ *  ReadArenaReceive
+ *    Main process: pick up the entries announced by a PIPEMSG_FILEDATA3
+ *    or PIPEMSG_FILEDATA4 message (the message code has already been
+ *    read) and append them to the list at *nextp, which is left
+ *    pointing at the new end of the list.  Returns the entry count;
+ *    the 0x8000 bit is set if a status line update is due.
+ *------------------------------------------------------------------*/
+
+short
+PipeReadFileData3(
+        int fd,
+        FileData ***nextp)
+{
+   FileData *new_data;
+   short file_data_count;
+   int file_data_length;
+   int i, n;
+   char file_data_buffer[FILEDATABUF * sizeof(FileData2)];
+   char *file_data_buf_ptr;
+
+   PipeRead(fd, &file_data_count, sizeof(short));
+   PipeRead(fd, &file_data_length, sizeof(int));
+   PipeRead(fd, file_data_buffer, file_data_length);
+
+   file_data_buf_ptr = file_data_buffer;
+   for (i = 0; i < (file_data_count & 0x7fff); i++)
+   {
+     /* get next FileData out of buffer */
+     new_data = FileData2toFileData((FileData2 *)file_data_buf_ptr, &n);
+     file_data_buf_ptr += n;
+
+     /* append new_data to end of list */
+     **nextp = new_data;
+     *nextp = &new_data->next;
+   }
+
+   return file_data_count;
+}
+
+
+short
+ReadArenaReceive(
+        int fd,
+        ReadArena *arena,
+        FileData ***nextp)
+{
+   FileData *new_data;
+   short file_data_count;
+   int file_data_length;
+   int slot;
+   int i, n;
+   char *file_data_buf_ptr;
+
+   PipeRead(fd, &file_data_count, sizeof(short));
+   PipeRead(fd, &slot, sizeof(int));
+   PipeRead(fd, &file_data_length, sizeof(int));
+
+   /* pick up the records straight from the shared arena */
+   file_data_buf_ptr = arena->data[slot];
+   for (i = 0; i < (file_data_count & 0x7fff); i++)
+   {
+     new_data = FileRecordToFileData(file_data_buf_ptr, &n);
+     file_data_buf_ptr += n;
+
+     /* append new_data to end of list */
+     **nextp = new_data;
+     *nextp = &new_data->next;
+   }
+
+   /* let the reader process re-use the slot */
+   sem_post(&arena->free_slots);
+
+   return file_data_count;
+}
+
+
+/*--------------------------------------------------------------------
+ *  ReadDirectoryToPipe
+ *    Reader process: read all directory entries and send them to the
+ *    main process through the pipe.
+ *------------------------------------------------------------------*/
+
+int
+ReadDirectoryToPipe(
+        int pipe_fd,
+        DIR *dirp,
+        char *full_directory_name,
+        Boolean inDtDir,
+        Boolean IsToolBox)
+{
+   struct dirent * dp;
+   Boolean done;
+   Boolean update_due;
+   short file_data_count = 0;
+   char file_data_buffer[FILEDATABUF * sizeof(FileData2)];
+   char *file_data_buf_ptr = file_data_buffer;
+   struct timeval time1, time2;
+   long diff;
+
+	/*
+	 *	FILEDATA3 creates a buffer of static FileData2 structures,
+	 *	then sends FILEDATABUF worth of FileData2 structs to the parent.
+	 *	FILEDATABUF appears to work the best when set to 50.
+     *
+     *  We send data to the parent at least every half seconds, even if
+     *  less than FILEDATABUF worth of FileData2 structs have been read.
+     *  This is to ensure that the file count in the status line gets
+     *  updated every half seconds, even if the file system is slow.
+	 */
+
+   /* initialize pointer into file data buffer */
+#  define PIPEMSG_HDR_LEN (2*sizeof(short) + sizeof(int))
+   file_data_buf_ptr = file_data_buffer + PIPEMSG_HDR_LEN;
+
+   /* get current time */
+   gettimeofday(&time1, NULL);
+
+   done = False;
+   do
+   {
+     int len = 0;
+
+     if ((dp = readdir (dirp)) != NULL)
+     {
+       /* if Desktop skip */
+       if (inDtDir && (strcmp(dp->d_name, "Desktop") == 0))
+         continue;
+
+       /* get the info */
+       len = ReadFileData2((FileData2 *)file_data_buf_ptr,
+                           full_directory_name, dp->d_name,IsToolBox);
+       file_data_buf_ptr += len;
+       file_data_count++;
+     }
+     else
+       done = True;
+
+     /* check if 0.4 seconds have passed since the last status line update */
+     gettimeofday(&time2, NULL);
+     diff = 1024*(time2.tv_sec - time1.tv_sec);
+     diff += time2.tv_usec/1024;
+     diff -= time1.tv_usec/1024;
+     update_due = (diff >= 400);
+
+     /* check if we need to send the buffered data now */
+     if (file_data_count == FILEDATABUF ||
+         file_data_count > 0 && (done || update_due))
+     {
+       if (update_due)
+         file_data_count |= 0x8000;
+       len = file_data_buf_ptr - (file_data_buffer + PIPEMSG_HDR_LEN);
+
+       /* now send the file data through the pipe */
+       *(short *)file_data_buffer = PIPEMSG_FILEDATA3;
+       *(short *)(file_data_buffer + sizeof(short)) = file_data_count;
+       *(int *)(file_data_buffer + 2*sizeof(short)) = len;
+       write(pipe_fd, file_data_buffer,
+             file_data_buf_ptr - file_data_buffer);
+
+       /* reset pointer to file data buffer, file count and time stamp */
+       file_data_buf_ptr = file_data_buffer + PIPEMSG_HDR_LEN;
+       file_data_count = 0;
+       if (update_due)
+         time1 = time2;
+     }
+   } while (!done);
+
+   return 0;
+}
+
+
+/*--------------------------------------------------------------------
+ *  ReadDirectoryToArena
+ *    Reader process: read all directory entries and pass them to the
+ *    main process through the shared arena.  As with the pipe,
+ *    data is handed over at least every 0.4 seconds, so that the file
+ *    count in the status line keeps moving on slow file systems.
+ *    Returns -1 if the main process went away.
+ *------------------------------------------------------------------*/
+
+int
+ReadDirectoryToArena(
+        int pipe_fd,
+        ReadArena *arena,
+        DIR *dirp,
+        char *full_directory_name,
+        Boolean inDtDir,
+        Boolean IsToolBox)
+{
+   FileData2 file_data2;
+   struct dirent * dp;
+   struct timeval time1, time2;
+   Boolean done;
+   Boolean update_due;
+   short count = 0;
+   int length = 0;
+   int len;
+   long diff;
+   char *slot;
+
+   if ((slot = ReadArenaGetSlot(arena)) == NULL)
+     return -1;
+
+   /* get current time */
+   gettimeofday(&time1, NULL);
+
+   done = False;
+   do
+   {
+     if ((dp = readdir (dirp)) != NULL)
+     {
+       /* if Desktop skip */
+       if (inDtDir && (strcmp(dp->d_name, "Desktop") == 0))
+         continue;
+
+       /* get the info */
+       ReadFileData2(&file_data2, full_directory_name, dp->d_name, IsToolBox);
+       len = FileRecordSize(&file_data2);
+
+       /* if the slot is full, hand it over and wait for the next one */
+       if (length + len > READ_ARENA_SLOT_SIZE)
+       {
+         ReadArenaSend(pipe_fd, arena, count, length);
+         if ((slot = ReadArenaGetSlot(arena)) == NULL)
+           return -1;
+         count = 0;
+         length = 0;
+       }
+
+       PutFileRecord(slot + length, &file_data2);
+       length += len;
+       count++;
+     }
+     else
+       done = True;
+
+     /* check if 0.4 seconds have passed since the last status line update */
+     gettimeofday(&time2, NULL);
+     diff = 1024*(time2.tv_sec - time1.tv_sec);
+     diff += time2.tv_usec/1024;
+     diff -= time1.tv_usec/1024;
+     update_due = (diff >= 400);
+
+     if (count > 0 && (done || update_due))
+     {
+       if (update_due)
+       {
+         count |= 0x8000;
+         time1 = time2;
+       }
+       ReadArenaSend(pipe_fd, arena, count, length);
+       count = 0;
+       length = 0;
+       if (!done && (slot = ReadArenaGetSlot(arena)) == NULL)
+         return -1;
+     }
+   } while (!done);
+
+   return 0;
+}
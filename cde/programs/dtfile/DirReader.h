@@ -0,0 +1,134 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/************************************<+>*************************************
+ ****************************************************************************
+ *
+ *   FILE:           DirReader.h
+ *
+ *   COMPONENT_NAME: Desktop File Manager (dtfile)
+ *
+ *   Description:    Transport of directory entries from a directory
+ *                   reader process to the main dtfile process.
+ *
+ ****************************************************************************
+ ************************************<+>*************************************/
+
+#ifndef _DirReader_h
+#define _DirReader_h
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <semaphore.h>
+
+#include <Xm/Xm.h>
+
+#include "FileMgr.h"
+
+/* kinds of messages sent through the pipe */
+#define PIPEMSG_ERROR               1
+#define PIPEMSG_FILEDATA            2
+#define PIPEMSG_DONE                3
+#define PIPEMSG_PATH_LOGICAL_TYPES  4
+#define PIPEMSG_POSITION_INFO       5
+#define PIPEMSG_FILEDATA2           6
+#define PIPEMSG_FILEDATA3           7
+#define PIPEMSG_DESKTOP_REMOVED     8
+#define PIPEMSG_DESKTOP_CHANGED     9
+#define PIPEMSG_FILEDATA4          10
+
+/* shared memory used to pass directory entries from a reader process */
+#define READ_ARENA_SLOTS      4
+#define READ_ARENA_SLOT_SIZE  (64 * 1024)
+
+#ifndef	FILEDATABUF
+#define	FILEDATABUF 50
+#endif /* FILEDATABUF */
+
+/*
+ * Shared memory arena for directory reads (see ReadDirectoryToArena).
+ * The reader process fills the slots round robin with FileRecords and
+ * sends only a short PIPEMSG_FILEDATA4 header through the pipe; the
+ * main process posts free_slots when it is done with a slot.
+ */
+typedef struct
+{
+   sem_t free_slots;
+   pid_t parent;
+   int   next_slot;
+   char  data[READ_ARENA_SLOTS][READ_ARENA_SLOT_SIZE];
+} ReadArena;
+
+/* compact directory entry record, followed by the NUL-terminated
+   file name, action name, logical type, link and final link */
+typedef struct
+{
+   int            length;         /* total length of the record */
+   int            errnum;
+   struct stat    stat;
+   unsigned short file_name;      /* string lengths */
+   unsigned short action_name;
+   unsigned short logical_type;
+   unsigned short link;
+   unsigned short final_link;
+   unsigned char  physical_type;
+   Boolean        is_subdir;
+   Boolean        is_broken;
+} FileRecord;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* main process */
+extern ReadArena * ReadArenaCreate(void) ;
+extern void ReadArenaDestroy(
+                        ReadArena *arena) ;
+extern short PipeReadFileData3(
+                        int fd,
+                        FileData ***nextp) ;
+extern short ReadArenaReceive(
+                        int fd,
+                        ReadArena *arena,
+                        FileData ***nextp) ;
+
+/* reader process */
+extern int ReadDirectoryToPipe(
+                        int pipe_fd,
+                        DIR *dirp,
+                        char *full_directory_name,
+                        Boolean inDtDir,
+                        Boolean IsToolBox) ;
+extern int ReadDirectoryToArena(
+                        int pipe_fd,
+                        ReadArena *arena,
+                        DIR *dirp,
+                        char *full_directory_name,
+                        Boolean inDtDir,
+                        Boolean IsToolBox) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DirReader_h */
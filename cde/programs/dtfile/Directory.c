@@ -30,17 +30,29 @@
  *
  *   Description:    Directory processing functions used by the File Browser.
  *
- *   FUNCTIONS: CheckDesktop
+ *   FUNCTIONS: AddDirectoryToSet
+ *              CheckDesktop
  *              CheckDesktopPipeCallback
  *              CheckDesktopProcess
  *              CheckListCmp
+ *              DirectoryAddView
  *              DirectoryBeginModify
  *              DirectoryBusy
  *              DirectoryEndModify
  *              DirectoryFileModified
  *              DirectoryGone
+ *              DirectoryHashAdd
+ *              DirectoryHashKey
+ *              DirectoryHashRemove
+ *              DirectoryHashResize
  *              DirectoryModifyTime
- *              FileData2toFileData
+ *              DirWatchAdd
+ *              DirWatchCallback
+ *              DirWatchFlush
+ *              DirWatchIsRemote
+ *              DirWatchQueue
+ *              DirWatchRemove
+ *              FileNameHash
  *              FileWindowMapUnmap
  *              FindDirectory
  *              FreeDirectory
@@ -61,10 +73,13 @@
  *              ReadFileData
  *              ReadFileData2
  *              ReaddirPipeCallback
+ *              RemoveDirectoryFromSet
  *              RereadDirectory
  *              ScheduleActivity
  *              ScheduleDirectoryActivity
+ *              SetActivity
  *              SetDirectoryPositionInfo
+ *              SetTTPathName
  *              SkipRefresh
  *              SomeWindowMapped
  *              StickyProcIdle
@@ -105,6 +120,13 @@
 #include <string.h>
 #include <assert.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#define DIR_WATCH
+#endif
+
 #include <Xm/Xm.h>
 
 #include <Dt/Connect.h>
@@ -121,6 +143,7 @@
 #include "SharedMsgs.h"
 #include "SharedProcs.h"
 #include "Prefs.h"
+#include "DirReader.h"
 
 extern Boolean removingTrash;
 
@@ -138,21 +161,6 @@ extern Boolean removingTrash;
 /* prefix for the name of the position info file */
 #define POSITION_FILE_PREFIX  ".!dt"
 
-/* kinds of messages sent through the pipe */
-#define PIPEMSG_ERROR               1
-#define PIPEMSG_FILEDATA            2
-#define PIPEMSG_DONE                3
-#define PIPEMSG_PATH_LOGICAL_TYPES  4
-#define PIPEMSG_POSITION_INFO       5
-#define PIPEMSG_FILEDATA2           6
-#define PIPEMSG_FILEDATA3           7
-#define PIPEMSG_DESKTOP_REMOVED     8
-#define PIPEMSG_DESKTOP_CHANGED     9
-
-#ifndef	FILEDATABUF
-#define	FILEDATABUF 50
-#endif /* FILEDATABUF */
-
 #define	NILL '\0'
 
 /*
@@ -179,7 +187,11 @@ typedef struct
    Boolean       mapped;
 } DirectoryView;
 
-typedef struct
+/* directory_hash tables */
+#define DIR_HASH_NAME     0     /* keyed on host and directory name */
+#define DIR_HASH_TT_PATH  1     /* keyed on ToolTalk resolved path name */
+
+typedef struct _Directory
 {
    char           * host_name;
    char           * directory_name;
@@ -207,6 +219,14 @@ typedef struct
    char          ** modified_list;
    int              numOfViews;
    DirectoryView  * directoryView;
+   int              watch_wd;       /* inotify watch, 0 if polled */
+   Boolean          watch_pending;  /* change events not yet scheduled */
+   Boolean          watch_missed;   /* changes seen while not viewed */
+   int              view_alloc;     /* allocated size of directoryView */
+   int              set_index;      /* position in directory_set */
+   int              active_index;   /* position in active_set */
+   Boolean          removed;        /* no longer in directory_set */
+   struct _Directory *hash_next[2]; /* directory_hash chains */
 } Directory;
 
 
@@ -227,12 +247,20 @@ typedef struct
    pid_t child;
    StickyProcDesc *sticky_proc;
    ActivityStatus activity;
+   ReadArena *arena;
 } PipeCallbackData;
 
 
 /* background procedure */
 typedef int (*DirBackgroundProc)(int, Directory *, ActivityStatus);
 
+/* name lookup table for FileData lists (see FileDataIndexInit) */
+typedef struct
+{
+   unsigned int   mask;
+   FileData   *** slots;
+} FileDataIndex;
+
 extern void _DtFlushIconFileCache(String path);
 
 
@@ -286,6 +314,21 @@ static void CheckDesktopPipeCallback(
 			int *fd,
 			XtInputId *id);
 static void SelectDesktopFile(FileMgrData *fmd);
+static void FreeDirectory(
+			Directory *directory);
+#ifdef DIR_WATCH
+static void DirWatchAdd(
+			Directory *directory);
+static void DirWatchRemove(
+			Directory *directory);
+static void DirWatchCallback(
+			XtPointer client_data,
+			int *fd,
+			XtInputId *id);
+static void DirWatchFlush(
+			XtPointer client_data,
+			XtIntervalId *id);
+#endif
 
 
 
@@ -296,12 +339,18 @@ static void SelectDesktopFile(FileMgrData *fmd);
 int maxDirectoryProcesses = 10;
 int maxRereadProcesses = 5;
 int maxRereadProcsPerTick = 1;
+Boolean watchDirectories = True;
 
 XtIntervalId checkBrokenLinkTimerId = None;
 
 static Directory ** directory_set = NULL;
 static int          directory_count = 0;
 static int          directory_set_size = 0;
+static Directory ** directory_hash[2] = { NULL, NULL };
+static unsigned int directory_hash_mask = 0;
+static Directory ** active_set = NULL;
+static int          active_count = 0;
+static int          active_set_size = 0;
 static char       * positionFileName = NULL;
 static XtAppContext app_context = None;
 static int          tickTime = 0;
@@ -309,6 +358,10 @@ static int          ticksBetweenLinkChecks = 0;
 static Boolean      timer_suspended = False;
 static int          tick_count = 0;
 static int          lastLinkCheckTick = 0;
+#ifdef DIR_WATCH
+static int          watch_fd = -1;
+static XtIntervalId watch_timer_id = None;
+#endif
 static Directory  dummy_dir_struct =
 {
   "dummy_host",
@@ -319,6 +372,7 @@ static Directory  dummy_dir_struct =
   activity_idle
 };
 static Directory *dummy_directory = &dummy_dir_struct;
+static ReadArena  *read_arena = NULL;  /* in a reader process only */
 
 static struct
 {
@@ -400,6 +454,23 @@ InitializeDirectoryRead(
    if (tickTime != 0)
       XtAppAddTimeOut (app_context, tickTime * 1000, TimerEvent, NULL);
 
+#ifdef DIR_WATCH
+   /*
+    * Watch local directories for changes instead of polling them.
+    * Only done if automatic rereads are enabled at all.
+    */
+   if (rereadTime != 0 && watchDirectories && watch_fd < 0)
+   {
+      watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (watch_fd >= 0)
+         XtAppAddInput(app_context, watch_fd, (XtPointer)XtInputReadMask,
+                       DirWatchCallback, NULL);
+      else
+         DPRINTF(("InitializeDirectoryRead: inotify_init1 failed: %s\n",
+                  strerror(errno)));
+   }
+#endif
+
    /* start timer to check for broken desktop objects */
    if( desktop_data->numIconsUsed > 0
        && checkBrokenLink != 0
@@ -423,6 +494,227 @@ InitializeDirectoryRead(
  *
  *==================================================================*/
 
+/*--------------------------------------------------------------------
+ *  FileNameHash
+ *    FNV-1a hash of a file or directory name.
+ *------------------------------------------------------------------*/
+
+static unsigned int
+FileNameHash(
+        char *name)
+{
+   unsigned int h = 2166136261u;
+
+   while (*name)
+   {
+      h ^= (unsigned char) *name++;
+      h *= 16777619u;
+   }
+   return h;
+}
+
+
+/*--------------------------------------------------------------------
+ *  DirectoryHash...
+ *    Hash tables used by FindDirectory to look up cached directories.
+ *    The DIR_HASH_NAME table is keyed on host and directory name, the
+ *    DIR_HASH_TT_PATH table on the ToolTalk resolved path name (which
+ *    is only known after the directory has been read).  Both tables
+ *    have the same size, which is doubled whenever there are more
+ *    directories in the set than buckets.
+ *------------------------------------------------------------------*/
+
+static unsigned int
+DirectoryHashKey(
+        Directory *directory,
+        int table)
+{
+   if (table == DIR_HASH_NAME)
+      return FileNameHash(directory->host_name) * 31 +
+             FileNameHash(directory->directory_name);
+   else
+      return FileNameHash(directory->tt_path_name);
+}
+
+static void
+DirectoryHashAdd(
+        Directory *directory,
+        int table)
+{
+   Directory **dpp;
+
+   directory->hash_next[table] = NULL;
+   if (table == DIR_HASH_TT_PATH && directory->tt_path_name == NULL)
+      return;
+
+   /* append, so that FindDirectory sees entries in the order added */
+   dpp = &directory_hash[table][DirectoryHashKey(directory, table) &
+                                directory_hash_mask];
+   while (*dpp != NULL)
+      dpp = &(*dpp)->hash_next[table];
+   *dpp = directory;
+}
+
+static void
+DirectoryHashRemove(
+        Directory *directory,
+        int table)
+{
+   Directory **dpp;
+
+   if (table == DIR_HASH_TT_PATH && directory->tt_path_name == NULL)
+      return;
+
+   dpp = &directory_hash[table][DirectoryHashKey(directory, table) &
+                                directory_hash_mask];
+   while (*dpp != NULL && *dpp != directory)
+      dpp = &(*dpp)->hash_next[table];
+   if (*dpp != NULL)
+      *dpp = directory->hash_next[table];
+   directory->hash_next[table] = NULL;
+}
+
+static void
+DirectoryHashResize(
+        unsigned int size)
+{
+   int i, t;
+
+   for (t = DIR_HASH_NAME; t <= DIR_HASH_TT_PATH; t++)
+   {
+      XtFree((char *) directory_hash[t]);
+      directory_hash[t] = (Directory **) XtCalloc(size, sizeof(Directory *));
+   }
+   directory_hash_mask = size - 1;
+
+   for (i = 0; i < directory_count; i++)
+   {
+      DirectoryHashAdd(directory_set[i], DIR_HASH_NAME);
+      DirectoryHashAdd(directory_set[i], DIR_HASH_TT_PATH);
+   }
+}
+
+
+/*--------------------------------------------------------------------
+ *  AddDirectoryToSet
+ *    Add a new directory entry to the directory cache.
+ *------------------------------------------------------------------*/
+
+static void
+AddDirectoryToSet(
+        Directory *directory)
+{
+   /*  Expand the directory set array, if necessary.  */
+   if (directory_count == directory_set_size)
+   {
+      directory_set_size += 10;
+      directory_set = (Directory **) XtRealloc((char *)directory_set,
+                                 sizeof(Directory **) * directory_set_size);
+   }
+
+   directory->set_index = directory_count;
+   directory->removed = False;
+   directory_set[directory_count++] = directory;
+
+   if (directory_count > directory_hash_mask + 1)
+      DirectoryHashResize(directory_hash[DIR_HASH_NAME] == NULL?
+                          16: 2 * (directory_hash_mask + 1));
+   else
+   {
+      DirectoryHashAdd(directory, DIR_HASH_NAME);
+      DirectoryHashAdd(directory, DIR_HASH_TT_PATH);
+   }
+}
+
+
+/*--------------------------------------------------------------------
+ *  RemoveDirectoryFromSet
+ *    Remove a directory entry from the directory cache.  The last
+ *    entry of the set takes its place, so the order of directory_set
+ *    is not preserved.
+ *    If a background activity is still running for the directory, the
+ *    entry is only marked as removed; it is freed by DirectoryGone
+ *    when the background process reports back.
+ *------------------------------------------------------------------*/
+
+static void
+RemoveDirectoryFromSet(
+        Directory *directory)
+{
+   int i = directory->set_index;
+
+   DirectoryHashRemove(directory, DIR_HASH_NAME);
+   DirectoryHashRemove(directory, DIR_HASH_TT_PATH);
+
+   directory_count--;
+   directory_set[i] = directory_set[directory_count];
+   directory_set[i]->set_index = i;
+   directory->removed = True;
+
+   if (directory->activity == activity_idle)
+      FreeDirectory(directory);
+}
+
+
+/*--------------------------------------------------------------------
+ *  SetTTPathName
+ *    Set the ToolTalk resolved path name of a directory.
+ *------------------------------------------------------------------*/
+
+static void
+SetTTPathName(
+        Directory *directory,
+        char *tt_path_name)
+{
+   if (!directory->removed)
+      DirectoryHashRemove(directory, DIR_HASH_TT_PATH);
+
+   XtFree(directory->tt_path_name);
+   directory->tt_path_name = tt_path_name;
+
+   if (!directory->removed)
+      DirectoryHashAdd(directory, DIR_HASH_TT_PATH);
+}
+
+
+/*--------------------------------------------------------------------
+ *  SetActivity
+ *    Set the current background activity of a directory and keep
+ *    track of the directories that have a background activity running
+ *    (active_set), so that the scheduler doesn't have to look at every
+ *    cached directory.
+ *------------------------------------------------------------------*/
+
+static void
+SetActivity(
+        Directory *directory,
+        ActivityStatus activity)
+{
+   int i;
+
+   if (directory->activity == activity_idle && activity != activity_idle)
+   {
+      if (active_count == active_set_size)
+      {
+         active_set_size += 10;
+         active_set = (Directory **) XtRealloc((char *)active_set,
+                                    sizeof(Directory *) * active_set_size);
+      }
+      directory->active_index = active_count;
+      active_set[active_count++] = directory;
+   }
+   else if (directory->activity != activity_idle && activity == activity_idle)
+   {
+      i = directory->active_index;
+      active_count--;
+      active_set[i] = active_set[active_count];
+      active_set[i]->active_index = i;
+   }
+
+   directory->activity = activity;
+}
+
+
 /*--------------------------------------------------------------------
  *  FindDirectory
  *    Given a host & directory name, find the directory in our cache.
@@ -433,7 +725,11 @@ FindDirectory(
         char *host_name,
         char *directory_name)
 {
-   int i;
+   Directory *directory;
+   unsigned int h;
+
+   if (directory_count == 0)
+      return NULL;
 
    /* See if the directory is in the directory set.  First, compare    */
    /* the names from the directory entries ONLY.  There will be one    */
@@ -449,22 +745,27 @@ FindDirectory(
    /* directory set whose tt_path_name matches our name, this MAY NOT  */
    /* be the directory where the activity originated.  The user should */
    /* only notice in the case where automatic refresh is turned off.   */
-   for (i = 0; i < directory_count; i++)
+   h = FileNameHash(host_name) * 31 + FileNameHash(directory_name);
+   for (directory = directory_hash[DIR_HASH_NAME][h & directory_hash_mask];
+        directory != NULL;
+        directory = directory->hash_next[DIR_HASH_NAME])
    {
-      if (strcmp (host_name, directory_set[i]->host_name) == 0 &&
-          strcmp (directory_name, directory_set[i]->directory_name) == 0)
+      if (strcmp (host_name, directory->host_name) == 0 &&
+          strcmp (directory_name, directory->directory_name) == 0)
       {
-         return directory_set[i];
+         return directory;
       }
    }
 
-   for (i = 0; i < directory_count; i++)
+   if (strcmp (host_name, home_host_name) == 0)
    {
-      if (directory_set[i]->tt_path_name != NULL &&
-          strcmp (host_name, home_host_name) == 0 &&
-          strcmp (directory_name, directory_set[i]->tt_path_name) == 0)
+      h = FileNameHash(directory_name);
+      for (directory = directory_hash[DIR_HASH_TT_PATH][h & directory_hash_mask];
+           directory != NULL;
+           directory = directory->hash_next[DIR_HASH_TT_PATH])
       {
-         return directory_set[i];
+         if (strcmp (directory_name, directory->tt_path_name) == 0)
+            return directory;
       }
    }
 
@@ -476,19 +777,56 @@ FindDirectory(
 /*--------------------------------------------------------------------
  *  DirectoryGone
  *    Check if a directory has been removed from the cache.
+ *    Called when a background process reports back; if the directory
+ *    has been removed in the meantime, the entry is freed now.
  *------------------------------------------------------------------*/
 
 static Boolean
 DirectoryGone(
         Directory *directory)
+{
+   if (!directory->removed)
+      return False;
+
+   SetActivity(directory, activity_idle);
+   FreeDirectory(directory);
+   return True;
+}
+
+
+/*--------------------------------------------------------------------
+ *  DirectoryAddView
+ *    Add a view to the view list of a directory, if not already there.
+ *------------------------------------------------------------------*/
+
+static void
+DirectoryAddView(
+        Directory *directory,
+        FileMgrData *file_mgr_data)
 {
    int i;
 
-   for (i = 0; i < directory_count; i++)
-      if (directory_set[i] == directory)
-         return False;
+   /* Look for the view in the view list */
+   for (i = 0; i < directory->numOfViews; i++)
+      if (directory->directoryView[i].file_mgr_data == file_mgr_data)
+         break;
 
-   return True;
+   /* If view not found, add to the view list */
+   if (i == directory->numOfViews)
+   {
+      if (directory->numOfViews == directory->view_alloc)
+      {
+         directory->view_alloc = directory->view_alloc? 2*directory->view_alloc: 2;
+         directory->directoryView = (DirectoryView *)
+                           XtRealloc ((char *) directory->directoryView,
+                                      sizeof(DirectoryView) * directory->view_alloc);
+      }
+      directory->numOfViews++;
+      directory->directoryView[i].file_mgr_data = file_mgr_data;
+   }
+
+   /* set mapped flag for the view */
+   directory->directoryView[i].mapped = file_mgr_data->mapped;
 }
 
 
@@ -544,6 +882,10 @@ FreeDirectory(
    if( directory == NULL )
      return;
 
+#ifdef DIR_WATCH
+   DirWatchRemove(directory);
+#endif
+
    XtFree (directory->host_name);
    directory->host_name = NULL;
 
@@ -615,6 +957,88 @@ SomeWindowMapped(void)
 }
 
 
+/*--------------------------------------------------------------------
+ *  FileDataIndex...
+ *    Hash table that maps file names to slots in an array of FileData
+ *    pointers.  Used to match the entries of an old and a new file list
+ *    without comparing every old entry against every new one.
+ *    A slot that the caller has set to NULL never matches; since file
+ *    names are unique within a directory, this can be used to mark
+ *    entries that have already been dealt with.
+ *------------------------------------------------------------------*/
+
+static FileData **
+FileDataListToArray(
+        FileData *file_data,
+        int *count)
+{
+   FileData **array;
+   FileData *fp;
+   int n;
+
+   for (n = 0, fp = file_data; fp; fp = fp->next)
+      n++;
+
+   array = (FileData **) XtMalloc((n + 1) * sizeof(FileData *));
+   for (n = 0, fp = file_data; fp; fp = fp->next)
+      array[n++] = fp;
+   array[n] = NULL;
+
+   *count = n;
+   return array;
+}
+
+static void
+FileDataIndexInit(
+        FileDataIndex *index,
+        FileData **array,
+        int count)
+{
+   unsigned int h;
+   int size;
+   int i;
+
+   for (size = 16; size < 2*count; size <<= 1)
+      ;
+   index->mask = size - 1;
+   index->slots = (FileData ***) XtCalloc(size, sizeof(FileData **));
+
+   for (i = 0; i < count; i++)
+   {
+      h = FileNameHash(array[i]->file_name) & index->mask;
+      while (index->slots[h] != NULL)
+         h = (h + 1) & index->mask;
+      index->slots[h] = &array[i];
+   }
+}
+
+static FileData **
+FileDataIndexLookup(
+        FileDataIndex *index,
+        char *file_name)
+{
+   FileData **slot;
+   unsigned int h;
+
+   h = FileNameHash(file_name) & index->mask;
+   while ((slot = index->slots[h]) != NULL)
+   {
+      if (*slot != NULL && strcmp((*slot)->file_name, file_name) == 0)
+         return slot;
+      h = (h + 1) & index->mask;
+   }
+   return NULL;
+}
+
+static void
+FileDataIndexFree(
+        FileDataIndex *index)
+{
+   XtFree((char *) index->slots);
+   index->slots = NULL;
+}
+
+
 /*====================================================================
  *
  * Routines for reading a directory
@@ -674,73 +1098,6 @@ PipeReadFileData(
    return file_data;
 }
 
-FileData *
-FileData2toFileData(
-	FileData2 *file_data2,
-	int *l)
-{
-   FileData *file_data;
-   int n;
-   char file_name_buf[MAXPATHLEN];
-   char action_name_buf[MAXPATHLEN];
-   char logical_type_buf[MAXPATHLEN];
-   char link_buf[MAXPATHLEN];
-   char final_link_buf[MAXPATHLEN];
-   char *textptr = file_data2->text;
-
-   file_data = (FileData *)XtCalloc(1,sizeof(FileData));
-
-   strncpy(file_name_buf, textptr, n = file_data2->file_name);
-   file_name_buf[n] = NILL;
-   textptr += n;
-
-   strncpy(action_name_buf, textptr, n = file_data2->action_name);
-   action_name_buf[n] = NILL;
-   textptr += n;
-
-   strncpy(logical_type_buf, textptr, n = file_data2->logical_type);
-   logical_type_buf[n] = NILL;
-   textptr += n;
-
-   strncpy(link_buf, textptr, n = file_data2->link);
-   link_buf[n] = NILL;
-   textptr += n;
-
-   strncpy(final_link_buf, textptr, n = file_data2->final_link);
-   final_link_buf[n] = NILL;
-   textptr += n;
-
-   file_data->next		= NULL;
-   file_data->file_name		= XtNewString(file_name_buf);
-   file_data->action_name	= file_data2->action_name
-				? XtNewString(action_name_buf)
-				: NULL;
-   file_data->physical_type	= file_data2->physical_type;
-   file_data->logical_type	= XtNewString(logical_type_buf);
-   file_data->errnum		= file_data2->errnum;
-   file_data->stat		= file_data2->stat;
-
-   file_data->link		= file_data2->link
-				? XtNewString(link_buf)
-				: NULL;
-
-   file_data->final_link	= file_data2->final_link
-				? XtNewString(final_link_buf)
-				: NULL;
-   file_data->is_subdir		= file_data2->is_subdir;
-   file_data->is_broken		= file_data2->is_broken;
-
-   *l = sizeof(*file_data2) - sizeof(file_data2->text)
-         + file_data2->file_name + file_data2->action_name
-         + file_data2->logical_type + file_data2->link
-         + file_data2->final_link;
-
-   *l = (*l + sizeof(char *) - 1) & ~(sizeof(char *) - 1);
-
-   /* return the file data */
-   return file_data;
-}
-
 /* write PositionInfo to the pipe */
 void
 PipeWritePositionInfo(
@@ -766,6 +1123,7 @@ PipeReadPositionInfo(
    PipeRead(fd, &position_info->stacking_order, sizeof(int));
 }
 
+
 /*--------------------------------------------------------------------
  *  ReadFileData
  *    Given a path name, return FileData for a file.
@@ -1349,13 +1707,8 @@ ReadDirectoryProcess(
    char *full_directory_name;
    char *tt_path;
    DIR *dirp;
-   struct dirent * dp;
    Boolean inDtDir;
-   FileData *file_data;
-   FileData2 file_data2;
-   Boolean done;
-   Boolean update_due;
-   short file_data_count = 0;
+   Boolean IsToolBox;
    int i;
    char * ptr;
    char * namePtr;
@@ -1365,11 +1718,6 @@ ReadDirectoryProcess(
    int x, y, stacking_order;
    short pipe_msg;
    int rc;
-   char file_data_buffer[FILEDATABUF * sizeof(FileData2)];
-   char *file_data_buf_ptr = file_data_buffer;
-   char *file_data_count_ptr;
-   struct timeval time1, time2;
-   long diff;
    char *ptrOrig;
 
    DPRINTF(("ReadDirectoryProcess(%d, \"%s\", \"%s\")\n",
@@ -1540,78 +1888,24 @@ ReadDirectoryProcess(
    gettimeofday(&update_time_s, NULL);
 #endif
 
-	/*
-	 *	FILEDATA3 creates a buffer of static FileData2 structures,
-	 *	then sends FILEDATABUF worth of FileData2 structs to the parent.
-	 *	FILEDATABUF appears to work the best when set to 50.
-     *
-     *  We send data to the parent at least every half seconds, even if
-     *  less than FILEDATABUF worth of FileData2 structs have been read.
-     *  This is to ensure that the file count in the status line gets
-     *  updated every half seconds, even if the file system is slow.
-	 */
-
-   /* initialize pointer into file data buffer */
-#  define PIPEMSG_HDR_LEN (2*sizeof(short) + sizeof(int))
-   file_data_buf_ptr = file_data_buffer + PIPEMSG_HDR_LEN;
-
-   /* get current time */
-   gettimeofday(&time1, NULL);
+   if(directory->numOfViews > 0 && directory->directoryView->file_mgr_data)
+     IsToolBox = directory->directoryView->file_mgr_data->toolbox;
+   else
+     IsToolBox = False;
 
-   done = False;
-   do
+   if (read_arena != NULL)
+      rc = ReadDirectoryToArena(pipe_fd, read_arena, dirp,
+                                full_directory_name, inDtDir, IsToolBox);
+   else
+      rc = ReadDirectoryToPipe(pipe_fd, dirp,
+                               full_directory_name, inDtDir, IsToolBox);
+   if (rc != 0)
    {
-     int len = 0;
-
-     if ((dp = readdir (dirp)) != NULL)
-     {
-       Boolean IsToolBox;
-       /* if Desktop skip */
-       if (inDtDir && (strcmp(dp->d_name, "Desktop") == 0))
-         continue;
-
-       /* get the info */
-       if(directory->directoryView && directory->directoryView->file_mgr_data)
-	 IsToolBox = directory->directoryView->file_mgr_data->toolbox;
-       else
-	 IsToolBox = False;
-       len = ReadFileData2((FileData2 *)file_data_buf_ptr,
-                           full_directory_name, dp->d_name,IsToolBox);
-       file_data_buf_ptr += len;
-       file_data_count++;
-     }
-     else
-       done = True;
-
-     /* check if 0.4 seconds have passed since the last status line update */
-     gettimeofday(&time2, NULL);
-     diff = 1024*(time2.tv_sec - time1.tv_sec);
-     diff += time2.tv_usec/1024;
-     diff -= time1.tv_usec/1024;
-     update_due = (diff >= 400);
-
-     /* check if we need to send the buffered data now */
-     if (file_data_count == FILEDATABUF ||
-         file_data_count > 0 && (done || update_due))
-     {
-       if (update_due)
-         file_data_count |= 0x8000;
-       len = file_data_buf_ptr - (file_data_buffer + PIPEMSG_HDR_LEN);
-
-       /* now send the file data through the pipe */
-       *(short *)file_data_buffer = PIPEMSG_FILEDATA3;
-       *(short *)(file_data_buffer + sizeof(short)) = file_data_count;
-       *(int *)(file_data_buffer + 2*sizeof(short)) = len;
-       write(pipe_fd, file_data_buffer,
-             file_data_buf_ptr - file_data_buffer);
-
-       /* reset pointer to file data buffer, file count and time stamp */
-       file_data_buf_ptr = file_data_buffer + PIPEMSG_HDR_LEN;
-       file_data_count = 0;
-       if (update_due)
-         time1 = time2;
-     }
-   } while (!done);
+      /* the main process went away */
+      closedir(dirp);
+      XtFree(full_directory_name);
+      return 1;
+   }
 
 #ifdef DT_PERFORMANCE
    gettimeofday(&update_time_f, NULL);
@@ -1697,10 +1991,93 @@ ReadDirectoryProcess(
 }
 
 
+/*--------------------------------------------------------------------
+ *  LinkChanged
+ *    Check if a symbolic link is no longer a link or if it changed
+ *    its kind (valid, recursive or broken) since it was last typed.
+ *
+ *    Note: it is important that we determine the kind of link in
+ *    exactly the same way that ReadFileData2 does it; otherwise we
+ *    would keep on re-reading the link (see TimerEventProcess).
+ *------------------------------------------------------------------*/
+
+static Boolean
+LinkChanged(
+        char *full_name,
+        FileData *file_data)
+{
+   struct stat stat_buf;
+   int prev_link_kind;
+   int cur_link_kind;
+
+   /* Check if the file is still a symbolic link */
+   if (lstat(full_name, &stat_buf) != 0 ||
+       (stat_buf.st_mode & S_IFMT) != S_IFLNK)
+      return True;
+
+   /* Check what kind of link this was the last time we looked:
+    * a normal link (1), a recursive link (2), or an otherwise
+    * broken link (3) */
+   if (strcmp(file_data->logical_type, LT_BROKEN_LINK) == 0)
+      prev_link_kind = 3;
+   else if (strcmp(file_data->logical_type, LT_RECURSIVE_LINK) == 0)
+      prev_link_kind = 2;
+   else
+      prev_link_kind = 1;
+
+   /* Check what kind of link it is now */
+   if (_DtFollowLink(full_name) == NULL)
+      cur_link_kind = 2;  /* recursive link */
+   else if (stat(full_name, &stat_buf) != 0)
+      cur_link_kind = 3;  /* broken link */
+   else
+      cur_link_kind = 1;  /* a valid link */
+
+   return prev_link_kind != cur_link_kind;
+}
+
+
+/*--------------------------------------------------------------------
+ *  FileDataChanged
+ *    Check if a file needs to be re-typed: compare inode, size,
+ *    modification time and mode with what we saw the last time.
+ *    (For links, the stat information in FileData is the one of
+ *    the link target.)
+ *------------------------------------------------------------------*/
+
+static Boolean
+FileDataChanged(
+        char *full_name,
+        FileData *file_data)
+{
+   struct stat stat_buf;
+   int stat_result;
+
+   if (file_data->link != NULL)
+   {
+      if (LinkChanged(full_name, file_data))
+         return True;
+      if (file_data->is_broken)
+         return False;
+      stat_result = stat(full_name, &stat_buf);
+   }
+   else
+      stat_result = lstat(full_name, &stat_buf);
+
+   return stat_result != 0 ||
+          stat_buf.st_ino != file_data->stat.st_ino ||
+          stat_buf.st_size != file_data->stat.st_size ||
+          stat_buf.st_mtime != file_data->stat.st_mtime ||
+          stat_buf.st_mode != file_data->stat.st_mode;
+}
+
+
 /*--------------------------------------------------------------------
  *  UpdateAllProcess
  *    Main routine of the background process that checks the directory
  *    for new files or files that have disapeared.
+ *    Only entries that are new, gone, or changed (see FileDataChanged)
+ *    are typed and sent back through the pipe.
  *------------------------------------------------------------------*/
 
 static int
@@ -1719,7 +2096,12 @@ UpdateAllProcess(
    Boolean inDtDir;
    FileData *file_data;
    FileData *old_data, **old_pp;
+   FileData **old_list;
+   FileDataIndex old_index;
+   int old_count;
    FileData2 file_data2;
+   char full_name[MAX_PATH];
+   char *namep;
    char *ptr;
    short pipe_msg;
    int n, i, rc=0;
@@ -1921,6 +2303,18 @@ UpdateAllProcess(
       return 1;
    }
 
+   /*
+    * Index the old file list by name.  An entry whose slot is cleared
+    * has been seen; whatever is left at the end no longer exists.
+    */
+   old_list = FileDataListToArray(directory->file_data, &old_count);
+   FileDataIndexInit(&old_index, old_list, old_count);
+
+   strcpy(full_name, full_directory_name);
+   namep = full_name + strlen(full_name);
+   if (namep[-1] != '/')
+     *namep++ = '/';
+
    /*  Loop through the directory entries and update the file list  */
    while (dp = readdir (dirp))
    {
@@ -1929,24 +2323,18 @@ UpdateAllProcess(
          continue;
 
       /* check if we already know this file */
-      for (old_pp = &directory->file_data;
-           (old_data = *old_pp) != NULL;
-           old_pp = &old_data->next)
+      old_pp = FileDataIndexLookup(&old_index, dp->d_name);
+      if (old_pp != NULL)
       {
-         if (strcmp(dp->d_name, old_data->file_name) == 0)
-         {
-             char *tname;
-             struct stat sbuf;
- 
-             /* check modified times */
-             tname = XtMalloc(strlen(full_directory_name)+strlen(dp->d_name)+2);
-             sprintf(tname,"%s/%s",full_directory_name,dp->d_name);
-             if((lstat(tname,&sbuf)>=0)&&sbuf.st_mtime!=old_data->stat.st_mtime)
-                 old_data = NULL;
-             XtFree(tname);
-             if(old_data == NULL)
-                 break;
+         old_data = *old_pp;
+         *old_pp = NULL;
 
+         /* check if the file changed since we last looked at it */
+         strcpy(namep, dp->d_name);
+         if (FileDataChanged(full_name, old_data))
+            old_data = NULL;
+         else
+         {
             /* check if this file appears on the modified list */
             for (i = 0; i < directory->modified_count; i++)
                if (strcmp(dp->d_name, directory->modified_list[i]) == 0)
@@ -1958,29 +2346,21 @@ UpdateAllProcess(
                  old_data = NULL;
                  break;
                }
-            break;
          }
-      }
 
-      /* If this is a known file, remember we saw it and continue. */
-      if (old_data != NULL)
-      {
-         /*
-          * We remove the file from the old file list; thus, when we are done,
-          * the files on the old file list will be onew that no longer exist.
-          */
-         *old_pp = old_data->next;
-         continue;
+         /* If this is a known, unchanged file, continue. */
+         if (old_data != NULL)
+            continue;
       }
 
-      /* this is a new file */
+      /* this is a new or changed file */
       DPRINTF(("UpdateAllProcess: found new file \"%s\"\n", dp->d_name));
 
       /* Fix for incorrect icons in App Manager */
       {
 	Boolean IsToolBox;
 
-        if(directory->directoryView && directory->directoryView->file_mgr_data)
+        if(directory->numOfViews > 0 && directory->directoryView->file_mgr_data)
           IsToolBox = directory->directoryView->file_mgr_data->toolbox;
         else
           IsToolBox = False;
@@ -1997,10 +2377,11 @@ UpdateAllProcess(
    }
 
    /* all files left in the old file list no longer exist */
-   for (old_data = directory->file_data;
-        old_data;
-        old_data = old_data->next)
+   for (i = 0; i < old_count; i++)
    {
+      if ((old_data = old_list[i]) == NULL)
+         continue;
+
       DPRINTF(("UpdateAllProcess: file gone \"%s\"\n", old_data->file_name));
       old_data->errnum = ENOENT;
       pipe_msg = PIPEMSG_FILEDATA;
@@ -2008,6 +2389,9 @@ UpdateAllProcess(
       PipeWriteFileData(pipe_fd, old_data);
    }
 
+   FileDataIndexFree(&old_index);
+   XtFree((char *) old_list);
+
    /* free storage */
    XtFree(full_directory_name);
 
@@ -2096,7 +2480,7 @@ UpdateSomeProcess(
    {
       /* get the info */
 
-      if(directory->directoryView && directory->directoryView->file_mgr_data)
+      if(directory->numOfViews > 0 && directory->directoryView->file_mgr_data)
         IsToolBox = directory->directoryView->file_mgr_data->toolbox;
       else
         IsToolBox = False;
@@ -2144,6 +2528,9 @@ ReaddirPipeCallback(
    Boolean update_due;
    FileData *new_data = NULL, **new_nextp;
    FileData *old_data, **old_nextp;
+   FileData **new_list, **new_slot;
+   FileDataIndex new_index;
+   int new_count;
    char *ptr;
    char *err_msg;
    int i, n;
@@ -2163,6 +2550,7 @@ ReaddirPipeCallback(
       close(*fd);
       XtRemoveInput(*id);
       kill(pipe_data->child, SIGKILL);
+      ReadArenaDestroy(pipe_data->arena);
       XtFree( client_data );
       ScheduleActivity(NULL);
       return;
@@ -2198,8 +2586,7 @@ ReaddirPipeCallback(
            directory->path_logical_types[i] = PipeReadString(*fd);
 
          /* get the tt_path */
-         XtFree(directory->tt_path_name);
-         directory->tt_path_name = PipeReadString(*fd);
+         SetTTPathName(directory, PipeReadString(*fd));
 
          /* update all views */
          for (i = 0; i < directory->numOfViews; i++)
@@ -2215,6 +2602,7 @@ ReaddirPipeCallback(
           case PIPEMSG_FILEDATA:
           case PIPEMSG_FILEDATA2:
           case PIPEMSG_FILEDATA3:
+          case PIPEMSG_FILEDATA4:
 
          if (msg == PIPEMSG_FILEDATA)
          {
@@ -2235,16 +2623,18 @@ ReaddirPipeCallback(
            new_data = FileData2toFileData(&file_data2, &n);
            }
 
-         if (msg == PIPEMSG_FILEDATA3)
+         if (msg == PIPEMSG_FILEDATA3 || msg == PIPEMSG_FILEDATA4)
          {
-           int file_data_length;
-           int n;
-           char file_data_buffer[FILEDATABUF * sizeof(FileData2)];
-           char *file_data_buf_ptr;
-
+           for (new_nextp = &directory->new_data;
+                *new_nextp;
+                new_nextp = &(*new_nextp)->next)
+             ;
 
-           n = PipeRead(*fd, &file_data_count, sizeof(short));
-           n = PipeRead(*fd, &file_data_length, sizeof(int));
+           if (msg == PIPEMSG_FILEDATA3)
+             file_data_count = PipeReadFileData3(*fd, &new_nextp);
+           else
+             file_data_count = ReadArenaReceive(*fd, pipe_data->arena,
+                                                &new_nextp);
 
            if (file_data_count & 0x8000)
            {
@@ -2253,27 +2643,6 @@ ReaddirPipeCallback(
            }
            else
              update_due = False;
-
-           for (new_nextp = &directory->new_data;
-                *new_nextp;
-                new_nextp = &(*new_nextp)->next)
-             ;
-
-           n = PipeRead(*fd, file_data_buffer, file_data_length);
-           file_data_buf_ptr = file_data_buffer;
-
-           for (i = 0; i < file_data_count; i++)
-           {
-             /* get next FileData out of buffer */
-             new_data =
-               FileData2toFileData((FileData2 *)file_data_buf_ptr, &n);
-             file_data_buf_ptr += n;
-
-             /* append new_data to end of list */
-             *new_nextp = new_data;
-             new_data->next = NULL;
-             new_nextp = &new_data->next;
-           }
          }
          else
          {
@@ -2403,32 +2772,40 @@ ReaddirPipeCallback(
        * one we need to re-use the old FileData structures.
        * Reason: the code in GetFileData relies on this to
        * preserve the position_info and selection list.
-       * The following loops through the new list of files
-       * and replaces entries that also exist in the old list.
+       * The following loops through the old list of files
+       * and replaces entries in the new list that also exist
+       * in the old list.
        */
-      for (new_nextp = &directory->new_data;
-           (new_data = *new_nextp) != NULL;
-           new_nextp = &new_data->next)
+      new_list = FileDataListToArray(directory->new_data, &new_count);
+      FileDataIndexInit(&new_index, new_list, new_count);
+
+      old_nextp = &directory->file_data;
+      while ((old_data = *old_nextp) != NULL)
       {
-         for (old_nextp = &directory->file_data;
-              (old_data = *old_nextp) != NULL;
-              old_nextp = &old_data->next)
+         new_slot = FileDataIndexLookup(&new_index, old_data->file_name);
+         if (new_slot == NULL)
          {
-           if( strcmp(old_data->file_name, new_data->file_name) == 0 )
-            {
-               *old_nextp = old_data->next;
+            old_nextp = &old_data->next;
+            continue;
+         }
 
-               FreeFileData(old_data, False);
-               memcpy(old_data, new_data, sizeof(FileData));
+         *old_nextp = old_data->next;
 
-               XtFree((char *)new_data);
-               *new_nextp = new_data = old_data;
+         FreeFileData(old_data, False);
+         memcpy(old_data, *new_slot, sizeof(FileData));
 
-               break;
-            }
-         }
+         XtFree((char *)*new_slot);
+         *new_slot = old_data;
       }
 
+      /* relink the new list */
+      directory->new_data = new_list[0];
+      for (i = 0; i < new_count; i++)
+         new_list[i]->next = new_list[i + 1];
+
+      FileDataIndexFree(&new_index);
+      XtFree((char *) new_list);
+
       /*
        * If this was a complete re-read, we free all FileData still left
        * in the old list.  Otherwise, if this was just a partial update,
@@ -2521,7 +2898,7 @@ ReaddirPipeCallback(
 
       /* reset busy flags */
       directory->busy[activity] = False;
-      directory->activity = activity_idle;
+      SetActivity(directory, activity_idle);
       directory->was_up_to_date = True;
       directory->link_check_needed = False;
 
@@ -2585,6 +2962,7 @@ ReaddirPipeCallback(
              file_mgr_data->desktop_file = NULL;
          }
       }
+      ReadArenaDestroy(pipe_data->arena);
       XtFree(client_data);
 
       /* schedule the next background activity */
@@ -2677,23 +3055,8 @@ ReadDirectory(
       /* The directory is already in the cache. */
       directory->viewed = True;
 
-      /* Look for the view in the view list */
-      for (i = 0; i < directory->numOfViews; i++)
-         if (directory->directoryView[i].file_mgr_data == file_mgr_data)
-            break;
-
-      /* If view not found, add to the view list */
-      if (i == directory->numOfViews)
-      {
-         directory->directoryView = (DirectoryView *)
-                                 XtRealloc ((char *) directory->directoryView,
-                                            sizeof(DirectoryView) * (i + 1));
-         directory->numOfViews++;
-         directory->directoryView[i].file_mgr_data = file_mgr_data;
-      }
-
-      /* set mapped flag for the view */
-      directory->directoryView[i].mapped = file_mgr_data->mapped;
+      /* Add the view to the view list, if not already there */
+      DirectoryAddView(directory, file_mgr_data);
 
       /* check if we need to popup an error message */
       if (directory->errmsg_needed &&
@@ -2716,19 +3079,8 @@ ReadDirectory(
 
       /* The directory is not yet in the cache. */
 
-      /*  Expand the directory set array, if necessary.  */
-      if (directory_count == directory_set_size)
-      {
-         directory_set_size += 10;
-         directory_set = (Directory **) XtRealloc((char *)directory_set,
-                                    sizeof(Directory **) * directory_set_size);
-      }
-
-
       /*  Create and initialize a new directory entry  */
-      directory_set[directory_count] = directory =
-                                  (Directory *) XtMalloc (sizeof (Directory));
-      directory_count++;
+      directory = (Directory *) XtMalloc (sizeof (Directory));
 
       directory->host_name = XtNewString (host_name);
       directory->directory_name = XtNewString (directory_name);
@@ -2765,12 +3117,22 @@ ReadDirectory(
       directory->activity = activity_idle;
       for (i = 0; i < activity_idle; i++)
         directory->busy[i] = False;
+      directory->watch_wd = 0;
+      directory->watch_pending = False;
+      directory->watch_missed = False;
 
+      directory->view_alloc = 2;
       directory->directoryView = (DirectoryView *)
-                                       XtMalloc (sizeof(DirectoryView));
+                     XtMalloc (sizeof(DirectoryView) * directory->view_alloc);
       directory->directoryView[0].file_mgr_data = file_mgr_data;
       directory->directoryView[0].mapped = file_mgr_data->mapped;
 
+      AddDirectoryToSet(directory);
+
+#ifdef DIR_WATCH
+      DirWatchAdd(directory);
+#endif
+
       /*  Open the directory for reading and read the files.  */
       ReadDirectoryFiles (w, directory);
    }
@@ -3334,7 +3696,7 @@ UpdateCachedDirectories(
 {
    DialogData * dialog_data;
    FileMgrData * file_mgr_data;
-   int i, j, k, n;
+   int i, j, k;
    Directory *directory;
 
    /*
@@ -3345,9 +3707,7 @@ UpdateCachedDirectories(
    {
       if( !(strcmp(directory_set[i]->directory_name, trash_dir) == 0) )
       {
-         XtFree ((char *) directory_set[i]->directoryView);
          directory_set[i]->numOfViews = 0;
-         directory_set[i]->directoryView = NULL;
          directory_set[i]->viewed = False;
       }
    }
@@ -3380,13 +3740,7 @@ UpdateCachedDirectories(
          }
 
          /* add the directory to the view list */
-         n = directory->numOfViews;
-         directory->directoryView = (DirectoryView *)
-                                  XtRealloc ((char *) directory->directoryView,
-                                             sizeof(DirectoryView) * (n + 1));
-         directory->directoryView[n].file_mgr_data = file_mgr_data;
-         directory->directoryView[n].mapped = file_mgr_data->mapped;
-         directory->numOfViews++;
+         DirectoryAddView(directory, file_mgr_data);
          directory->viewed = True;
       }
    }
@@ -3413,12 +3767,8 @@ UpdateCachedDirectories(
                   directory_set[i]->host_name,
                   directory_set[i]->directory_name));
 
-         FreeDirectory(directory_set[i]);
-
-         for (k = i; k < directory_count - 1; k++)
-            directory_set[k] = directory_set[k + 1];
-
-         directory_count--;
+         /* the last entry of the set moves to position i */
+         RemoveDirectoryFromSet(directory_set[i]);
       }
    }
 
@@ -3991,7 +4341,7 @@ WritePosInfoPipeCallback(
 
    /* reset the busy flag and schedule new work, if any */
    directory->busy[activity_writing_posinfo] = False;
-   directory->activity = activity_idle;
+   SetActivity(directory, activity_idle);
    ScheduleActivity(directory);
 }
 
@@ -4148,9 +4498,6 @@ TimerEventProcess(
    char full_name[MAX_PATH];
    char *namep;
    short pipe_msg;
-   int prev_link_kind;
-   int cur_link_kind;
-   int link_rc;
    int rc;
 
    /*
@@ -4204,37 +4551,8 @@ TimerEventProcess(
          if (file_data->link == NULL)
             continue;
 
-         /* Check if the file is still a symbolic link */
          strcpy(namep, file_data->file_name);
-         link_rc = lstat(full_name, &stat_buf);
-         if (link_rc != 0 || (stat_buf.st_mode & S_IFMT) != S_IFLNK)
-         {
-            /* no longer a link */
-            link_changed = True;
-            break;
-         }
-
-         /* Check what kind of link this was the last time we looked:
-          * a normal link (1), a recursive link (2), or an otherwise
-          * broken link (3) */
-         if (strcmp(file_data->logical_type, LT_BROKEN_LINK) == 0)
-            prev_link_kind = 3;
-         else if (strcmp(file_data->logical_type, LT_RECURSIVE_LINK) == 0)
-            prev_link_kind = 2;
-         else
-            prev_link_kind = 1;
-
-         /* Check what kind of link it is now */
-         if (_DtFollowLink(full_name) == NULL)
-            cur_link_kind = 2;  /* recursive link */
-         else if (stat(full_name, &stat_buf) != 0)
-            cur_link_kind = 3;  /* broken link */
-         else
-            cur_link_kind = 1;  /* a valid link */
-
-         /* now we can tell if the link has changed */
-         if (prev_link_kind != cur_link_kind)
-           link_changed = True;
+         link_changed = LinkChanged(full_name, file_data);
       }
    }
 
@@ -4336,7 +4654,7 @@ TimerPipeCallback(
 
    /* reset the busy flag and schedule new work, if any */
    directory->busy[directory->activity] = False;
-   directory->activity = activity_idle;
+   SetActivity(directory, activity_idle);
    ScheduleActivity(directory);
 
    /* if directory-read already in progress, nothing more to do here */
@@ -4348,19 +4666,18 @@ TimerPipeCallback(
    if (SkipRefresh(directory))
       return;
 
-   /* if the directory was modified or links changed, re-read it */
+   /*
+    * If the directory was modified or links changed, update it;
+    * UpdateAllProcess re-types only the entries that changed.
+    */
    if (rc == 0)
    {
-      if (link_changed)
-      {
-         DPRINTF(("TimerPipeCallback: %s link changed\n",
-                  directory->directory_name));
-         ReadDirectoryFiles(NULL, directory);
-      }
-      else if (modify_time != directory->modify_time || directory->errnum != 0)
+      if (link_changed ||
+          modify_time != directory->modify_time || directory->errnum != 0)
       {
-         DPRINTF(("TimerPipeCallback: %s modified\n",
-                  directory->directory_name));
+         DPRINTF(("TimerPipeCallback: %s modified%s\n",
+                  directory->directory_name,
+                  link_changed? " (link changed)": ""));
          directory->busy[activity_update_all] = True;
          ScheduleActivity(directory);
       }
@@ -4430,7 +4747,7 @@ CheckDesktopProcess(
          /* See if the type has changed */
          old_data = file_view_data->file_data;
 
-         if(directory->directoryView && directory->directoryView->file_mgr_data)
+         if(directory->numOfViews > 0 && directory->directoryView->file_mgr_data)
              IsToolBox = directory->directoryView->file_mgr_data->toolbox;
          else
              IsToolBox = False;
@@ -4570,7 +4887,7 @@ CheckDesktopPipeCallback(
 
       /* reset the busy flag and schedule new work, if any */
       directory->busy[directory->activity] = False;
-      directory->activity = activity_idle;
+      SetActivity(directory, activity_idle);
       ScheduleActivity(directory);
    }
 }
@@ -4684,6 +5001,25 @@ TimerEvent(
           directory_set[i]->busy[activity_checking_links])
          continue;
 
+#ifdef DIR_WATCH
+      /*
+       * Watched directories don't need to be polled; we only have to
+       * catch up on changes that were reported while no view was mapped.
+       * Links are still checked, since their targets may be elsewhere.
+       */
+      if (directory_set[i]->watch_wd > 0 &&
+          !directory_set[i]->link_check_needed)
+      {
+         if (directory_set[i]->watch_missed)
+         {
+            directory_set[i]->watch_missed = False;
+            directory_set[i]->busy[activity_update_all] = True;
+            ScheduleActivity(directory_set[i]);
+         }
+         continue;
+      }
+#endif
+
       /* add this directory to the check list */
       check_list[n++] = i;
    }
@@ -4761,6 +5097,300 @@ TimerEventBrokenLinks(
 }
 
 
+#ifdef DIR_WATCH
+/*====================================================================
+ *
+ * Directory change notification
+ *
+ *   Local directories are watched with inotify instead of being
+ *   polled by TimerEvent.  Change events put the affected names on
+ *   the modified_list of the directory and schedule the same
+ *   activity_update_some background process DirectoryEndModify uses,
+ *   so only the entries that actually changed are re-stat'ed and
+ *   re-typed.  Directories on network file systems (where inotify
+ *   doesn't see changes made by other hosts) and directories that
+ *   couldn't be watched keep being polled.
+ *
+ *==================================================================*/
+
+#define WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                      IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | \
+                      IN_MOVE_SELF | IN_ONLYDIR)
+
+/* if more files than this changed, update the whole directory */
+#define WATCH_MAX_MODIFIED 256
+
+/*--------------------------------------------------------------------
+ *  DirWatchIsRemote
+ *    Check if a directory lives on a network file system.
+ *------------------------------------------------------------------*/
+
+static Boolean
+DirWatchIsRemote(
+        char *path)
+{
+   struct statfs fs_buf;
+
+   if (statfs(path, &fs_buf) != 0)
+      return True;
+
+   switch ((unsigned long) fs_buf.f_type)
+   {
+#ifdef NFS_SUPER_MAGIC
+      case NFS_SUPER_MAGIC:
+#endif
+#ifdef SMB_SUPER_MAGIC
+      case SMB_SUPER_MAGIC:
+#endif
+#ifdef CIFS_SUPER_MAGIC
+      case (unsigned long) CIFS_SUPER_MAGIC:
+#endif
+#ifdef SMB2_SUPER_MAGIC
+      case (unsigned long) SMB2_SUPER_MAGIC:
+#endif
+#ifdef AFS_SUPER_MAGIC
+      case AFS_SUPER_MAGIC:
+#endif
+#ifdef CODA_SUPER_MAGIC
+      case CODA_SUPER_MAGIC:
+#endif
+#ifdef CEPH_SUPER_MAGIC
+      case CEPH_SUPER_MAGIC:
+#endif
+#ifdef V9FS_MAGIC
+      case V9FS_MAGIC:
+#endif
+#ifdef FUSE_SUPER_MAGIC
+      case FUSE_SUPER_MAGIC:
+#endif
+         return True;
+   }
+
+   return False;
+}
+
+
+/*--------------------------------------------------------------------
+ *  DirWatchAdd
+ *    Start watching a newly cached directory.
+ *------------------------------------------------------------------*/
+
+static void
+DirWatchAdd(
+        Directory *directory)
+{
+   int wd;
+
+   directory->watch_wd = 0;
+   if (watch_fd < 0 || directory->path_name[0] == '\0')
+      return;
+
+   if (DirWatchIsRemote(directory->path_name))
+   {
+      DPRINTF(("DirWatchAdd: polling remote directory %s\n",
+               directory->path_name));
+      return;
+   }
+
+   /*
+    * Note: several directory entries may refer to the same directory
+    * (links, mount points); inotify then returns the same descriptor.
+    */
+   wd = inotify_add_watch(watch_fd, directory->path_name, WATCH_EVENTS);
+   if (wd < 0)
+   {
+      DPRINTF(("DirWatchAdd: cannot watch %s: %s\n",
+               directory->path_name, strerror(errno)));
+      return;
+   }
+
+   directory->watch_wd = wd;
+}
+
+
+/*--------------------------------------------------------------------
+ *  DirWatchRemove
+ *    Stop watching a directory that is removed from the cache.
+ *------------------------------------------------------------------*/
+
+static void
+DirWatchRemove(
+        Directory *directory)
+{
+   int i;
+
+   if (directory->watch_wd <= 0)
+      return;
+
+   /* keep the watch if another cache entry shares it */
+   for (i = 0; i < directory_count; i++)
+      if (directory_set[i] != directory &&
+          directory_set[i]->watch_wd == directory->watch_wd)
+         break;
+
+   if (i == directory_count)
+      inotify_rm_watch(watch_fd, directory->watch_wd);
+
+   directory->watch_wd = 0;
+}
+
+
+/*--------------------------------------------------------------------
+ *  DirWatchQueue
+ *    Remember that a file in a watched directory changed.
+ *    A NULL file name means the whole directory needs an update.
+ *------------------------------------------------------------------*/
+
+static void
+DirWatchQueue(
+        Directory *directory,
+        char *file_name)
+{
+   int i;
+
+   directory->watch_pending = True;
+
+   if (file_name == NULL || directory->modified_count >= WATCH_MAX_MODIFIED)
+   {
+      directory->busy[activity_update_all] = True;
+      return;
+   }
+
+   /* changes to our own position info file don't show up in the view */
+   if (positionFileName && strcmp(file_name, positionFileName) == 0)
+      return;
+
+   for (i = 0; i < directory->modified_count; i++)
+      if (strcmp(directory->modified_list[i], file_name) == 0)
+         return;
+
+   i = directory->modified_count++;
+   directory->modified_list = (char **)
+     XtRealloc((char *)directory->modified_list, (i + 1)*sizeof(char *));
+   directory->modified_list[i] = XtNewString(file_name);
+}
+
+
+/*--------------------------------------------------------------------
+ *  DirWatchFlush
+ *    Schedule background updates for all directories that received
+ *    change events.
+ *------------------------------------------------------------------*/
+
+static void
+DirWatchFlush(
+        XtPointer client_data,
+        XtIntervalId *id)
+{
+   Directory *directory;
+   int i;
+
+   if (id != NULL)
+      watch_timer_id = None;
+
+   /* don't change any directories while a drag is active (see TimerEvent) */
+   if (dragActive)
+   {
+      if (watch_timer_id == None)
+         watch_timer_id = XtAppAddTimeOut(app_context, 500,
+                                          DirWatchFlush, NULL);
+      return;
+   }
+
+   for (i = 0; i < directory_count; i++)
+   {
+      directory = directory_set[i];
+      if (!directory->watch_pending)
+         continue;
+      directory->watch_pending = False;
+
+      /* DirectoryEndModify will pick up the modified_list */
+      if (directory->modify_begin > 0)
+         continue;
+
+      /* don't refresh views that aren't visible; TimerEvent catches up */
+      if (SkipRefresh(directory))
+      {
+         directory->watch_missed = True;
+         continue;
+      }
+
+      DPRINTF(("DirWatchFlush: %s changed, %d files\n",
+               directory->directory_name, directory->modified_count));
+
+      if (directory->modified_count > 0 &&
+          !directory->busy[activity_update_all])
+         directory->busy[activity_update_some] = True;
+      ScheduleActivity(directory);
+   }
+}
+
+
+/*--------------------------------------------------------------------
+ *  DirWatchCallback
+ *    Read change events from the inotify descriptor.
+ *------------------------------------------------------------------*/
+
+static void
+DirWatchCallback(
+   XtPointer client_data,
+   int *fd,
+   XtInputId *id)
+{
+   char buf[4096]
+      __attribute__ ((aligned(__alignof__(struct inotify_event))));
+   struct inotify_event *event;
+   Directory *directory;
+   char *ptr;
+   ssize_t len;
+   int i;
+
+   while ((len = read(*fd, buf, sizeof(buf))) > 0)
+   {
+      for (ptr = buf; ptr < buf + len;
+           ptr += sizeof(struct inotify_event) + event->len)
+      {
+         event = (struct inotify_event *) ptr;
+
+         /* lost events: everything we watch may have changed */
+         if (event->mask & IN_Q_OVERFLOW)
+         {
+            for (i = 0; i < directory_count; i++)
+               if (directory_set[i]->watch_wd > 0)
+                  DirWatchQueue(directory_set[i], NULL);
+            continue;
+         }
+
+         for (i = 0; i < directory_count; i++)
+         {
+            directory = directory_set[i];
+            if (directory->watch_wd != event->wd)
+               continue;
+
+            if (event->mask & IN_IGNORED)
+            {
+               /* watch is gone (directory removed or unmounted): poll */
+               directory->watch_wd = 0;
+            }
+            else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+            {
+               /* let the timer check find out what happened */
+               directory->busy[activity_checking_dir] = True;
+               directory->watch_pending = True;
+            }
+            else if (event->len > 0)
+               DirWatchQueue(directory, event->name);
+            else
+               DirWatchQueue(directory, ".");
+         }
+      }
+   }
+
+   DirWatchFlush(NULL, NULL);
+}
+#endif /* DIR_WATCH */
+
+
 /*====================================================================
  *
  * Background process scheduler
@@ -4795,6 +5425,7 @@ ScheduleDirectoryActivity(
    int pipe_s2m_fd[2] = {-1, -1};  /* for msgs from backgroundnd proc (slave to master) */
    int pipe_m2s_fd[2] = {-1, -1};  /* for msgs to backgroundnd proc (master to slave) */
    pid_t pid = 0;
+   ReadArena *arena = NULL;
    char *s;
    int rc;
 
@@ -4823,21 +5454,15 @@ ScheduleDirectoryActivity(
              directory->directory_name));
 
    /* Don't start more than a certain number of background processed */
-   n_active = 0;
+   n_active = active_count;
    n_checking = 0;
-   for (j = 0; j < directory_count; j++)
+   for (j = 0; j < active_count; j++)
    {
-      if (directory_set[j]->activity != activity_idle)
-         n_active++;
-      if (directory_set[j]->activity == activity_checking_links ||
-          directory_set[j]->activity == activity_checking_dir)
+      if (active_set[j]->activity == activity_checking_links ||
+          active_set[j]->activity == activity_checking_dir ||
+          active_set[j] == dummy_directory)
          n_checking++;
    }
-   if (dummy_directory->activity != activity_idle)
-   {
-      n_active++;
-      n_checking++;
-   }
    if (n_active >= maxDirectoryProcesses ||
        n_checking >= maxRereadProcesses)
    {
@@ -4864,16 +5489,12 @@ ScheduleDirectoryActivity(
 
       /* see if the same view appears in the view list of a non-idle dir */
        this_view_active = False;
-       for (j = 0; j < directory_count && !this_view_active; j++)
+       for (j = 0; j < active_count && !this_view_active; j++)
        {
-         /* we are only interested in directories that are not idle */
-         if (directory_set[j]->activity == activity_idle)
-           continue;
-
          /* see if the view appears in the view list */
-         for (k = 0; k < directory_set[j]->numOfViews; k++)
+         for (k = 0; k < active_set[j]->numOfViews; k++)
          {
-           if (directory_set[j]->directoryView[k].file_mgr_data ==
+           if (active_set[j]->directoryView[k].file_mgr_data ==
                file_mgr_data)
            {
              this_view_active = True;
@@ -4897,7 +5518,7 @@ ScheduleDirectoryActivity(
    }
 
    /* now we are ready to start the next activity */
-   directory->activity = activity;
+   SetActivity(directory, activity);
    if (activity == activity_reading ||
        activity == activity_update_all ||
        activity == activity_checking_dir ||
@@ -4987,6 +5608,10 @@ ScheduleDirectoryActivity(
          p->idle = False;
       }
 
+      /* directory reads pass their data through shared memory */
+      if (activity == activity_reading)
+         arena = ReadArenaCreate();
+
       /* fork a background process */
       pid = fork();
 
@@ -4999,8 +5624,9 @@ ScheduleDirectoryActivity(
 		"%s:  fork failed, ppid %d, pid %d, activity %d: error %d=%s\n",
 		pname, getppid(), getpid(), activity, errno, strerror(errno));
 
-	  directory->activity = activity_idle;
+	  SetActivity(directory, activity_idle);
           directory->last_check = save_last_check;
+          ReadArenaDestroy(arena);
 
           /* close unused pipe connections */
           close(pipe_s2m_fd[0]);    /* child won't read from this pipe */
@@ -5028,6 +5654,8 @@ ScheduleDirectoryActivity(
          if (sticky)
             close(pipe_m2s_fd[1]); /* child won't write to this pipe */
 
+         read_arena = arena;
+
          /* run main routine for this activity from ActivityTable */
          for (;;)
          {
@@ -5095,6 +5723,7 @@ ScheduleDirectoryActivity(
    pipe_data->child = pid;
    pipe_data->sticky_proc = p;
    pipe_data->activity = activity;
+   pipe_data->arena = arena;
 
    XtAppAddInput(XtWidgetToApplicationContext(toplevel),
                  pipe_s2m_fd[0], (XtPointer)XtInputReadMask,
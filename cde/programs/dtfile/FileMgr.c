@@ -3966,6 +3966,7 @@ GetFileData(
    int i;
    int j;
    int k;
+   int n;
    Boolean match;
 
 
@@ -4017,6 +4018,7 @@ GetFileData(
       new_file_count = new_dir_set[j]->file_count;
 
       /* loop throught the old file list */
+      k = 0;
       for (j = 0; j < directory_set[i]->file_count; j++)
       {
          file_view_data = directory_set[i]->file_view_data[j];
@@ -4024,9 +4026,14 @@ GetFileData(
 
          /*
           * Find a file by the same name in the new file list.
+          * Both lists are built from the same cached file list, so
+          * they are mostly in the same order: start looking where
+          * the previous match was found and wrap around.
           */
-         for (k = 0; k < new_file_count; k++)
+         for (n = 0; n < new_file_count; n++, k++)
          {
+            if (k >= new_file_count)
+               k = 0;
             if (new_view_data[k]->file_data == file_view_data->file_data)
             {
                 /* Fix for defect 5029    */
@@ -4069,7 +4076,7 @@ GetFileData(
          /* if no file by the same name was found in the new file list,
             the file must have gone away ... lets eliminate the
             position infomation */
-         if (position_info && k == new_file_count)
+         if (position_info && n == new_file_count)
          {
             for (k = 0; k < file_mgr_data->num_objects; k++)
             {
@@ -253,6 +253,7 @@ typedef struct
    int maxDirectoryProcesses;
    int maxRereadProcesses;
    int maxRereadProcsPerTick;
+   Boolean watchDirectories;
    int trashWait;
    int desktopIconType;
    Boolean showFilesystem;
@@ -842,6 +843,12 @@ static XtResource resources[] =
      (XtPointer) 1,
    },
 
+   {
+     "watchDirectories", "WatchDirectories", XmRBoolean, sizeof (Boolean),
+     XtOffset (ApplicationArgsPtr, watchDirectories), XmRImmediate,
+     (XtPointer) True,
+   },
+
    {
      "trashWait", "TrashWait", XmRInt, sizeof (int),
      XtOffset (ApplicationArgsPtr, trashWait), XmRImmediate, (XtPointer) 1,
@@ -1468,6 +1475,7 @@ _DtPerfChkpntMsgSend("Begin XtInitialize");
    maxDirectoryProcesses = application_args.maxDirectoryProcesses;
    maxRereadProcesses = application_args.maxRereadProcesses;
    maxRereadProcsPerTick = application_args.maxRereadProcsPerTick;
+   watchDirectories = application_args.watchDirectories;
    trashWait = application_args.trashWait;
    showFilesystem = application_args.showFilesystem;
    showDropZone = application_args.showDropZone;
@@ -296,6 +296,7 @@ extern Boolean follow_links;
 extern int maxDirectoryProcesses;
 extern int maxRereadProcesses;
 extern int maxRereadProcsPerTick;
+extern Boolean watchDirectories;
 extern int rereadTime;
 extern int checkBrokenLink;
 extern int trashWait;
@@ -684,10 +685,6 @@ extern Boolean DirectoryBusy(
 extern char * GetDirectoryLogicalType(
                         FileMgrData *file_mgr_data,
                         char *path) ;
-extern FileData * FileData2toFileData(
-                        FileData2 *file_data2,
-                        int *l);
-
 extern FileData * ReadFileData(
                         char *full_directory_name,
                         char *file_name);
@@ -719,6 +716,11 @@ extern void TimerEventBrokenLinks(
 extern char * GetTTPath(
                         char *name) ;
 
+/* prototype from DirReader.c */
+extern FileData * FileData2toFileData(
+                        FileData2 *file_data2,
+                        int *l);
+
 /* prototypes for File.c */
 
 extern void SetHotRects (
@@ -0,0 +1,371 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/************************************<+>*************************************
+ ****************************************************************************
+ *
+ *   FILE:           dirbench.c
+ *
+ *   COMPONENT_NAME: Desktop File Manager (dtfile)
+ *
+ *   Description:    Times reading a large directory through the pipe
+ *                   (PIPEMSG_FILEDATA3) and through the shared memory
+ *                   arena (PIPEMSG_FILEDATA4), using the same reader and
+ *                   receiver routines as dtfile.
+ *
+ *                   usage: dirbench [file_count [runs [parent_dir]]]
+ *
+ *                   A temporary directory with file_count (default
+ *                   100000) empty files is created in parent_dir
+ *                   (default /tmp) and removed again at the end.
+ *                   ReadFileData2 is replaced by a plain lstat, so
+ *                   data typing is left out and only the transport
+ *                   between the processes is measured.
+ *
+ ****************************************************************************
+ ************************************<+>*************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <Xm/Xm.h>
+
+#include "Encaps.h"
+#include "FileMgr.h"
+#include "Desktop.h"
+#include "Main.h"
+#include "DirReader.h"
+
+#define DEFAULT_FILE_COUNT  100000
+#define DEFAULT_RUNS        5
+
+
+/*--------------------------------------------------------------------
+ *  Stand-ins for the dtfile routines used by DirReader.c
+ *------------------------------------------------------------------*/
+
+int
+PipeRead(
+	int fd,
+	void *buf,
+	int len)
+{
+   int n = 0;
+   int rc;
+
+   while (n < len)
+   {
+      rc = read(fd, (char *)buf + n, len - n);
+      if (rc > 0)
+        n += rc;
+      else if (rc < 0 && errno == EINTR)
+         ;  /* try again */
+      else
+         break;
+   }
+
+   return n;
+}
+
+
+/* like ReadFileData2 in Directory.c, without data typing and links */
+int
+ReadFileData2(
+	FileData2 *file_data2,
+	char *full_directory_name,
+	char *file_name,
+        Boolean IsToolBox)
+{
+   char full_file_name[MAXPATHLEN];
+   char *logical_type;
+   int i;
+
+   sprintf(full_file_name, "%s/%s", full_directory_name, file_name);
+
+   file_data2->next = NULL;
+   file_data2->is_subdir = False;
+   file_data2->is_broken = False;
+   if (lstat(full_file_name, &file_data2->stat) == 0)
+   {
+      file_data2->errnum = 0;
+      if (S_ISDIR(file_data2->stat.st_mode))
+      {
+         file_data2->physical_type = DtDIRECTORY;
+         file_data2->is_subdir = strcmp(file_name, ".") != 0 &&
+                                 strcmp(file_name, "..") != 0;
+         logical_type = "DIRECTORY";
+      }
+      else
+      {
+         file_data2->physical_type = DtDATA;
+         logical_type = "DATA";
+      }
+   }
+   else
+   {
+      file_data2->errnum = errno;
+      memset(&file_data2->stat, 0, sizeof(file_data2->stat));
+      file_data2->physical_type = DtUNKNOWN;
+      file_data2->is_broken = True;
+      logical_type = "DATA";
+   }
+
+   strcpy(file_data2->text, file_name);
+   file_data2->file_name = strlen(file_name);
+   file_data2->action_name = 0;
+   strcat(file_data2->text, logical_type);
+   file_data2->logical_type = strlen(logical_type);
+   file_data2->link = 0;
+   file_data2->final_link = 0;
+
+   i = sizeof(*file_data2) - sizeof(file_data2->text)
+       + file_data2->file_name + file_data2->logical_type;
+
+   return (i + sizeof(char *) - 1) & ~(sizeof(char *) - 1);
+}
+
+
+/*--------------------------------------------------------------------
+ *  Benchmark
+ *------------------------------------------------------------------*/
+
+static void
+FreeFileDataList(
+        FileData *file_data)
+{
+   FileData *next;
+
+   for (; file_data != NULL; file_data = next)
+   {
+      next = file_data->next;
+      XtFree(file_data->file_name);
+      XtFree(file_data->action_name);
+      XtFree(file_data->logical_type);
+      XtFree(file_data->link);
+      XtFree(file_data->final_link);
+      XtFree((char *) file_data);
+   }
+}
+
+
+/* read the directory in a child process, as ReadDirectoryProcess does,
+   and collect the entries the way ReaddirPipeCallback does */
+static double
+ReadDirectoryTimed(
+        char *directory_name,
+        Boolean use_arena,
+        int *count,
+        int *messages)
+{
+   struct timeval start, end;
+   ReadArena *arena = NULL;
+   FileData *new_data = NULL;
+   FileData **new_nextp = &new_data;
+   FileData *file_data;
+   int pipe_fd[2];
+   pid_t child;
+   short msg;
+   short file_data_count;
+   DIR *dirp;
+   int rc;
+
+   gettimeofday(&start, NULL);
+
+   if (use_arena && (arena = ReadArenaCreate()) == NULL)
+   {
+      perror("dirbench: ReadArenaCreate");
+      exit(1);
+   }
+
+   if (pipe(pipe_fd) != 0)
+   {
+      perror("dirbench: pipe");
+      exit(1);
+   }
+
+   child = fork();
+   if (child < 0)
+   {
+      perror("dirbench: fork");
+      exit(1);
+   }
+
+   if (child == 0)
+   {
+      close(pipe_fd[0]);
+      if ((dirp = opendir(directory_name)) == NULL)
+         _exit(1);
+
+      if (arena != NULL)
+         rc = ReadDirectoryToArena(pipe_fd[1], arena, dirp,
+                                   directory_name, False, False);
+      else
+         rc = ReadDirectoryToPipe(pipe_fd[1], dirp,
+                                  directory_name, False, False);
+      closedir(dirp);
+
+      msg = PIPEMSG_DONE;
+      write(pipe_fd[1], &msg, sizeof(short));
+      _exit(rc != 0);
+   }
+
+   close(pipe_fd[1]);
+
+   *count = 0;
+   *messages = 0;
+   while (PipeRead(pipe_fd[0], &msg, sizeof(short)) == sizeof(short) &&
+          msg != PIPEMSG_DONE)
+   {
+      if (msg == PIPEMSG_FILEDATA3)
+         file_data_count = PipeReadFileData3(pipe_fd[0], &new_nextp);
+      else if (msg == PIPEMSG_FILEDATA4)
+         file_data_count = ReadArenaReceive(pipe_fd[0], arena, &new_nextp);
+      else
+      {
+         fprintf(stderr, "dirbench: unexpected message %d\n", msg);
+         exit(1);
+      }
+      *count += file_data_count & 0x7fff;
+      (*messages)++;
+   }
+
+   close(pipe_fd[0]);
+   waitpid(child, NULL, 0);
+   ReadArenaDestroy(arena);
+
+   gettimeofday(&end, NULL);
+
+   /* make sure everything came across */
+   rc = 0;
+   for (file_data = new_data; file_data != NULL; file_data = file_data->next)
+      rc++;
+   if (rc != *count)
+   {
+      fprintf(stderr, "dirbench: %d entries announced, %d received\n",
+              *count, rc);
+      exit(1);
+   }
+   FreeFileDataList(new_data);
+
+   return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+
+static void
+RemoveDirectory(
+        char *directory_name,
+        int file_count)
+{
+   char path[MAXPATHLEN];
+   int i;
+
+   for (i = 0; i < file_count; i++)
+   {
+      sprintf(path, "%s/file%06d.txt", directory_name, i);
+      unlink(path);
+   }
+   rmdir(directory_name);
+}
+
+
+int
+main(
+        int argc,
+        char **argv)
+{
+   char directory_name[MAXPATHLEN];
+   char path[MAXPATHLEN];
+   int file_count = DEFAULT_FILE_COUNT;
+   int runs = DEFAULT_RUNS;
+   char *parent = "/tmp";
+   double pipe_time, arena_time, t;
+   int pipe_msgs, arena_msgs;
+   int count;
+   int i, fd;
+
+   if (argc > 1)
+      file_count = atoi(argv[1]);
+   if (argc > 2)
+      runs = atoi(argv[2]);
+   if (argc > 3)
+      parent = argv[3];
+   if (file_count <= 0 || runs <= 0)
+   {
+      fprintf(stderr, "usage: %s [file_count [runs [parent_dir]]]\n",
+              argv[0]);
+      return 2;
+   }
+
+   sprintf(directory_name, "%s/dirbenchXXXXXX", parent);
+   if (mkdtemp(directory_name) == NULL)
+   {
+      perror("dirbench: mkdtemp");
+      return 1;
+   }
+
+   for (i = 0; i < file_count; i++)
+   {
+      sprintf(path, "%s/file%06d.txt", directory_name, i);
+      if ((fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644)) < 0)
+      {
+         perror(path);
+         RemoveDirectory(directory_name, i);
+         return 1;
+      }
+      close(fd);
+   }
+
+   printf("%s: %d files, best of %d runs\n",
+          directory_name, file_count, runs);
+
+   /* warm up the directory and inode caches */
+   ReadDirectoryTimed(directory_name, False, &count, &pipe_msgs);
+
+   pipe_time = arena_time = 0;
+   for (i = 0; i < runs; i++)
+   {
+      t = ReadDirectoryTimed(directory_name, False, &count, &pipe_msgs);
+      if (i == 0 || t < pipe_time)
+         pipe_time = t;
+
+      t = ReadDirectoryTimed(directory_name, True, &count, &arena_msgs);
+      if (i == 0 || t < arena_time)
+         arena_time = t;
+   }
+
+   printf("  pipe  (FILEDATA3): %8.3f s %10.0f entries/s %7d messages\n",
+          pipe_time, count / pipe_time, pipe_msgs);
+   printf("  arena (FILEDATA4): %8.3f s %10.0f entries/s %7d messages\n",
+          arena_time, count / arena_time, arena_msgs);
+
+   RemoveDirectory(directory_name, file_count);
+   return 0;
+}
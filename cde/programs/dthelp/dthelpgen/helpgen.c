@@ -50,6 +50,7 @@
 #include "DtI/AccessI.h"      /* in DtHelp library */
 #include "AccessCCDFI.h"  /* in DtHelp library */
 #include "StringFuncsI.h" /* in DtHelp library */
+#include "TextIndexI.h"   /* in DtHelp library */
 
 #ifdef _AIX
 #include <LocaleXlate.h>
@@ -87,7 +88,7 @@ static const int NL_CAT_LOCALE = 0;
  *****************************************************************************/
 static	const char *ShellCmd    = "sh";
 static	const char *UsageStr    =
-	"%s -dir <directory> [-generate] [-file <name>] [-lang <language>]\n";
+	"%s -dir <directory> [-generate] [-index] [-file <name>] [-lang <language>]\n";
 static	const char *TopLocId    = "_hometopic";
 static	const char *SlashString = "/";
 static	const char *C_String    = "C";
@@ -941,6 +942,7 @@ main(
     int      foundVolumes;
     int      usedUser = 0;
     int      doGen    = 0;
+    int      doIndex  = 0;
 
     char     tmpVolume  [MAXPATHLEN + 2];
     char     tmpVolumeTemp[sizeof(tmpVolume)];
@@ -999,6 +1001,8 @@ main(
 	        App_args.file = argv[++i];
 	    else if (argv[i][1] == 'g')
 		doGen = 1;
+	    else if (argv[i][1] == 'i')
+		doGen = doIndex = 1;
 	    else if (argv[i][1] == 'l' && i + 1 < argc)
 	        App_args.lang = argv[++i];
 	    else
@@ -1464,6 +1468,13 @@ main(
 	fprintf (stderr,
 		GetMessage (1, 17, "%s: Zero Volume files found\n"), myName);
 
+    /*
+     * Index the text of the volumes for the global search of the
+     * help dialog.  The indexes of unchanged volumes are kept.
+     */
+    for (next = FullVolName; doIndex && next != NULL && *next != NULL; next++)
+	_DtHelpTextIndexClose(_DtHelpTextIndexOpen(*next, True));
+
     /*
      * Clean up
      */
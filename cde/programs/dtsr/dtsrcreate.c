@@ -817,6 +817,7 @@ DBD_OKAY:
     remove_d9x_file (".d97");
     remove_d9x_file (".d98");
     remove_d9x_file (".d99");
+    remove_d9x_file (".d96");
 
     *newextp = 0;	/* no extension suffixes for next msgs */
     printf (CATGETS(dtsearch_catd, MS_initausd, 24,
@@ -23,20 +23,44 @@
 /*
  *   COMPONENT_NAME: austext
  *
- *   FUNCTIONS: descend_tree
+ *   FUNCTIONS: add_wpdir
+ *		bad_run
+ *		compare_d99
+ *		compare_dbalist
+ *		compare_wpdir
+ *		descend_tree
  *		displayable
  *		fill_data1
+ *		finish_wordpos
+ *		fread_run
+ *		free_tree
+ *		hash_token
  *		load_into_bintree
  *		main
+ *		merge_runs
+ *		parse_record
+ *		parse_slice
  *		print_exit_code
  *		print_usage_msg
  *		put_addrs_2_dtbs_addr_file
+ *		read_run_dbas
+ *		read_run_word
+ *		remove_runs
+ *		run_parsers
+ *		save_position
  *		segregate_dicname
+ *		set_sorted_dbflag
+ *		skip_run_dbas
+ *		start_wordpos
  *		traverse_tree
+ *		tree_alloc
  *		user_args_processor
  *		write_2_dtbs_addr_file
  *		write_new_word_2_dtbs
+ *		write_run
+ *		write_run_node
  *		write_to_file
+ *		write_wordpos
  *
  *   ORIGINS: 27
  *
@@ -66,6 +90,17 @@
  * individual words by the parser function for the database's language.
  * Each record ends with a delimiter string specified by command line arg.
  *
+ * With -p, or whenever the database already has one, the offsets
+ * of every word and stem are also written to the word positions
+ * (d96) file, which the search engine uses for collocations.
+ * Words of the current batch are merged into the existing file.
+ *
+ * With -j the main process only reads the record headers in Pass 1.
+ * The text is parsed by parser processes, each building the tree of
+ * its share of the records and writing it to sorted run files when
+ * it grows too large.  Pass 2 then merges the runs instead of
+ * traversing a tree.  The d99 and d96 are the same either way.
+ *
  * $Log$
  * Revision 2.8  1996/04/10  19:50:38  miker
  * Deleted dangerous and unnecessary -a option.
@@ -122,9 +157,17 @@
 #include <errno.h>
 #include <math.h>
 #include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/time.h>
 #include <locale.h>
 #include "vista.h"
 
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS	MAP_ANON
+#endif
+
 extern void     find_keyword (char *cur_word, int vista_num);
 extern void     read_wordstr (struct or_hwordrec * glob_word, int vista_num);
 extern void     write_wordstr (struct or_hwordrec * glob_word, int vista_num);
@@ -140,6 +183,9 @@ void init_user_interrupt(void); // lib/DtSearch/userint.c
 #define WORDS_PER_DOT	500
 #define RECS_PER_DOT	20
 #define INBUFSZ		1024	/* default input text header line size */
+#define RUN_MBYTES	64L	/* default tree memory of a parser process */
+#define ARENA_SIZE	65536	/* bytes per chunk of tree memory */
+#define RUNFILE_FMT	"%s%s.r%d_%d"	/* path, dbname, proc#, run# */
 #define MS_misc		1
 #define MS_cborodin	14
 
@@ -203,11 +249,17 @@ char            new_dtbs_file =		FALSE;
 long            num_of_diff_words =	0L;
 int             normal_retncode =	0;
 static PARG	parg;
+static int	parse_procs =		0;	/* -j, 0 = parse in main */
+static DtSrUINT32
+		*posbuf =		NULL;	/* one word block of d96 */
+static long	posbufsz =		0L;
 int             parsep_char =		END_RETAIN_PAGE;
 char            rec_type;
 unsigned long	record_count =		0UL;
 int             record_lines;
 static int      recs_per_dot =		RECS_PER_DOT;
+static FILE	*run_fp =		NULL;	/* run file being written */
+static long	run_mbytes =		RUN_MBYTES;	/* -m */
 static unsigned long
 		seconds_left;
 extern int      shutdown_now;
@@ -216,8 +268,16 @@ static DtSrINT32
 char            *sprintbuffer =		NULL;
 char            *temp =			NULL;
 extern int	debugging_teskey;
+static WORDPOS	old_wordpos;		/* previous d96, if any */
+static int	wordpos_wanted =	FALSE;	/* -p */
+static FILE	*wordpos_fp =		NULL;	/* new d96 when open */
+static char	wordpos_file [_POSIX_PATH_MAX];
+static char	wordpos_temp [_POSIX_PATH_MAX];
 time_t          timestart =		0;
 time_t          totalstart =		0;
+static struct timeval
+		tv_start;		/* for records per second */
+static size_t	tree_bytes =		0;	/* memory held by tree */
 static int      words_per_dot =		WORDS_PER_DOT;
 
 /************************************************/
@@ -229,8 +289,70 @@ typedef struct dba_str {
     DB_ADDR		dba;
     DtSrINT32		w_c;
     struct dba_str	*next_dba;
+    DtSrUINT32		*posns;	/* w_c offset/length pairs for d96 */
 }               DBALIST;
 
+/************************************************/
+/*						*/
+/*		     WPDIR			*/
+/*						*/
+/************************************************/
+/* One word of the directory of the new d96 file */
+typedef struct {
+    char		*word;
+    DtSrUINT32		offset;	/* of word block */
+}               WPDIR;
+
+static WPDIR	*wpdir =		NULL;
+static long	wpdir_count =		0L;
+static long	wpdir_size =		0L;
+
+/************************************************/
+/*						*/
+/*		     PASS1REC			*/
+/*						*/
+/************************************************/
+/* One record of the batch when the text is parsed
+ * by parser processes (-j).  Pass 1 in the main process
+ * only finds the record's rec# and the start of its text.
+ */
+typedef struct {
+    long		offset;	/* of record text in .fzk file */
+    DB_ADDR		dba;	/* rec#, base 1 */
+}               PASS1REC;
+
+static PASS1REC	*pass1recs =		NULL;
+static long	pass1count =		0L;
+
+/************************************************/
+/*						*/
+/*		     PROCSTAT			*/
+/*						*/
+/************************************************/
+/* Results of one parser process, in memory
+ * shared with the main process.
+ */
+typedef struct {
+    int			runs;	/* number of run files written */
+}               PROCSTAT;
+
+static PROCSTAT	*procstat =		NULL;
+
+/************************************************/
+/*						*/
+/*		     RUNFILE			*/
+/*						*/
+/************************************************/
+/* One run file being merged in Pass 2 */
+typedef struct {
+    FILE		*fp;	/* NULL at end of run */
+    char		*word;	/* token of next node */
+    char		fname [_POSIX_PATH_MAX + 32];
+}               RUNFILE;
+
+static DBALIST	*merge_dbas =		NULL;	/* dbas of a merged token */
+static long	merge_count =		0L;
+
 /************************************************/
 /*						*/
 /*		     TREENODE			*/
@@ -240,16 +362,22 @@ typedef struct _treen_ {
     char           *word;	/* ptr to word in stop list */
     struct _treen_ *llink;	/* left link in binary tree */
     struct _treen_ *rlink;	/* ptr to right link in binary tree */
+    struct _treen_ *hlink;	/* next node in node_hash chain */
     DBALIST        *dba_list;
 }               TREENODE;
 
 static TREENODE *root_node =		NULL;
+static TREENODE	**node_hash =		NULL;	/* index of tree nodes */
+static size_t	node_hashsz =		0;	/* power of 2 */
+static char	*arena =		NULL;	/* chunk of tree memory */
+static size_t	arena_used =		ARENA_SIZE;
 static TREENODE *top_of_stack;
 static TREENODE *stack;
 static TREENODE *pres;
 static TREENODE *prev;
 static TREENODE *next;
 static TREENODE *avail_node;
+static void	(*visit_node) (TREENODE *);	/* of traverse_tree() */
 
 
 
@@ -285,6 +413,33 @@ static char	*displayable (char *passed_string)
 } /* displayable() */
 
 
+/****************************************/
+/*					*/
+/*		remove_runs		*/
+/*					*/
+/****************************************/
+/* Removes the run files of the parser processes.
+ * Called when Pass 2 has merged them, and at exit
+ * in case the run was aborted before that.
+ */
+static void	remove_runs (void)
+{
+    char	runfile [_POSIX_PATH_MAX + 32];
+    int		procno, run;
+
+    if (procstat == NULL)
+	return;
+    for (procno = 0;  procno < parse_procs;  procno++) {
+	for (run = 0;  run < procstat[procno].runs;  run++) {
+	    sprintf (runfile, RUNFILE_FMT, dicpath, dicname, procno, run);
+	    remove (runfile);
+	}
+	procstat[procno].runs = 0;
+    }
+    return;
+} /* remove_runs() */
+
+
 /************************************************/
 /*                                              */
 /*               print_exit_code                */
@@ -293,6 +448,7 @@ static char	*displayable (char *passed_string)
 /* Called from inside DtSearchExit() at (*austext_exit_last)() */
 static void     print_exit_code (int exit_code)
 {
+    remove_runs ();
     if(dotcount) {
 	putchar ('\n');
 	dotcount = 0;
@@ -307,6 +463,195 @@ static void     print_exit_code (int exit_code)
 }	/* print_exit_code() */
 
 
+/****************************************/
+/*					*/
+/*		compare_d99		*/
+/*					*/
+/****************************************/
+/* Qsort compare function for d99 addrs in 'host' byte swap order.
+ * The rec# is in the hi 3 bytes so they sort by rec#.
+ */
+static int	compare_d99 (const void *d1, const void *d2)
+{
+    DtSrUINT32	u1 = *(DB_ADDR *) d1;
+    DtSrUINT32	u2 = *(DB_ADDR *) d2;
+
+    if (u1 < u2)
+	return -1;
+    return (u1 > u2);
+} /* compare_d99() */
+
+
+/****************************************/
+/*					*/
+/*		compare_dbalist		*/
+/*					*/
+/****************************************/
+/* Qsort compare function for DBALIST pointers by rec# */
+static int	compare_dbalist (const void *d1, const void *d2)
+{
+    DB_ADDR	dba1 = (*(DBALIST **) d1)->dba;
+    DB_ADDR	dba2 = (*(DBALIST **) d2)->dba;
+
+    if (dba1 < dba2)
+	return -1;
+    return (dba1 > dba2);
+} /* compare_dbalist() */
+
+
+/****************************************/
+/*					*/
+/*		compare_wpdir		*/
+/*					*/
+/****************************************/
+/* Qsort/bsearch compare function for d96 directory entries */
+static int	compare_wpdir (const void *w1, const void *w2)
+{
+    return strcmp (((WPDIR *) w1)->word, ((WPDIR *) w2)->word);
+} /* compare_wpdir() */
+
+
+/****************************************/
+/*					*/
+/*		add_wpdir		*/
+/*					*/
+/****************************************/
+/* Adds a word and the offset of its block,
+ * ie the current end of the new d96, to the d96 directory.
+ */
+static void	add_wpdir (char *word)
+{
+    long	offset = ftell (wordpos_fp);
+
+    if (offset < 0L  ||  offset > 0x7fffffffL) {
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 777,
+	    "%s Write Failure d96 file: %s\n"),
+	    PROGNAME"1815", strerror (EFBIG));
+	DtSearchExit (13);
+    }
+    if (wpdir_count >= wpdir_size) {
+	wpdir_size = (wpdir_size)? wpdir_size * 2 : 4096;
+	if ((wpdir = realloc (wpdir, wpdir_size * sizeof(WPDIR))) == NULL) {
+	    printf (CATGETS(dtsearch_catd, MS_cborodin, 374, msg_374),
+		PROGNAME"1816");
+	    DtSearchExit (26);
+	}
+    }
+    wpdir [wpdir_count].word = austext_malloc (strlen (word) + 2,
+	PROGNAME"1817", NULL);
+    strcpy (wpdir [wpdir_count].word, word);
+    wpdir [wpdir_count].offset = (DtSrUINT32) offset;
+    wpdir_count++;
+    return;
+} /* add_wpdir() */
+
+
+/****************************************/
+/*					*/
+/*		write_wordpos		*/
+/*					*/
+/****************************************/
+/* Called from write_to_file() in Pass 2 when a d96 is being built.
+ * Appends the current word's block to the new d96 file:
+ * the positions of every rec in the word's dba list, merged
+ * by rec# with the positions of the other recs in the word's
+ * block of the old d96.  Recs in both are taken from the
+ * dba list because they were just reindexed.
+ */
+static void	write_wordpos (char *word, DBALIST *dba_list)
+{
+    static DBALIST	**newrecs = NULL;
+    DBALIST		*dbap;
+    DtSrUINT32		*oldblock, *oldposns;
+    DtSrUINT32		*recnos, *firsts, *posns;
+    DtSrINT32		oldcount, newcount, nrecs, count, rec;
+    DtSrINT32		o, n, r, i;
+    long		posct, size;
+
+    if (newrecs == NULL)
+	newrecs = austext_malloc (sizeof(DBALIST *) * batch_size + 16,
+	    PROGNAME"1811", NULL);
+
+    /* Sort the new recs by rec# and count their positions */
+    newcount = 0;
+    posct = 0L;
+    for (dbap = dba_list;  dbap != NULL;  dbap = dbap->next_dba) {
+	newrecs [newcount++] = dbap;
+	posct += dbap->w_c;
+    }
+    qsort (newrecs, (size_t)newcount, sizeof(DBALIST *), compare_dbalist);
+
+    /* Count the old recs that are kept */
+    nrecs = newcount;
+    oldcount = 0;
+    if ((oldblock = find_wordpos (&old_wordpos, word)) != NULL) {
+	oldcount = ntohl (oldblock[0]);
+	for (o = 0, n = 0;  o < oldcount;  o++) {
+	    rec = ntohl (oldblock [1 + o]);
+	    while (n < newcount  &&  newrecs[n]->dba < rec)
+		n++;
+	    if (n < newcount  &&  newrecs[n]->dba == rec)
+		continue;
+	    if ((count = find_wordpos_rec (oldblock, rec, &oldposns)) < 0)
+		continue;
+	    nrecs++;
+	    posct += count;
+	}
+    }
+
+    size = 2L + 2L * nrecs + 2L * posct;
+    if (size > posbufsz) {
+	if (posbuf)
+	    free (posbuf);
+	posbufsz = size + 1024;
+	posbuf = austext_malloc (posbufsz * sizeof(DtSrUINT32),
+	    PROGNAME"1812", NULL);
+    }
+    recnos = posbuf + 1;
+    firsts = recnos + nrecs;
+    posns = firsts + nrecs + 1;
+
+    /* Merge the old and new recs by rec# */
+    posct = 0L;
+    o = n = r = 0;
+    while (o < oldcount  ||  n < newcount) {
+	rec = (o < oldcount)? (DtSrINT32) ntohl (oldblock [1 + o]) : 0;
+	if (n < newcount  &&  (o >= oldcount  ||  newrecs[n]->dba <= rec)) {
+	    if (o < oldcount  &&  newrecs[n]->dba == rec)
+		o++;
+	    dbap = newrecs [n++];
+	    rec = dbap->dba;
+	    count = dbap->w_c;
+	    for (i = 0;  i < 2 * count;  i++)
+		posns [2 * posct + i] = htonl (dbap->posns [i]);
+	}
+	else {
+	    o++;
+	    if ((count = find_wordpos_rec (oldblock, rec, &oldposns)) < 0)
+		continue;
+	    memcpy (posns + 2 * posct, oldposns,
+		2 * count * sizeof(DtSrUINT32));
+	}
+	recnos [r] = htonl (rec);
+	firsts [r] = htonl (posct);
+	r++;
+	posct += count;
+    }
+    firsts [nrecs] = htonl (posct);
+    posbuf [0] = htonl (nrecs);
+
+    add_wpdir (word);
+    if (fwrite (posbuf, sizeof(DtSrUINT32), (size_t)size, wordpos_fp)
+	    != (size_t)size) {
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 777,
+	    "%s Write Failure d96 file: %s\n"),
+	    PROGNAME"1813", strerror(errno));
+	DtSearchExit (13);
+    }
+    return;
+} /* write_wordpos() */
+
+
 /****************************************/
 /*					*/
 /*	     write_to_file()		*/
@@ -320,7 +665,8 @@ static void     print_exit_code (int exit_code)
  * of times the token appears in that document.  This function
  * chains through the list, builds a statistical 'weight'
  * for each doc/word pair, and stores it as a reformatted 'dba'
- * in array 'record_addr_word[]', in 'host' byte swap order.
+ * in array 'record_addr_word[]', in 'host' byte swap order,
+ * sorted by rec# so the d99 addrs of every word ascend (ORD_SORTEDD99).
  * The count of the current number of addrs
  * in the array is stored in 'num_addrs_for_word'.
  * Fill_data1() is then called to update or write a new
@@ -393,20 +739,168 @@ void            write_to_file (TREENODE * output_node)
     }
     if ((debugging & DEBUG_T)  && !(debugging & DEBUG_t))
 	printf (" dbacnt=%ld\n", (long)num_addrs_for_word);
+    qsort (record_addr_word, (size_t)num_addrs_for_word, sizeof(DB_ADDR),
+	compare_d99);
 
     fill_data1 (output_node->word);
+    if (wordpos_fp)
+	write_wordpos (got_word.or_hwordkey, output_node->dba_list);
 
     return;
 } /* write_to_file() */
 
 
+/****************************************/
+/*					*/
+/*	     set_sorted_dbflag		*/
+/*					*/
+/****************************************/
+/* Called at the end of Pass 2 when the d99 file was created
+ * by this run.  Every word's d99 addrs are then in rec# order,
+ * and stay that way in later runs because new addrs are merged
+ * into the old ones.  Sets ORD_SORTEDD99 in the dbrec so
+ * the search engine can intersect d99 addrs of AND queries
+ * without loading a bit vector for every word.
+ */
+static void	set_sorted_dbflag (void)
+{
+    DtSrUINT32	dbflags;
+
+    RECFRST (PROGNAME "1801", OR_DBREC, 0);	/* seqtl retrieval */
+    if (db_status != S_OKAY)
+	vista_abort (PROGNAME "1802");
+    CRREAD (PROGNAME "1803", OR_DBFLAGS, &dbflags, 0);
+    dbflags = ntohl (dbflags) | ORD_SORTEDD99;
+    dbflags = htonl (dbflags);
+    CRWRITE (PROGNAME "1804", OR_DBFLAGS, &dbflags, 0);
+    return;
+} /* set_sorted_dbflag() */
+
+
+/****************************************/
+/*					*/
+/*		start_wordpos		*/
+/*					*/
+/****************************************/
+/* Called before Pass 1, after the d99 is opened.
+ * A d96 word positions file is built if requested with -p,
+ * or if the database already has one so that it stays current.
+ * The old d96 is mapped to be merged, unless the d99 is new,
+ * and the new d96 is written to a temp file.
+ */
+static void	start_wordpos (void)
+{
+    DtSrUINT32	hdr[4];
+
+    strcpy (wordpos_file, dicpath);
+    strcat (wordpos_file, dicname);
+    strcat (wordpos_file, EXT_WORDPOS);
+    strcpy (wordpos_temp, wordpos_file);
+    strcat (wordpos_temp, EXT_TEMP);
+
+    if (!open_wordpos (&old_wordpos, wordpos_file)  &&  !wordpos_wanted)
+	return;
+    if (new_dtbs_file)
+	close_wordpos (&old_wordpos);
+    if ((wordpos_fp = fopen (wordpos_temp, "wb")) == NULL) {
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 1069,
+	    "%s Cannot open new word positions file '%s': %s\n"),
+	    PROGNAME"1069", wordpos_temp, strerror(errno));
+	DtSearchExit (13);
+    }
+
+    /* Header is rewritten by finish_wordpos() */
+    memset (hdr, 0, sizeof(hdr));
+    fwrite (hdr, sizeof(hdr), (size_t)1, wordpos_fp);
+    return;
+} /* start_wordpos() */
+
+
+/****************************************/
+/*					*/
+/*		finish_wordpos		*/
+/*					*/
+/****************************************/
+/* Called after Pass 2.  Copies the blocks of old d96 words
+ * that weren't in this batch, writes the sorted directory
+ * and header, and replaces the old d96 with the new one.
+ */
+static void	finish_wordpos (void)
+{
+    DtSrUINT32	hdr[4];
+    DtSrUINT32	dirent[2];
+    DtSrUINT32	*block;
+    DtSrUINT32	offset, diroffs;
+    long	i, newcount;
+    size_t	size;
+    WPDIR	key;
+
+    newcount = wpdir_count;
+    qsort (wpdir, (size_t)newcount, sizeof(WPDIR), compare_wpdir);
+    for (i = 0;  i < (long) old_wordpos.wordcount;  i++) {
+	if ((offset = ntohl (old_wordpos.dir [2 * i])) >= old_wordpos.maplen)
+	    continue;
+	key.word = old_wordpos.map + offset;
+	if (bsearch (&key, wpdir, (size_t)newcount, sizeof(WPDIR),
+		compare_wpdir) != NULL)
+	    continue;
+	if ((block = find_wordpos (&old_wordpos, key.word)) == NULL)
+	    continue;
+	add_wpdir (key.word);
+	size = wordpos_size (block);
+	if (fwrite (block, sizeof(DtSrUINT32), size, wordpos_fp) != size)
+	    goto WRITE_ERROR;
+    }
+    qsort (wpdir, (size_t)wpdir_count, sizeof(WPDIR), compare_wpdir);
+
+    /* Directory, followed by the word strings it points to */
+    diroffs = (DtSrUINT32) ftell (wordpos_fp);
+    offset = diroffs + wpdir_count * sizeof(dirent);
+    for (i = 0;  i < wpdir_count;  i++) {
+	dirent[0] = htonl (offset);
+	dirent[1] = htonl (wpdir[i].offset);
+	if (fwrite (dirent, sizeof(dirent), (size_t)1, wordpos_fp) != 1)
+	    goto WRITE_ERROR;
+	offset += strlen (wpdir[i].word) + 1;
+    }
+    for (i = 0;  i < wpdir_count;  i++) {
+	size = strlen (wpdir[i].word) + 1;
+	if (fwrite (wpdir[i].word, 1, size, wordpos_fp) != size)
+	    goto WRITE_ERROR;
+    }
+
+    hdr[0] = htonl (WORDPOS_MAGIC);
+    hdr[1] = htonl ((DtSrUINT32) wpdir_count);
+    hdr[2] = htonl (diroffs);
+    hdr[3] = 0;
+    if (fseek (wordpos_fp, 0L, SEEK_SET) != 0  ||
+	    fwrite (hdr, sizeof(hdr), (size_t)1, wordpos_fp) != 1  ||
+	    fclose (wordpos_fp) != 0) {
+WRITE_ERROR:
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 777,
+	    "%s Write Failure d96 file: %s\n"),
+	    PROGNAME"1814", strerror(errno));
+	DtSearchExit (13);
+    }
+    wordpos_fp = NULL;
+    close_wordpos (&old_wordpos);
+    if (rename (wordpos_temp, wordpos_file) != 0) {
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 1069,
+	    "%s Cannot open new word positions file '%s': %s\n"),
+	    PROGNAME"1818", wordpos_file, strerror(errno));
+	DtSearchExit (13);
+    }
+    return;
+} /* finish_wordpos() */
+
+
 /****************************************/
 /*					*/
 /*	     descend_tree()		*/
 /*					*/
 /****************************************/
 /* Coroutine of traverse_tree(), Pass 2 Robson tree traversal.
- * The write_to_file() function is the 'preorder visit' point.
+ * The visit_node() function is the 'preorder visit' point.
  */
 void            descend_tree (void)
 {
@@ -414,7 +908,7 @@ void            descend_tree (void)
 
     while (not_done) {
 	if ((pres->llink == NULL) && (pres->rlink == NULL)) {
-	    write_to_file (pres);
+	    visit_node (pres);
 	    avail_node = pres;
 	    return;
 	}
@@ -425,7 +919,7 @@ void            descend_tree (void)
 	    pres = next;
 	}
 	else {
-	    write_to_file (pres);
+	    visit_node (pres);
 	    next = pres->rlink;
 	    pres->rlink = prev;
 	    prev = pres;
@@ -445,7 +939,8 @@ void            descend_tree (void)
  * of Pass 1's word-dba binary tree.
  * The algorithm is based on the J. M. ROBSON link inversion traversal
  * algorithm for binary trees. Ref. Thomas A. STANDISH  pp. 77-78.
- * The write_to_file() function is the 'preorder visit' point.
+ * The visit_node() function is the 'preorder visit' point:
+ * write_to_file() in Pass 2, write_run_node() in parser processes.
  */
 void            traverse_tree (void)
 {
@@ -473,7 +968,7 @@ void            traverse_tree (void)
 	    return;
 	}
 	if (prev->rlink == NULL) {
-	    write_to_file (prev);
+	    visit_node (prev);
 	    next = prev->llink;
 	    prev->llink = pres;
 	    pres = prev;
@@ -503,7 +998,7 @@ void            traverse_tree (void)
 		    descend = FALSE;
 		}
 		else {
-		    write_to_file (prev);
+		    visit_node (prev);
 		    avail_node->llink = stack;
 		    avail_node->rlink = top_of_stack;
 		    stack = avail_node;
@@ -540,11 +1035,15 @@ static void     print_usage_msg (void)
 "  -i<N>       Change (i)nput buffer size from default %d to <N>.\n"
 "  -h<N>       Change duplicate record id hash table size from %ld to <N>.\n"
 "              -h0 means there are no duplicates, do not check for them.\n"
+"  -p          Also write word positions file, used for collocations.\n"
+"              Once it exists, it is updated by every run.\n"
+"  -j<N>       Parse the text in <N> parallel processes.\n"
+"  -m<N>       With -j, change memory of each process from %ld MB to <N> MB.\n"
 "  <infile>    Input [path]file name.  Default extension %s.\n"),
 	aa_argv0,
 	(int) RECS_PER_DOT,
 	(long) BATCH_SIZE,  (long) CACHE_SIZE,
-	(int) INBUFSZ,  default_hashsize,  EXT_FZKEY);
+	(int) INBUFSZ,  default_hashsize,  (long) RUN_MBYTES,  EXT_FZKEY);
     return;
 } /* print_usage_msg() */
 
@@ -715,6 +1214,28 @@ CACHE_ADJUSTED:
 		}
 		break;
 
+	    case 'p':		/* build word (p)ositions d96 file */
+		wordpos_wanted = TRUE;
+		break;
+
+	    case 'j':		/* number of parser processes */
+		if ((parse_procs = atoi (argptr + 2)) <= 0) {
+		    printf (CATGETS(dtsearch_catd, MS_cborodin, 578,
+			"%s Invalid number of processes '%s'.\n"),
+			PROGNAME"578", argptr);
+		    goto BADPARM;
+		}
+		break;
+
+	    case 'm':		/* (m)emory of each parser process */
+		if ((run_mbytes = atol (argptr + 2)) <= 0L) {
+		    printf (CATGETS(dtsearch_catd, MS_cborodin, 579,
+			"%s Invalid memory size '%s'.\n"),
+			PROGNAME"579", argptr);
+		    goto BADPARM;
+		}
+		break;
+
 	    case 'i':		/* (I)nput buffer size */
 		if ((inbufsz = atol (argptr + 2)) <= 0) {
 		    printf (CATGETS(dtsearch_catd, MS_cborodin, 558,
@@ -774,9 +1295,11 @@ BADPARM:
  * prepared in a similar array of dbas, globally named
  * record_addr_word [num_addrs_for_word] but passed here as
  * 'addrs_array' and 'nitems'.
- * Both arrays will be byte swapped from 'host' to
- * 'network' order in this function.
- * This function does the actual fwrite of both arrays to the d99.
+ * Both arrays are in rec# order.  They are merged in place
+ * at the end of word_addrs_ii[], which has room for both,
+ * so the d99 addrs of the word remain sorted, and the merged
+ * array is byte swapped from 'host' to 'network' order.
+ * This function does the actual fwrite of the merged array to the d99.
  * If the number of new addrs can fit in the available free slots,
  * it rewrites to original offset, otherwise appends to end of d99.
  */
@@ -789,6 +1312,7 @@ static void	put_addrs_2_dtbs_addr_file (
     DtSrINT32		int32;
     DtSrINT32		num_writes;
     DtSrINT32		num_addrs;
+    DtSrINT32		i, j;
 
     if (nitems >= batch_size) {
 	printf ( CATGETS(dtsearch_catd, MS_cborodin, 6,
@@ -802,10 +1326,19 @@ static void	put_addrs_2_dtbs_addr_file (
 	**** num addrs in database by 1 (!?) ******/
 	/* (...only if prev 'overlay/compression' didn't delete all) */
 
-    /* Put both arrays in 'network' byte order */
-    for (int32 = 0;  int32 < nitems;  int32++)
-        HTONL (addrs_array[int32]);
-    for (int32 = 0;  int32 < num_addrs;  int32++)
+    /* Merge new addrs into old ones from the end backwards */
+    i = num_addrs - 1;
+    j = nitems - 1;
+    for (int32 = got_word.or_hwaddrs - 1;  j >= 0;  int32--) {
+	if (i >= 0  &&  (DtSrUINT32) word_addrs_ii[i] >
+		(DtSrUINT32) addrs_array[j])
+	    word_addrs_ii[int32] = word_addrs_ii[i--];
+	else
+	    word_addrs_ii[int32] = addrs_array[j--];
+    }
+
+    /* Put merged array in 'network' byte order */
+    for (int32 = 0;  int32 < got_word.or_hwaddrs;  int32++)
         HTONL (word_addrs_ii[int32]);
 
     /*
@@ -829,17 +1362,10 @@ static void	put_addrs_2_dtbs_addr_file (
 	    got_word.or_hwfree = free_slot->hole_size -
 		got_word.or_hwaddrs;
 	}
-	/*----- Write new database addresses to a file -----*/
-	num_writes = fwrite (addrs_array, sizeof(DB_ADDR),
-		(size_t)nitems, dtbs_addr_fp);
-	if (num_writes != nitems) {
-	    DtSearchExit (98);
-	}
-
-	/* Copy the old addresses immediately after the new ones */
-	num_writes = fwrite (word_addrs_ii, sizeof(DB_ADDR), (size_t)num_addrs,
-	    dtbs_addr_fp);
-	if (num_writes != num_addrs) {
+	/*----- Write merged database addresses to a file -----*/
+	num_writes = fwrite (word_addrs_ii, sizeof(DB_ADDR),
+	    (size_t)got_word.or_hwaddrs, dtbs_addr_fp);
+	if (num_writes != got_word.or_hwaddrs) {
 	    printf (CATGETS(dtsearch_catd, MS_cborodin, 776, msg_776),
 		PROGNAME"776", strerror(errno));
 	    DtSearchExit (76);
@@ -858,22 +1384,14 @@ static void	put_addrs_2_dtbs_addr_file (
     } /* end if (nitems > got_word.or_hwfree), had to get bigger slot */
 
     /* Else can reuse existing slot.
-     * Write the new addresses into free holes.
+     * Write the merged addresses over the old ones and free holes.
      * The remaining free holes should already have foxes. (?)
      */
     else {
 	fseek (dtbs_addr_fp, got_word.or_hwoffset, SEEK_SET);
-	num_writes = fwrite (addrs_array, sizeof(DB_ADDR),
-		(size_t)nitems, dtbs_addr_fp);
-	if (num_writes != nitems) {
-	    printf (CATGETS(dtsearch_catd, MS_cborodin, 776, msg_776),
-		PROGNAME"798", strerror(errno));
-	    DtSearchExit (87);
-	}
-	/* Copy the old addresses immediately after the new ones */
 	num_writes = fwrite (word_addrs_ii, sizeof(DB_ADDR),
-		(size_t)num_addrs, dtbs_addr_fp);
-	if (num_writes != num_addrs) {
+		(size_t)got_word.or_hwaddrs, dtbs_addr_fp);
+	if (num_writes != got_word.or_hwaddrs) {
 	    printf (CATGETS(dtsearch_catd, MS_cborodin, 776, msg_776),
 		PROGNAME"889", strerror(errno));
 	    DtSearchExit (89);
@@ -1224,6 +1742,106 @@ void            fill_data1 (char *node_word)
 }	/* fill_data1() */
 
 
+/************************************************/
+/*						*/
+/*		  save_position			*/
+/*						*/
+/************************************************/
+/* Pass 1 function when a d96 is being built.
+ * Saves offset and length of the token occurrence
+ * just counted in dbap->w_c, doubling the
+ * positions array as necessary.
+ */
+static void	save_position (DBALIST *dbap, long offset, int length)
+{
+    DtSrINT32	i = dbap->w_c - 1;	/* index of new position */
+
+    if (i == 0  ||  (i & (i - 1)) == 0) {
+	dbap->posns = realloc (dbap->posns,
+	    ((i)? 2 * i : 1) * 2 * sizeof(DtSrUINT32));
+	tree_bytes += ((i)? i : 1) * 2 * sizeof(DtSrUINT32);
+	if (dbap->posns == NULL) {
+	    printf (CATGETS(dtsearch_catd, MS_cborodin, 374, msg_374),
+		PROGNAME"1819");
+	    DtSearchExit (26);
+	}
+    }
+    dbap->posns [2 * i] = (DtSrUINT32) offset;
+    dbap->posns [2 * i + 1] = (DtSrUINT32) length;
+    return;
+} /* save_position() */
+
+
+/************************************************/
+/*						*/
+/*		   tree_alloc			*/
+/*						*/
+/************************************************/
+/* Returns memory for tree nodes and dba lists.
+ * They are never freed one at a time, so they're cut
+ * from large chunks, which is faster and packs them closer.
+ */
+static void	*tree_alloc (size_t size)
+{
+    char	*chunk;
+
+    size = (size + 7) & ~(size_t)7;
+    if (arena_used + size > ARENA_SIZE) {
+	chunk = austext_malloc (ARENA_SIZE, PROGNAME"1236", NULL);
+	*(char **) chunk = arena;	/* chunks are chained */
+	arena = chunk;
+	arena_used = 8;
+	tree_bytes += ARENA_SIZE;
+    }
+    chunk = arena + arena_used;
+    arena_used += size;
+    return chunk;
+} /* tree_alloc() */
+
+
+/************************************************/
+/*						*/
+/*		   hash_token			*/
+/*						*/
+/************************************************/
+/* Returns the node_hash bucket of passed token.
+ * The hash table is doubled when it has as many
+ * tree nodes as buckets.
+ */
+static TREENODE	**hash_token (char *token)
+{
+    TREENODE		**oldhash = node_hash;
+    size_t		oldsz = node_hashsz;
+    TREENODE		*node, *nextnode;
+    TREENODE		**bucket;
+    unsigned int	h;
+    UCHAR		*cptr;
+    size_t		i;
+
+    if ((size_t) num_of_diff_words >= node_hashsz) {
+	node_hashsz = (node_hashsz)? node_hashsz * 2 : 4096;
+	node_hash = austext_malloc (node_hashsz * sizeof(TREENODE *),
+	    PROGNAME"1237", NULL);
+	memset (node_hash, 0, node_hashsz * sizeof(TREENODE *));
+	for (i = 0;  i < oldsz;  i++) {
+	    for (node = oldhash[i];  node != NULL;  node = nextnode) {
+		nextnode = node->hlink;
+		bucket = hash_token (node->word);
+		node->hlink = *bucket;
+		*bucket = node;
+	    }
+	}
+	if (oldhash)
+	    free (oldhash);
+    }
+
+    h = 2166136261u;
+    for (cptr = (UCHAR *) token;  *cptr != 0;  cptr++)
+	h = (h ^ *cptr) * 16777619u;
+    return &node_hash [h & (node_hashsz - 1)];
+} /* hash_token() */
+
+
 /************************************************/
 /*						*/
 /*		load_into_bintree		*/
@@ -1233,6 +1851,8 @@ void            fill_data1 (char *node_word)
  * Loads parsed word token or stem token into
  * inverted index binary tree along with passed dba.
  * Token is allowed to be empty, ie first byte is \0.
+ * The offset and length of the word in the text
+ * are saved for the d96 file if one is being built.
  * Derived from Efim's original 'teskey_parse()'
  * and bin_tree() functions.
  * Variables static for speeeeeeed.
@@ -1240,12 +1860,16 @@ void            fill_data1 (char *node_word)
 static void	load_into_bintree (
 			char	*parser_token,
 			int	token_is_stem,
-			DB_ADDR	dba)
+			DB_ADDR	dba,
+			long	offset,
+			int	length)
 {
     static DtSrINT16	or_maxwordsz;
     static char		*cptr;
     static int		i;
     static TREENODE	**this_link;
+    static TREENODE	**bucket;
+    static TREENODE	*node;
     static TREENODE	*newnode;
     static DBALIST	*newdba;
     static char		*tokbuf =	NULL;
@@ -1277,43 +1901,48 @@ static void	load_into_bintree (
     if (debugging & DEBUG_I)
 	printf (" bintr='%s' dba=%ld ", displayable(tokbuf), (long)dba);
 
-    /* TREE TRAVERSAL.  Search binary tree to find either
-     * insertion point or identical preexisting token.
+    /* HASH SEARCH.  Almost every token is already in the tree,
+     * so preexisting tokens are found through the hash index
+     * of the tree nodes instead of by searching the tree.
      */
-    for (this_link = &root_node; *this_link != NULL; ) {
-	i = strcmp (tokbuf, (*this_link)->word);
+    bucket = hash_token (tokbuf);
+    for (node = *bucket;  node != NULL;  node = node->hlink) {
+	if (strcmp (tokbuf, node->word) != 0)
+	    continue;
 
-	/* If identical word/stem token already exists... */
-	if (i == 0) {
-	    /* If token appears more than once in current
-	     * document (dba already exists at top of dba list),
-	     * just increment the word count in the list.
-	     */
-	    if ((*this_link)->dba_list->dba == dba)
-		(*this_link)->dba_list->w_c++;
-		
-	    /* If this is first appearance of token for this doc
-	     * (dba is not at start of token's dba list),
-	     * insert dba at start of token's dba list.
-	     */
-	    else {
-		if ((newdba = malloc (sizeof(DBALIST))) == NULL) {
-		    printf (CATGETS(dtsearch_catd, MS_cborodin, 374,
-			msg_374), PROGNAME"1150");
-		    DtSearchExit (26);
-		}
-		newdba->dba =		  dba;
-		newdba->w_c =		  1;
-		newdba->next_dba =	  (*this_link)->dba_list;
-		(*this_link)->dba_list =  newdba;
-	    }
-	    if (debugging & DEBUG_I)
-		printf (" Old %ld=%ld\n",
-		    (long)((*this_link)->dba_list->dba),
-		    (long)((*this_link)->dba_list->w_c));
-	    return;	/* done with token */
+	/* If token appears more than once in current
+	 * document (dba already exists at top of dba list),
+	 * just increment the word count in the list.
+	 */
+	if (node->dba_list->dba == dba)
+	    node->dba_list->w_c++;
 
-	} /* endif where token was found in binary tree */
+	/* If this is first appearance of token for this doc
+	 * (dba is not at start of token's dba list),
+	 * insert dba at start of token's dba list.
+	 */
+	else {
+	    newdba = tree_alloc (sizeof(DBALIST));
+	    newdba->dba =	dba;
+	    newdba->w_c =	1;
+	    newdba->next_dba =	node->dba_list;
+	    newdba->posns =	NULL;
+	    node->dba_list =	newdba;
+	}
+	if (wordpos_fp)
+	    save_position (node->dba_list, offset, length);
+	if (debugging & DEBUG_I)
+	    printf (" Old %ld=%ld\n",
+		(long)(node->dba_list->dba),
+		(long)(node->dba_list->w_c));
+	return;	/* done with token */
+    }
+
+    /* TREE TRAVERSAL.  Search binary tree
+     * to find insertion point of new token.
+     */
+    for (this_link = &root_node; *this_link != NULL; ) {
+	i = strcmp (tokbuf, (*this_link)->word);
 
 	/* Increment link ptr by descending to correct subtree */
 	if (i < 0) {
@@ -1328,24 +1957,27 @@ static void	load_into_bintree (
 	}
     } /* end tree traversal */
 
-    /* Tree traversal never found a preexisting token node.
-     * Create a new node and insert it at the point
-     * indicated by link ptr.
+    /* Create a new node and insert it at the point
+     * indicated by link ptr, and in the hash index.
      */
-    newnode = austext_malloc (sizeof(TREENODE) + strlen(tokbuf) + 4,
-	PROGNAME"1234", NULL);
+    newnode = tree_alloc (sizeof(TREENODE) + strlen(tokbuf) + 4);
     newnode->llink =	NULL;
     newnode->rlink =	NULL;
     newnode->word = (char *) (newnode + 1);	/* use mem at end of node */
     strcpy (newnode->word, tokbuf);
 
-    newdba = austext_malloc (sizeof(DBALIST), PROGNAME"1235", NULL);
+    newdba = tree_alloc (sizeof(DBALIST));
     newnode->dba_list =	newdba;
     newdba->dba =	dba;
     newdba->w_c =	1;
     newdba->next_dba =	NULL;
+    newdba->posns =	NULL;
+    if (wordpos_fp)
+	save_position (newdba, offset, length);
 
     *this_link =	newnode;
+    newnode->hlink =	*bucket;
+    *bucket =		newnode;
     num_of_diff_words++;
 
     if (debugging & DEBUG_I)
@@ -1356,6 +1988,525 @@ static void	load_into_bintree (
 } /* load_into_bintree() */
 
 
+/************************************************/
+/*						*/
+/*		  parse_record			*/
+/*						*/
+/************************************************/
+/* Pass 1 function.  Parses the text of one record,
+ * from the current position of parg.ftext to ETX,
+ * and loads every word and its stem into the binary tree.
+ */
+static void	parse_record (DB_ADDR dba)
+{
+    char	*cptr;
+    int		i;
+    int		wordlen;
+
+    for (	cptr = dblk.parser (&parg);
+		cptr;
+		cptr = dblk.parser (NULL)) {
+
+	if (debugging & DEBUG_P) {
+	    printf ("%6ld %s %n", *parg.offsetp, cptr, &i);
+	    if (!(debugging & DEBUG_I))
+		while (i++ < 30)
+		    putchar (' ');
+	}
+	wordlen = strlen (cptr);
+	load_into_bintree (cptr, FALSE, dba, *parg.offsetp, wordlen);
+	cptr = dblk.stemmer (cptr, &dblk);
+	if (debugging & DEBUG_P) {
+	    printf ("%s\n", cptr);
+	    fflush (stdout);
+	}
+	load_into_bintree (cptr, TRUE, dba, *parg.offsetp, wordlen);
+    }
+    return;
+} /* parse_record() */
+
+
+/****************************************/
+/*					*/
+/*		write_run_node		*/
+/*					*/
+/****************************************/
+/* The 'visit node' point of the tree traversal when
+ * a parser process writes its tree to a run file.
+ * Writes the token, the number of dbas, the rec# and
+ * word count of each dba, and if a d96 is being built,
+ * the positions of each dba.
+ * Run files are temporary so they are in 'host' byte order.
+ * Write errors are tested when the run file is closed.
+ */
+static void	write_run_node (TREENODE *node)
+{
+    static DtSrINT32	*runbuf =	NULL;
+    static long		runbufsz =	0L;
+    DBALIST		*dbap;
+    DtSrINT32		len = strlen (node->word);
+    long		count = 0L;
+
+    /* Count, then rec# and word count of each dba */
+    for (dbap = node->dba_list;  dbap != NULL;  dbap = dbap->next_dba) {
+	if (2 * count + 3 > runbufsz) {
+	    runbufsz = (runbufsz)? 2 * runbufsz : 4096;
+	    if ((runbuf = realloc (runbuf,
+		    runbufsz * sizeof(DtSrINT32))) == NULL) {
+		printf (CATGETS(dtsearch_catd, MS_cborodin, 374, msg_374),
+		    PROGNAME"1238");
+		DtSearchExit (26);
+	    }
+	}
+	runbuf [2 * count + 1] = dbap->dba;
+	runbuf [2 * count + 2] = dbap->w_c;
+	count++;
+    }
+    runbuf[0] = count;
+    fwrite (&len, sizeof(DtSrINT32), (size_t)1, run_fp);
+    fwrite (node->word, (size_t)1, (size_t)len, run_fp);
+    fwrite (runbuf, sizeof(DtSrINT32), (size_t)(2 * count + 1), run_fp);
+    if (wordpos_fp)
+	for (dbap = node->dba_list;  dbap != NULL;  dbap = dbap->next_dba)
+	    fwrite (dbap->posns, sizeof(DtSrUINT32),
+		2 * (size_t)dbap->w_c, run_fp);
+    return;
+} /* write_run_node() */
+
+
+/****************************************/
+/*					*/
+/*		  free_tree		*/
+/*					*/
+/****************************************/
+/* Frees the binary tree and its dba lists after
+ * a parser process has written it to a run file.
+ */
+static void	free_tree (void)
+{
+    TREENODE	*node;
+    DBALIST	*dbap;
+    char	*chunk;
+    size_t	h;
+
+    for (h = 0;  h < node_hashsz;  h++) {
+	for (node = node_hash[h];  node != NULL;  node = node->hlink)
+	    for (dbap = node->dba_list;  dbap != NULL;  dbap = dbap->next_dba)
+		if (dbap->posns)
+		    free (dbap->posns);
+	node_hash[h] = NULL;
+    }
+    while ((chunk = arena) != NULL) {
+	arena = *(char **) chunk;
+	free (chunk);
+    }
+    arena_used = ARENA_SIZE;
+    root_node = NULL;
+    tree_bytes = 0;
+    return;
+} /* free_tree() */
+
+
+/****************************************/
+/*					*/
+/*		  write_run		*/
+/*					*/
+/****************************************/
+/* Called in parser process procno when its tree holds
+ * too much memory, and at the end of its records.
+ * Writes the tree in token order to the next run file
+ * of the process and frees it.
+ */
+static void	write_run (int procno)
+{
+    char	runfile [_POSIX_PATH_MAX + 32];
+
+    if (root_node == NULL)
+	return;
+    sprintf (runfile, RUNFILE_FMT,
+	dicpath, dicname, procno, procstat[procno].runs);
+    if ((run_fp = fopen (runfile, "wb")) == NULL)
+	goto WRITE_ERROR;
+    procstat[procno].runs++;	/* so it's removed if we abort */
+    visit_node = write_run_node;
+    traverse_tree ();
+    if (ferror (run_fp)  ||  fclose (run_fp) != 0) {
+WRITE_ERROR:
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 1112,
+	    "%s Cannot write temporary run file '%s': %s\n"),
+	    PROGNAME"1112", runfile, strerror(errno));
+	DtSearchExit (13);
+    }
+    run_fp = NULL;
+    num_of_diff_words = 0L;
+    free_tree ();
+    return;
+} /* write_run() */
+
+
+/****************************************/
+/*					*/
+/*		 parse_slice		*/
+/*					*/
+/****************************************/
+/* Body of parser process procno, a child of the main process.
+ * Parses records pass1recs [first] up to [last] through its
+ * own stream on the .fzk file.  Its tree is written to a run
+ * file whenever it holds more than run_mbytes of memory,
+ * so memory stays bounded however large the batch is.
+ * Never returns.
+ */
+static void	parse_slice (int procno, long first, long last)
+{
+    long	r;
+
+    /* The database and the main process's streams aren't ours */
+    austext_exit_dbms = NULL;
+    austext_exit_last = NULL;
+    if ((instream = fopen (fname_input, "rt")) == NULL) {
+BAD_INPUT_FILE:
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 1083,
+	    "%s Can't read input file '%s': %s\n"),
+	    PROGNAME"1471", fname_input, strerror(errno));
+	DtSearchExit (14);
+    }
+    parg.ftext = instream;
+
+    for (r = first;  r < last;  r++) {
+	if (shutdown_now)
+	    DtSearchExit (11);
+	if (fseek (instream, pass1recs[r].offset, SEEK_SET) != 0)
+	    goto BAD_INPUT_FILE;
+	parse_record (pass1recs[r].dba);
+	if (tree_bytes >= (size_t) run_mbytes << 20)
+	    write_run (procno);
+    }
+    write_run (procno);
+    fflush (stdout);
+    _exit (0);
+} /* parse_slice() */
+
+
+/****************************************/
+/*					*/
+/*		   bad_run		*/
+/*					*/
+/****************************************/
+/* Aborts on a read error or invalid data in a run file */
+static void	bad_run (RUNFILE *run)
+{
+    printf (CATGETS(dtsearch_catd, MS_cborodin, 1113,
+	"%s Cannot read temporary run file '%s': %s\n"),
+	PROGNAME"1113", run->fname,
+	strerror ((ferror (run->fp))? errno : EINVAL));
+    DtSearchExit (13);
+} /* bad_run() */
+
+
+/****************************************/
+/*					*/
+/*		  fread_run		*/
+/*					*/
+/****************************************/
+/* Freads from a run file.  Short reads are errors
+ * because the file was written by this program.
+ */
+static void	fread_run (void *ptr, size_t size, size_t nitems, RUNFILE *run)
+{
+    if (fread (ptr, size, nitems, run->fp) != nitems)
+	bad_run (run);
+    return;
+} /* fread_run() */
+
+
+/****************************************/
+/*					*/
+/*		read_run_word		*/
+/*					*/
+/****************************************/
+/* Reads the token of the next node of the run file into
+ * run->word, or closes it and sets run->fp NULL at its end.
+ */
+static void	read_run_word (RUNFILE *run)
+{
+    DtSrINT32	len;
+
+    if (fread (&len, sizeof(DtSrINT32), (size_t)1, run->fp) != 1) {
+	if (ferror (run->fp))
+	    bad_run (run);
+	fclose (run->fp);
+	run->fp = NULL;
+	return;
+    }
+    if (len <= 0  ||  len > dblk.dbrec.or_maxwordsz)
+	bad_run (run);
+    fread_run (run->word, (size_t)1, (size_t)len, run);
+    run->word [len] = 0;
+    return;
+} /* read_run_word() */
+
+
+/****************************************/
+/*					*/
+/*		read_run_dbas		*/
+/*					*/
+/****************************************/
+/* Reads the dbas of the current node of the run file,
+ * after its token, and appends them to merge_dbas.
+ */
+static void	read_run_dbas (RUNFILE *run)
+{
+    DtSrINT32	count;
+    DtSrINT32	pair[2];
+    DBALIST	*dbap;
+    long	i, first;
+
+    fread_run (&count, sizeof(DtSrINT32), (size_t)1, run);
+    if (count < 1  ||  merge_count + count > batch_size)
+	bad_run (run);
+    first = merge_count;
+    for (i = 0;  i < count;  i++) {
+	fread_run (pair, sizeof(DtSrINT32), (size_t)2, run);
+	dbap = &merge_dbas [merge_count++];
+	dbap->dba = pair[0];
+	dbap->w_c = pair[1];
+	dbap->posns = NULL;
+	if (dbap->dba < 1  ||  dbap->dba > or_maxdba  ||  dbap->w_c < 1)
+	    bad_run (run);
+    }
+    if (wordpos_fp) {
+	for (i = first;  i < merge_count;  i++) {
+	    dbap = &merge_dbas[i];
+	    dbap->posns = austext_malloc (
+		2 * sizeof(DtSrUINT32) * dbap->w_c, PROGNAME"1476", NULL);
+	    fread_run (dbap->posns, sizeof(DtSrUINT32),
+		2 * (size_t)dbap->w_c, run);
+	}
+    }
+    return;
+} /* read_run_dbas() */
+
+
+/****************************************/
+/*					*/
+/*		skip_run_dbas		*/
+/*					*/
+/****************************************/
+/* Skips the dbas of the current node of the run file,
+ * after its token, when the runs are only being counted.
+ */
+static void	skip_run_dbas (RUNFILE *run)
+{
+    DtSrINT32	count;
+    DtSrINT32	pair[2];
+    long	i;
+
+    fread_run (&count, sizeof(DtSrINT32), (size_t)1, run);
+    if (count < 1  ||  count > batch_size)
+	bad_run (run);
+    if (wordpos_fp == NULL) {
+	if (fseek (run->fp, 2L * sizeof(DtSrINT32) * count, SEEK_CUR) != 0)
+	    bad_run (run);
+	return;
+    }
+    for (i = 0;  i < count;  i++) {
+	fread_run (pair, sizeof(DtSrINT32), (size_t)2, run);
+	if (pair[1] < 1)
+	    bad_run (run);
+	if (fseek (run->fp, 2L * sizeof(DtSrUINT32) * pair[1], SEEK_CUR) != 0)
+	    bad_run (run);
+    }
+    return;
+} /* skip_run_dbas() */
+
+
+/****************************************/
+/*					*/
+/*		  merge_runs		*/
+/*					*/
+/****************************************/
+/* Pass 2 with -j, instead of traverse_tree().
+ * Merges the sorted run files of all parser processes,
+ * passing each token with the dbas of every run that has it
+ * to write_to_file(), in the same order as the traversal.
+ * There are only a few runs, so the next token is
+ * found by a linear scan of them.
+ * If count_only, the dbas are skipped and the runs are kept,
+ * to count the distinct words at the end of Pass 1.
+ * Returns the number of distinct words merged.
+ */
+static long	merge_runs (int count_only)
+{
+    RUNFILE	*runs, *low;
+    TREENODE	node;
+    long	i;
+    long	words = 0L;
+    int		nruns = 0;
+    int		procno, run, r;
+
+    for (procno = 0;  procno < parse_procs;  procno++)
+	nruns += procstat[procno].runs;
+    if (nruns == 0) {
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 288,
+	    "%s Abort. There are no words in the input file %s.\n"),
+	    PROGNAME"1477", fname_input);
+	DtSearchExit (34);
+    }
+
+    runs = austext_malloc (sizeof(RUNFILE) * nruns, PROGNAME"1478", NULL);
+    r = 0;
+    for (procno = 0;  procno < parse_procs;  procno++) {
+	for (run = 0;  run < procstat[procno].runs;  run++, r++) {
+	    sprintf (runs[r].fname, RUNFILE_FMT,
+		dicpath, dicname, procno, run);
+	    runs[r].word = austext_malloc (
+		(size_t) dblk.dbrec.or_maxwordsz + 4, PROGNAME"1479", NULL);
+	    if ((runs[r].fp = fopen (runs[r].fname, "rb")) == NULL) {
+		printf (CATGETS(dtsearch_catd, MS_cborodin, 1113,
+		    "%s Cannot read temporary run file '%s': %s\n"),
+		    PROGNAME"1480", runs[r].fname, strerror(errno));
+		DtSearchExit (13);
+	    }
+	    read_run_word (&runs[r]);
+	}
+    }
+
+    /* A token can't have more dbas than the batch has records */
+    if (!count_only)
+	merge_dbas = austext_malloc (sizeof(DBALIST) * batch_size + 16,
+	    PROGNAME"1481", NULL);
+    memset (&node, 0, sizeof(TREENODE));
+    node.word = austext_malloc ((size_t) dblk.dbrec.or_maxwordsz + 4,
+	PROGNAME"1482", NULL);
+    for (;;) {
+	low = NULL;
+	for (r = 0;  r < nruns;  r++) {
+	    if (runs[r].fp == NULL)
+		continue;
+	    if (low == NULL  ||  strcmp (runs[r].word, low->word) < 0)
+		low = &runs[r];
+	}
+	if (low == NULL)
+	    break;
+	strcpy (node.word, low->word);
+	merge_count = 0L;
+	for (r = 0;  r < nruns;  r++) {
+	    if (runs[r].fp == NULL  ||  strcmp (runs[r].word, node.word) != 0)
+		continue;
+	    if (count_only)
+		skip_run_dbas (&runs[r]);
+	    else
+		read_run_dbas (&runs[r]);
+	    read_run_word (&runs[r]);
+	}
+	words++;
+	if (count_only)
+	    continue;
+
+	/* Link the dbas into the node's dba list */
+	node.dba_list = NULL;
+	for (i = merge_count - 1;  i >= 0;  i--) {
+	    merge_dbas[i].next_dba = node.dba_list;
+	    node.dba_list = &merge_dbas[i];
+	}
+	write_to_file (&node);
+	for (i = 0;  i < merge_count;  i++)
+	    if (merge_dbas[i].posns)
+		free (merge_dbas[i].posns);
+    }
+
+    for (r = 0;  r < nruns;  r++)
+	free (runs[r].word);
+    free (runs);
+    free (node.word);
+    if (count_only)
+	return words;
+    free (merge_dbas);
+    merge_dbas = NULL;
+    remove_runs ();
+    return words;
+} /* merge_runs() */
+
+
+/****************************************/
+/*					*/
+/*		 run_parsers		*/
+/*					*/
+/****************************************/
+/* End of Pass 1 with -j.  Divides the records found by
+ * the main process into contiguous slices, parses each
+ * in its own parser process, and waits for all of them.
+ * Processes are used rather than threads because the
+ * parsers and stemmers keep their state in statics.
+ * Every record is in one slice only, so the processes can
+ * count the words of their records directly in dbas_word_count,
+ * which like procstat is shared with the main process.
+ */
+static void	run_parsers (void)
+{
+    int		procno, nprocs;
+    int		status, failed = 0;
+    pid_t	pid;
+
+    procstat = mmap (NULL, sizeof(PROCSTAT) * parse_procs,
+	PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (procstat == MAP_FAILED) {
+	procstat = NULL;
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 374, msg_374),
+	    PROGNAME"1473");
+	DtSearchExit (26);
+    }
+    nprocs = (pass1count < parse_procs)? (int) pass1count : parse_procs;
+    if (dotcount > 0) {
+	putchar ('\n');
+	dotcount = 0;
+    }
+    printf (CATGETS(dtsearch_catd, MS_cborodin, 1109,
+	"%s: Parsing %ld records in %d processes.\n"),
+	aa_argv0, pass1count, nprocs);
+
+    /* Children must not flush copies of our buffers */
+    fflush (NULL);
+    for (procno = 0;  procno < nprocs;  procno++) {
+	if ((pid = fork ()) == -1) {
+	    printf (CATGETS(dtsearch_catd, MS_cborodin, 1110,
+		"%s Cannot start parser process: %s\n"),
+		PROGNAME"1110", strerror(errno));
+	    failed = 12;
+	    break;
+	}
+	if (pid == 0)
+	    parse_slice (procno,
+		pass1count * procno / nprocs,
+		pass1count * (procno + 1) / nprocs);
+    }
+
+    /* Wait for all started processes, even after a failure,
+     * so none is still writing run files when they're removed.
+     */
+    while ((pid = wait (&status)) != -1  ||  errno == EINTR) {
+	if (pid == -1)
+	    continue;
+	if (WIFEXITED (status)  &&  WEXITSTATUS (status) == 0)
+	    continue;
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 1111,
+	    "%s Parser process %ld failed, exit code %d.\n"),
+	    PROGNAME"1111", (long) pid,
+	    (WIFEXITED (status))? WEXITSTATUS (status) : -1);
+	if (!failed)
+	    failed = (WIFEXITED (status))? WEXITSTATUS (status) : 11;
+    }
+    if (failed)
+	DtSearchExit (failed);
+
+    /* A word is in every run that has it, so the distinct
+     * words are only known after merging the runs.
+     */
+    num_of_diff_words = merge_runs (TRUE);
+    return;
+} /* run_parsers() */
+
+
 /**********************************************/
 /*                                            */
 /*                    MAIN                    */
@@ -1377,6 +2528,8 @@ main (int argc, char **argv)
     struct tm		*tmptr;
     DB_ADDR		dba, temp_dba;
     time_t		elapsed;
+    struct timeval	tv_end;
+    double		seconds;
     size_t		mallocsz;
     char		*parsebufp, *stembufp;
 
@@ -1458,17 +2611,31 @@ main (int argc, char **argv)
     /* Allocate memory space for the arrays.
      * dbas_bits_batch = 'bit vector', one bit for every possible rec#.
      *   the 1 bits = only the dba's that are in this fzk batch.
-     * word_addrs_ii = fread buffer for d99 file.
+     * word_addrs_ii = fread buffer for d99 file, with room
+     *   to merge in the addrs of one batch.
      * dbas_word_count = summing bkts for word count statistics.
      */
     dbas_bits_batch = (char *) austext_malloc ((size_t)bit_vector_size + 48,
 	PROGNAME "1150", NULL);
     word_addrs_ii = (DB_ADDR *) austext_malloc (
-	sizeof (DB_ADDR) * (or_reccount + 1) + 48,
+	sizeof (DB_ADDR) * (or_reccount + batch_size + 1) + 48,
 	PROGNAME "1152", NULL);
     mallocsz = sizeof(DtSrINT32) * (or_maxdba + 1) + 48;
-    dbas_word_count = (DtSrINT32 *) austext_malloc (mallocsz,
-	PROGNAME "1154", NULL);
+    if (parse_procs > 0) {
+	/* Word counts are summed by the parser processes */
+	dbas_word_count = mmap (NULL, mallocsz, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (dbas_word_count == MAP_FAILED) {
+	    printf (CATGETS(dtsearch_catd, MS_cborodin, 374, msg_374),
+		PROGNAME"1155");
+	    DtSearchExit (26);
+	}
+	pass1recs = austext_malloc (sizeof(PASS1REC) * batch_size + 16,
+	    PROGNAME"1156", NULL);
+    }
+    else
+	dbas_word_count = (DtSrINT32 *) austext_malloc (mallocsz,
+	    PROGNAME "1154", NULL);
     memset (dbas_bits_batch, 0, (size_t)bit_vector_size + 48);
     memset (dbas_word_count, 0, mallocsz);
 
@@ -1502,6 +2669,7 @@ main (int argc, char **argv)
 	    DtSearchExit (13);
 	}
     }
+    start_wordpos ();
 
     /* open input .fzk file */
     src = getcwd (sprintbuffer, _POSIX_PATH_MAX);
@@ -1526,6 +2694,7 @@ BAD_INPUT_FILE:
     parg.ftext = instream;	/* for readchar_ftext(), discard_to_ETX() */
 
     time (&totalstart);		/* for total elapsed time */
+    gettimeofday (&tv_start, NULL);
     timestart = totalstart;	/* for Pass 1 elapsed time */
 
     /*------------ PASS 1:  ------------
@@ -1707,12 +2876,25 @@ INVALID_FZK_FORMAT:
 	    goto INVALID_FZK_FORMAT;
 	inbuf[inbufsz] = 0;	/* just to be sure */
 
+	/* With -j the text is parsed later by the parser processes.
+	 * The batch size is tested before they are started.
+	 */
+	if (parse_procs > 0) {
+	    if (pass1count < batch_size) {
+		pass1recs[pass1count].offset = ftell (instream);
+		pass1recs[pass1count].dba = dba;
+		pass1count++;
+	    }
+	    discard_to_ETX (&parg);
+	    continue;
+	}
+
 	/* PARSE LOOP FOR CURRENT TEXT BLOCK.
 	 * We must be in the middle of a record ('lines' #5 and beyond).
 	 * From here to ETX, which is either the record delimiter string
 	 * or the end of file, read the file a 'word' at a time
 	 * using the parse() function for the language specified
-	 * for the database.
+	 * for the database (see parse_record()).
 	 * Load_into_bintree() stores each token into
 	 * inverted index binary tree.
 	 * Note: dba here MUST still be rec#, base 1.
@@ -1723,27 +2905,13 @@ INVALID_FZK_FORMAT:
 	    printf ("\nRecord #%lu '%s'\n"
 		    "Offset Word----               Stem----\n",
 		record_count, db_key);
-	for (	cptr = dblk.parser (&parg);
-		cptr;
-		cptr = dblk.parser (NULL)) {
-
-	    if (debugging & DEBUG_P) {
-		printf ("%6ld %s %n", word_offset, cptr, &i);
-		if (!(debugging & DEBUG_I))
-		    while (i++ < 30)
-			putchar (' ');
-	    }
-	    load_into_bintree (cptr, FALSE, dba);
-	    cptr = dblk.stemmer (cptr, &dblk);
-	    if (debugging & DEBUG_P) {
-		printf ("%s\n", cptr);
-		fflush (stdout);
-	    }
-	    load_into_bintree (cptr, TRUE, dba);
-	}
+	parse_record (dba);
 
     } /* end of PASS 1 Main read loop */
 
+    if (parse_procs > 0  &&  record_count <= batch_size)
+	run_parsers ();
+
     elapsed = time(NULL) - timestart;
     if (dotcount > 0) {
 	putchar ('\n');
@@ -1783,11 +2951,18 @@ INVALID_FZK_FORMAT:
 	aa_argv0, words_per_dot);
     dotcount = 0;
     time (&timestart);
-    traverse_tree (); 	/* actual Pass 2 */
+    if (parse_procs > 0)
+	num_of_diff_words = merge_runs (FALSE);
+    else {
+	visit_node = write_to_file;
+	traverse_tree (); 	/* actual Pass 2 */
+    }
     if (dotcount) {
 	putchar ('\n');
 	dotcount = 0;
     }
+    if (wordpos_fp)
+	finish_wordpos ();
 
     /* Write header information to the d99 file */
     if (!fwrite_d99_header (&fl_hdr, dtbs_addr_fp)) {
@@ -1795,6 +2970,9 @@ INVALID_FZK_FORMAT:
 	    PROGNAME"1723", strerror(errno));
 	DtSearchExit (13);
     }
+    /* A d99 written entirely by this program is sorted */
+    if (new_dtbs_file)
+	set_sorted_dbflag();
     d_close ();
     fclose (dtbs_addr_fp);
 
@@ -1802,6 +2980,14 @@ INVALID_FZK_FORMAT:
     printf (CATGETS(dtsearch_catd, MS_cborodin, 1246,
 	"%s: Pass 2 completed in %lum %lus, updated %lu words.\n"),
 	aa_argv0, elapsed / 60L, elapsed % 60L, count_word_ii);
+    gettimeofday (&tv_end, NULL);
+    seconds = (tv_end.tv_sec - tv_start.tv_sec) +
+	(tv_end.tv_usec - tv_start.tv_usec) / 1000000.;
+    if (seconds > 0.)
+	printf (CATGETS(dtsearch_catd, MS_cborodin, 1247,
+	    "%s: Indexed %lu records in %.1f seconds, "
+	    "%.0f records per second.\n"),
+	    aa_argv0, record_count, seconds, record_count / seconds);
     if (normal_retncode == 1)
 	printf (CATGETS(dtsearch_catd, MS_cborodin, 2,
 	    "%s: Warnings were detected.\n"), aa_argv0);
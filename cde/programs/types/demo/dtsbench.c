@@ -0,0 +1,258 @@
+/*
+ * CDE - Common Desktop Environment
+ *
+ * Copyright (c) 1993-2012, The Open Group. All rights reserved.
+ *
+ * These libraries and programs are free software; you can
+ * redistribute them and/or modify them under the terms of the GNU
+ * Lesser General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * These libraries and programs are distributed in the hope that
+ * they will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with these libraries and programs; if not, write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA
+ */
+/****************************************************************************/
+/*****************************************************************************
+ **
+ **   File:         dtsbench.c
+ **
+ **   Description:  Times the Data Typing API on synthetic file names.
+ **
+ **		    The paths are made up from a set of directories,
+ **		    names and suffixes, and each comes with a made up
+ **		    stat buffer and a few bytes of content, so that
+ **		    no file is opened and only the matching of the
+ **		    data criteria is timed.  The count of each data
+ **		    type found is printed as well; with the same seed
+ **		    it must not change from one build to the next.
+ **
+ **   		    The usage for dtsbench is:
+ **
+ **		    Usage: dtsbench [ count [ seed ] ]
+ **
+ ****************************************************************************
+ ************************************<+>*************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <Xm/Xm.h>
+#include <Dt/Dt.h>
+#include <Dt/Dts.h>
+#include <Dt/DbUtil.h>
+
+#define MAX_TYPES	512
+
+static char *dirs[] = {
+	"/usr/dt/appconfig/types/C", "/home/user", "/home/user/src",
+	"/home/user/doc", "/tmp", "/usr/include", "/usr/share/pixmaps",
+	"/var/spool/mail", "/opt/project/lib", "/etc"
+};
+
+static char *names[] = {
+	"main", "util", "README", "Makefile", "core", "report", "image",
+	"index", "letter", "notes", "Imakefile", "dtwm", "icon", "setup",
+	"archive", "thesis", "data", "a.out", "config", "mail"
+};
+
+static char *suffixes[] = {
+	"", "", "", ".c", ".h", ".C", ".o", ".a", ".so", ".txt", ".ps",
+	".pdf", ".gif", ".jpg", ".png", ".tif", ".xpm", ".bm", ".pm",
+	".html", ".tar", ".Z", ".gz", ".dt", ".sdl", ".sh", ".au", ".fp",
+	".dtwmrc", ".bak", ".1", ".mk"
+};
+
+static char *contents[] = {
+	"#!/bin/sh\necho hello\n",
+	"%!PS-Adobe-3.0\n%%Title: report\n",
+	"GIF89a\001\000\001\000",
+	"/* hello */\n#include <stdio.h>\n",
+	"From user Mon Jan  1 00:00:00 1996\n",
+	"<html><head><title>x</title></head>\n",
+	"just some text\n",
+	"\177ELF\002\001\001\000\000\000"
+};
+
+#define NUMBER(a)	(sizeof(a) / sizeof(a[0]))
+
+typedef struct {
+	char		*type;
+	int		count;
+} type_count_t;
+
+static type_count_t	types[MAX_TYPES];
+static int		num_types;
+
+
+/***********************  Startup Routine ****************************/
+static void
+startup(int argc, char **argv)
+{
+	Widget          toplevel;
+
+	toplevel = XtInitialize(argv[0], "Dtdtsbench", NULL, 0,
+		(int *) &argc, argv);
+
+	if( DtInitialize(XtDisplay(toplevel), toplevel, argv[0],
+			  "Dt_TYPE") == False)
+	{
+		printf(" couldn't initialize everything\n");
+		exit(1);
+	}
+
+	DtDtsLoadDataTypes();
+}
+
+
+
+/***********************  Cleanup Routine ****************************/
+static void
+cleanup()
+{
+	DtDtsRelease();
+}
+
+
+static void
+count_type(char *datatype)
+{
+	int	i;
+
+	for(i = 0; i < num_types; i++)
+	{
+		if(strcmp(types[i].type, datatype) == 0)
+		{
+			types[i].count++;
+			return;
+		}
+	}
+	if(num_types < MAX_TYPES)
+	{
+		types[num_types].type = strdup(datatype);
+		types[num_types].count = 1;
+		num_types++;
+	}
+}
+
+
+static int
+compare_counts(const void *a, const void *b)
+{
+	const type_count_t	*ta = (const type_count_t *)a;
+	const type_count_t	*tb = (const type_count_t *)b;
+
+	if(ta->count != tb->count)
+	{
+		return(tb->count - ta->count);
+	}
+	return(strcmp(ta->type, tb->type));
+}
+
+
+int
+main(int argc, char **argv)
+{
+	int		count = 1000000;
+	unsigned int	seed = 1;
+	char		**paths;
+	int		*content;
+	struct stat	*stats;
+	char		path[MAXPATHLEN];
+	char		*datatype;
+	struct timeval	start, stop;
+	double		secs;
+	int		i;
+
+	startup(argc, argv);
+
+	if(argc > 1)
+	{
+		count = atoi(argv[1]);
+	}
+	if(argc > 2)
+	{
+		seed = atoi(argv[2]);
+	}
+	if(count <= 0)
+	{
+		printf("Usage: dtsbench [ count [ seed ] ]\n");
+		exit(1);
+	}
+
+	/* make up the paths up front, so that only typing is timed */
+	srand(seed);
+	paths = (char **)malloc(count * sizeof(char *));
+	content = (int *)malloc(count * sizeof(int));
+	stats = (struct stat *)calloc(count, sizeof(struct stat));
+	for(i = 0; i < count; i++)
+	{
+		sprintf(path, "%s/%s%s%s",
+			dirs[rand() % NUMBER(dirs)],
+			names[rand() % NUMBER(names)],
+			rand() % 4 ? "" : "_old",
+			suffixes[rand() % NUMBER(suffixes)]);
+		paths[i] = strdup(path);
+		content[i] = rand() % NUMBER(contents);
+
+		switch(rand() % 10)
+		{
+		case 0:
+			stats[i].st_mode = S_IFDIR | 0755;
+			break;
+		case 1:
+			stats[i].st_mode = S_IFREG | 0755;
+			break;
+		default:
+			stats[i].st_mode = S_IFREG | 0644;
+			break;
+		}
+		stats[i].st_nlink = 1;
+		stats[i].st_size = strlen(contents[content[i]]);
+	}
+
+	gettimeofday(&start, NULL);
+	for(i = 0; i < count; i++)
+	{
+		datatype = DtDtsDataToDataType(paths[i],
+				contents[content[i]],
+				strlen(contents[content[i]]),
+				&stats[i], NULL, NULL, NULL);
+		count_type(datatype ? datatype : "unknown");
+		DtDtsFreeDataType(datatype);
+	}
+	gettimeofday(&stop, NULL);
+
+	secs = (stop.tv_sec - start.tv_sec) +
+		(stop.tv_usec - start.tv_usec) / 1000000.0;
+
+	printf("%d paths typed in %.2f seconds", count, secs);
+	if(secs > 0)
+	{
+		printf(", %.0f paths/second", count / secs);
+	}
+	printf("\n\n");
+
+	qsort(types, num_types, sizeof(type_count_t), compare_counts);
+	printf("%-30s\t%s\n", "DataType", "Count");
+	printf("%-30s\t%s\n", "--------", "-----");
+	for(i = 0; i < num_types; i++)
+	{
+		printf("%-30s\t%d\n", types[i].type, types[i].count);
+	}
+
+	cleanup();
+
+	exit(0);
+}